@@ -0,0 +1,458 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ssf_bench.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ *
+ * End-to-end benchmark of the controllers synchronization loop, running against
+ * an emulated servo bus (no hardware needed).
+ * For each protocol, servo count and sync frequency, report the achieved loop
+ * frequency, the per-cycle duration percentiles, the bus utilization and the
+ * CPU time used per cycle.
+ *
+ * With '-scan', autodetect a protocol v2 bus whose IDs are spread apart instead:
+ * devices answering a broadcast 'Ping' in ID order, a gap of missing IDs must
+ * not end the scan early. The whole ID range is scanned, then only the IDs up
+ * to the highest one.
+ *
+ * Usage: ssf_bench [-protocol dxl1|dxl2|hkx|all] [-servos N] [-freqs 30,60,120]
+ *                  [-duration seconds] [-baud bps] [-rdelay microseconds] [-scan]
+ */
+
+// SmartServoFramework
+#include "../src/DynamixelController.h"
+#include "../src/HerkuleXController.h"
+#include "../src/SerialPortVirtual.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* ************************************************************************** */
+
+struct BenchConfig
+{
+    std::vector <int> protocols = { PROTOCOL_DXLv1, PROTOCOL_DXLv2, PROTOCOL_HKX };
+    std::vector <int> frequencies = { 30, 60, 120 };
+    int servos = 8;
+    double duration = 2.0;      //!< Duration of each run, in seconds.
+    int baudrate = 1000000;
+    int returnDelay = 0;        //!< In microseconds, -1 to use the servos 'return delay' registers.
+    bool scan = false;          //!< Run the autodetection benchmark instead.
+};
+
+struct BenchResult
+{
+    double frequency = 0.0;     //!< Achieved loop frequency (Hz).
+    double p50 = 0.0;           //!< Cycle duration percentiles (ms).
+    double p90 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+    double busUsage = 0.0;      //!< Bus utilization (%).
+    double cpuPerCycle = 0.0;   //!< CPU time used by the controller thread per cycle (µs).
+    int errors = 0;
+};
+
+/*!
+ * \brief Samples collected from the controller's thread, through its sync loop callback.
+ */
+struct CycleSamples
+{
+    std::mutex lock;
+    bool recording = false;
+    std::vector <double> durations;
+    std::vector <double> cpuTimes;
+    std::chrono::steady_clock::time_point first, last;
+    double lastCpu = -1.0;
+};
+
+/* ************************************************************************** */
+
+//! CPU time used by the calling thread, in microseconds.
+static double threadCpuTime()
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000000.0 + static_cast<double>(ts.tv_nsec) / 1000.0;
+#else
+    return static_cast<double>(std::clock()) * 1000000.0 / static_cast<double>(CLOCKS_PER_SEC);
+#endif
+}
+
+static double percentile(const std::vector <double> &sorted, const double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+
+    size_t index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static const char *protocolName(const int protocol)
+{
+    if (protocol == PROTOCOL_DXLv2)
+        return "dxl2";
+    else if (protocol == PROTOCOL_HKX)
+        return "hkx";
+
+    return "dxl1";
+}
+
+/* ************************************************************************** */
+
+static BenchResult runBench(const BenchConfig &cfg, const int protocol, const int servoCount, const int frequency)
+{
+    BenchResult result;
+
+    static int busIndex = 0;
+    std::string busName = "ssf_bench_" + std::to_string(busIndex++);
+    std::string devicePath = VIRTUAL_PORT_PREFIX + busName;
+
+    // Populate the emulated bus
+    std::shared_ptr <VirtualServoBus> bus = VirtualServoBus::getBus(busName);
+    std::vector <Servo *> servos;
+
+    for (int id = 1; id <= servoCount; id++)
+    {
+        if (protocol == PROTOCOL_DXLv1)
+        {
+            bus->addDynamixel(id, 0x000C, PROTOCOL_DXLv1); // AX-12A
+            servos.push_back(new ServoAX(id, 0x000C));
+        }
+        else if (protocol == PROTOCOL_DXLv2)
+        {
+            bus->addDynamixel(id, 0x015E, PROTOCOL_DXLv2); // XL-320
+            servos.push_back(new ServoXL(id, 0x015E));
+        }
+        else
+        {
+            bus->addHerkuleX(id, 0x0101); // DRS-0101
+            servos.push_back(new ServoDRS(id, 0x0101));
+        }
+    }
+
+    // Set after the servos are added, so their 'return delay time' registers match
+    bus->setReturnDelay(cfg.returnDelay);
+
+    ControllerAPI *ctrl = nullptr;
+    if (protocol == PROTOCOL_HKX)
+    {
+        ctrl = new HerkuleXController(frequency);
+    }
+    else
+    {
+        ctrl = new DynamixelController(frequency, (protocol == PROTOCOL_DXLv2) ? SERVO_XL : SERVO_AX);
+    }
+
+    CycleSamples samples;
+    samples.durations.reserve(static_cast<size_t>(frequency * cfg.duration * 2.0) + 16);
+    samples.cpuTimes.reserve(samples.durations.capacity());
+
+    ctrl->setSyncLoopCallback([&samples](double duration_ms)
+    {
+        double cpu = threadCpuTime();
+        std::lock_guard <std::mutex> lock(samples.lock);
+
+        if (samples.recording)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (samples.durations.empty())
+            {
+                samples.first = now;
+            }
+            samples.last = now;
+
+            samples.durations.push_back(duration_ms);
+            if (samples.lastCpu >= 0.0)
+            {
+                samples.cpuTimes.push_back(cpu - samples.lastCpu);
+            }
+        }
+        samples.lastCpu = cpu;
+    });
+
+    if (ctrl->connect(devicePath, cfg.baudrate) == 1)
+    {
+        for (auto s: servos)
+        {
+            ctrl->registerServo(s);
+        }
+        ctrl->waitUntilReady();
+
+        // Warm up, then record
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        ctrl->clearErrorCount();
+        bus->resetTraffic();
+        {
+            std::lock_guard <std::mutex> lock(samples.lock);
+            samples.recording = true;
+        }
+        auto start = std::chrono::steady_clock::now();
+        auto stop = start + std::chrono::microseconds(static_cast<long long>(cfg.duration * 1000000.0));
+
+        // Keep the servos moving, so every cycle has something to commit
+        int step = 0;
+        while (std::chrono::steady_clock::now() < stop)
+        {
+            for (auto s: servos)
+            {
+                s->setGoalPosition((step % 2) ? 400 : 600);
+            }
+            step++;
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        {
+            std::lock_guard <std::mutex> lock(samples.lock);
+            samples.recording = false;
+        }
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        unsigned long long hostBytes = 0, deviceBytes = 0;
+        bus->getTraffic(hostBytes, deviceBytes);
+        result.errors = ctrl->getErrorCount();
+
+        ctrl->disconnect();
+
+        // Results
+        std::vector <double> d = samples.durations;
+        std::sort(d.begin(), d.end());
+
+        if (d.size() > 1)
+        {
+            double span = std::chrono::duration<double>(samples.last - samples.first).count();
+            result.frequency = (span > 0.0) ? static_cast<double>(d.size() - 1) / span : 0.0;
+        }
+        result.p50 = percentile(d, 0.50);
+        result.p90 = percentile(d, 0.90);
+        result.p99 = percentile(d, 0.99);
+        result.max = d.empty() ? 0.0 : d.back();
+
+        // 10 bits per byte (start bit + 8 data bits + stop bit)
+        double byteTime = 10000.0 / static_cast<double>(cfg.baudrate);
+        result.busUsage = (elapsed > 0.0) ? static_cast<double>(hostBytes + deviceBytes) * byteTime / elapsed * 100.0 : 0.0;
+
+        if (samples.cpuTimes.empty() == false)
+        {
+            double total = 0.0;
+            for (double c: samples.cpuTimes)
+            {
+                total += c;
+            }
+            result.cpuPerCycle = total / static_cast<double>(samples.cpuTimes.size());
+        }
+    }
+    else
+    {
+        fprintf(stderr, "> Unable to connect to '%s'\n", devicePath.c_str());
+    }
+
+    // Registered servos are deleted by the controller
+    delete ctrl;
+    VirtualServoBus::removeBus(busName);
+
+    return result;
+}
+
+/*!
+ * \brief Autodetect a protocol v2 bus with IDs spread apart (1, 20, 39...).
+ * \return true if every device has been found.
+ *
+ * The bus is scanned twice: over the whole [0;252] range, then only up to the
+ * highest ID. The scan waits for the slot of every ID up to 'stop', so its
+ * duration depends on the range more than on the number of devices.
+ */
+static bool runScan(const BenchConfig &cfg)
+{
+    const int idGap = 19;
+    std::string busName = "ssf_bench_scan";
+    std::string devicePath = VIRTUAL_PORT_PREFIX + busName;
+
+    std::shared_ptr <VirtualServoBus> bus = VirtualServoBus::getBus(busName);
+
+    int expected = 0;
+    int lastId = 0;
+    for (int id = 1; id < 253 && expected < cfg.servos; id += idGap)
+    {
+        bus->addDynamixel(id, 0x015E, PROTOCOL_DXLv2); // XL-320
+        expected++;
+        lastId = id;
+    }
+    bus->setReturnDelay(cfg.returnDelay);
+
+    bool status = true;
+    const int stops[] = { 252, lastId };
+
+    for (int stop: stops)
+    {
+        DynamixelController ctrl(30, SERVO_XL);
+        int found = 0;
+        double elapsed = 0.0;
+
+        if (ctrl.connect(devicePath, cfg.baudrate) == 1)
+        {
+            auto start = std::chrono::steady_clock::now();
+            ctrl.autodetect(0, stop);
+            ctrl.waitUntilReady();
+            elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            found = static_cast<int>(ctrl.getServos().size());
+            ctrl.disconnect();
+        }
+        else
+        {
+            fprintf(stderr, "> Unable to connect to '%s'\n", devicePath.c_str());
+        }
+
+        printf("scan [0;%i]: %i/%i device(s) found (IDs 1, %i, %i...) in %.1f ms\n", stop, found, expected, 1 + idGap, 1 + 2*idGap, elapsed);
+        status &= (found == expected);
+    }
+
+    VirtualServoBus::removeBus(busName);
+
+    return status;
+}
+
+/* ************************************************************************** */
+
+static std::vector <int> parseList(const char *arg)
+{
+    std::vector <int> values;
+    std::string list(arg);
+    size_t pos = 0;
+
+    while (pos < list.size())
+    {
+        size_t next = list.find(',', pos);
+        if (next == std::string::npos)
+        {
+            next = list.size();
+        }
+
+        int v = std::atoi(list.substr(pos, next - pos).c_str());
+        if (v > 0)
+        {
+            values.push_back(v);
+        }
+        pos = next + 1;
+    }
+
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    BenchConfig cfg;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "-protocol") == 0 && hasValue)
+        {
+            std::string p = argv[++i];
+
+            if (p == "dxl1")
+                cfg.protocols = { PROTOCOL_DXLv1 };
+            else if (p == "dxl2")
+                cfg.protocols = { PROTOCOL_DXLv2 };
+            else if (p == "hkx")
+                cfg.protocols = { PROTOCOL_HKX };
+        }
+        else if (strcmp(argv[i], "-servos") == 0 && hasValue)
+        {
+            cfg.servos = std::max(1, std::min(std::atoi(argv[++i]), 253));
+        }
+        else if (strcmp(argv[i], "-freqs") == 0 && hasValue)
+        {
+            cfg.frequencies = parseList(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-duration") == 0 && hasValue)
+        {
+            cfg.duration = std::max(0.1, std::atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-baud") == 0 && hasValue)
+        {
+            cfg.baudrate = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-rdelay") == 0 && hasValue)
+        {
+            cfg.returnDelay = std::atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-scan") == 0)
+        {
+            cfg.scan = true;
+        }
+        else
+        {
+            printf("Usage: %s [-protocol dxl1|dxl2|hkx|all] [-servos N] [-freqs 30,60,120] [-duration seconds] [-baud bps] [-rdelay microseconds] [-scan]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (cfg.scan)
+    {
+        return runScan(cfg) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // 1, 2, 4... servos, up to the requested count
+    std::vector <int> servoCounts;
+    for (int n = 1; n < cfg.servos; n *= 2)
+    {
+        servoCounts.push_back(n);
+    }
+    servoCounts.push_back(cfg.servos);
+
+    printf("%-5s %6s %6s %9s %8s %8s %8s %8s %7s %9s %6s\n",
+           "proto", "servos", "target", "freq(Hz)", "p50(ms)", "p90(ms)", "p99(ms)", "max(ms)", "bus(%)", "cpu(us)", "errors");
+
+    for (int protocol: cfg.protocols)
+    {
+        for (int n: servoCounts)
+        {
+            for (int f: cfg.frequencies)
+            {
+                BenchResult r = runBench(cfg, protocol, n, f);
+
+                printf("%-5s %6i %6i %9.1f %8.3f %8.3f %8.3f %8.3f %7.1f %9.1f %6i\n",
+                       protocolName(protocol), n, f, r.frequency, r.p50, r.p90, r.p99, r.max, r.busUsage, r.cpuPerCycle, r.errors);
+                fflush(stdout);
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
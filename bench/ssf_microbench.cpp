@@ -0,0 +1,293 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ssf_microbench.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ *
+ * Micro-benchmarks of the pure-CPU hot paths of the framework: packet checksums,
+ * packet header search, control table lookups and servo register accessors
+ * (by register name and by register handle).
+ * No serial device is needed. For each case, report the time per operation and
+ * the number of heap allocations per operation.
+ *
+ * Usage: ssf_microbench [-filter name] [-time seconds]
+ */
+
+// SmartServoFramework
+#include "../src/Dynamixel.h"
+#include "../src/HerkuleX.h"
+#include "../src/ServoAX.h"
+#include "../src/ServoXL.h"
+
+// C++ standard libraries
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+/* ************************************************************************** */
+
+// Count every heap allocation made by the process (library included)
+static std::atomic <unsigned long long> allocationCount(0);
+
+void *operator new(std::size_t size)
+{
+    allocationCount++;
+    void *ptr = std::malloc(size ? size : 1);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Give access to the protected Dynamixel packet methods, without opening any serial link.
+ */
+class DynamixelBench: public Dynamixel
+{
+public:
+    DynamixelBench(const int protocol) { protocolVersion = protocol; }
+    ~DynamixelBench() {}
+
+    using Dynamixel::dxl1_checksum_packet;
+    using Dynamixel::dxl2_checksum_packet;
+    using Dynamixel::dxl_find_header;
+};
+
+/*!
+ * \brief Give access to the protected HerkuleX packet methods, without opening any serial link.
+ */
+class HerkuleXBench: public HerkuleX
+{
+public:
+    HerkuleXBench() {}
+    ~HerkuleXBench() {}
+
+    using HerkuleX::hkx_checksum_packet;
+};
+
+/* ************************************************************************** */
+
+struct BenchConfig
+{
+    std::string filter;         //!< Only run the cases which name contains this string.
+    double time = 0.25;         //!< Minimum duration of each case, in seconds.
+};
+
+//! Keep the compiler from optimizing the benchmarked code away.
+static volatile int sink = 0;
+
+/*!
+ * \brief Run a benchmark case, then print its results.
+ * \param cfg: Benchmark configuration.
+ * \param name: Name of the case.
+ * \param op: The operation to measure. Gets the iteration index, returns a value to be sunk.
+ *
+ * The number of iterations is doubled until the run lasts at least cfg.time seconds.
+ */
+template <typename Op>
+static void runCase(const BenchConfig &cfg, const char *name, Op op)
+{
+    if (!cfg.filter.empty() && std::string(name).find(cfg.filter) == std::string::npos)
+    {
+        return;
+    }
+
+    // Warmup
+    int acc = 0;
+    for (int i = 0; i < 1000; i++)
+    {
+        acc += op(i);
+    }
+
+    long iterations = 1000;
+    double elapsed = 0.0;
+    unsigned long long allocations = 0;
+
+    for (;;)
+    {
+        unsigned long long allocStart = allocationCount.load();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        for (long i = 0; i < iterations; i++)
+        {
+            acc += op(static_cast<int>(i));
+        }
+
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        allocations = allocationCount.load() - allocStart;
+        elapsed = std::chrono::duration<double>(end - start).count();
+
+        if (elapsed >= cfg.time || iterations >= (1L << 40))
+        {
+            break;
+        }
+        iterations *= 2;
+    }
+
+    sink = acc;
+
+    printf("%-40s %12ld %10.2f %10.3f\n", name, iterations,
+           elapsed * 1000000000.0 / static_cast<double>(iterations),
+           static_cast<double>(allocations) / static_cast<double>(iterations));
+}
+
+/* ************************************************************************** */
+
+int main(int argc, char *argv[])
+{
+    BenchConfig cfg;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "-filter") == 0 && hasValue)
+        {
+            cfg.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "-time") == 0 && hasValue)
+        {
+            cfg.time = std::max(0.001, std::atof(argv[++i]));
+        }
+        else
+        {
+            printf("Usage: %s [-filter name] [-time seconds]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%-40s %12s %10s %10s\n", "case", "iterations", "ns/op", "allocs/op");
+
+    // Checksums
+    ////////////////////////////////////////////////////////////////////////////
+
+    DynamixelBench dxl1(PROTOCOL_DXLv1);
+    DynamixelBench dxl2(PROTOCOL_DXLv2);
+    HerkuleXBench hkx;
+
+    unsigned char packet[MAX_PACKET_LENGTH_hkx];
+    for (int i = 0; i < MAX_PACKET_LENGTH_hkx; i++)
+    {
+        packet[i] = static_cast<unsigned char>(i * 7 + 3);
+    }
+
+    // 'Write word' instruction: 9 bytes (length field 5) with protocol v1, 12 bytes with protocol v2
+    runCase(cfg, "dxl1_checksum_packet/9B", [&](int i) { packet[5] = i; return dxl1.dxl1_checksum_packet(packet, 5); });
+    runCase(cfg, "dxl1_checksum_packet/150B", [&](int i) { packet[5] = i; return dxl1.dxl1_checksum_packet(packet, MAX_PACKET_LENGTH_dxlv1 - 4); });
+    runCase(cfg, "dxl2_checksum_packet/12B", [&](int i) { packet[8] = i; return dxl2.dxl2_checksum_packet(packet, 12); });
+    runCase(cfg, "dxl2_checksum_packet/150B", [&](int i) { packet[8] = i; return dxl2.dxl2_checksum_packet(packet, MAX_PACKET_LENGTH_dxlv1); });
+    runCase(cfg, "hkx_checksum_packet/9B", [&](int i) { packet[7] = i; return hkx.hkx_checksum_packet(packet, 9); });
+    runCase(cfg, "hkx_checksum_packet/233B", [&](int i) { packet[7] = i; return hkx.hkx_checksum_packet(packet, MAX_PACKET_LENGTH_hkx); });
+
+    // Packet header search
+    ////////////////////////////////////////////////////////////////////////////
+
+    const unsigned char dxl1_status[] = { 0xFF, 0xFF, 0x01, 0x04, 0x00, 0x00, 0x02, 0xF8 };
+    const unsigned char dxl2_status[] = { 0xFF, 0xFF, 0xFD, 0x00, 0x01, 0x06, 0x00, 0x55, 0x00, 0x00, 0x02, 0x00, 0x00 };
+    unsigned char rx1[MAX_PACKET_LENGTH_dxlv1] = {0};
+    unsigned char rx2[MAX_PACKET_LENGTH_dxlv1] = {0};
+
+    memcpy(rx1, dxl1_status, sizeof(dxl1_status));
+    memcpy(rx2, dxl2_status, sizeof(dxl2_status));
+    runCase(cfg, "dxl_find_header/v1/aligned", [&](int) { return dxl1.dxl_find_header(rx1, sizeof(dxl1_status)); });
+    runCase(cfg, "dxl_find_header/v2/aligned", [&](int) { return dxl2.dxl_find_header(rx2, sizeof(dxl2_status)); });
+
+    // Status packet preceded by 32 bytes of line noise (with some false header starts)
+    const int noise = 32;
+    for (int i = 0; i < noise; i++)
+    {
+        rx1[i] = rx2[i] = (i % 5 == 0) ? 0xFF : static_cast<unsigned char>(i);
+    }
+    memcpy(rx1 + noise, dxl1_status, sizeof(dxl1_status));
+    memcpy(rx2 + noise, dxl2_status, sizeof(dxl2_status));
+    runCase(cfg, "dxl_find_header/v1/32B_noise", [&](int) { return dxl1.dxl_find_header(rx1, noise + sizeof(dxl1_status)); });
+    runCase(cfg, "dxl_find_header/v2/32B_noise", [&](int) { return dxl2.dxl_find_header(rx2, noise + sizeof(dxl2_status)); });
+
+    // Control table lookups
+    ////////////////////////////////////////////////////////////////////////////
+
+    const int (*ct_ax)[8] = getRegisterTable(SERVO_AX, SERVO_AX12A);
+    const int (*ct_x)[8] = getRegisterTable(SERVO_X, SERVO_XM430_W350);
+    RegisterInfos infos;
+
+    runCase(cfg, "getRegisterInfos/AX/first", [&](int) { return getRegisterInfos(ct_ax, REG_MODEL_NUMBER, infos); });
+    runCase(cfg, "getRegisterInfos/AX/goal_position", [&](int) { return getRegisterInfos(ct_ax, REG_GOAL_POSITION, infos); });
+    runCase(cfg, "getRegisterInfos/X/goal_position", [&](int) { return getRegisterInfos(ct_x, REG_GOAL_POSITION, infos); });
+    runCase(cfg, "getRegisterInfos/X/missing", [&](int) { return getRegisterInfos(ct_x, REG_MAX_TORQUE, infos); });
+    runCase(cfg, "getRegisterAddr/AX/goal_position", [&](int) { return getRegisterAddr(ct_ax, REG_GOAL_POSITION); });
+    runCase(cfg, "getRegisterAddr/X/goal_position", [&](int) { return getRegisterAddr(ct_x, REG_GOAL_POSITION); });
+    runCase(cfg, "getRegisterAddr/X/current_temp", [&](int) { return getRegisterAddr(ct_x, REG_CURRENT_TEMPERATURE); });
+
+    // Servo register accessors
+    ////////////////////////////////////////////////////////////////////////////
+
+    ServoAX ax(1, 0x000C);
+    ServoXL xl(1, 0x015E);
+
+    runCase(cfg, "Servo::setValue/AX/goal_position", [&](int i) { ax.setValue(REG_GOAL_POSITION, i & 0x3FF); return 0; });
+    runCase(cfg, "Servo::updateValue/AX/current_position", [&](int i) { ax.updateValue(REG_CURRENT_POSITION, i & 0x3FF); return 0; });
+    runCase(cfg, "Servo::getValue/AX/current_position", [&](int) { return ax.getValue(REG_CURRENT_POSITION); });
+    runCase(cfg, "Servo::setValue/XL/goal_position", [&](int i) { xl.setValue(REG_GOAL_POSITION, i & 0x3FF); return 0; });
+    runCase(cfg, "Servo::updateValue/XL/current_position", [&](int i) { xl.updateValue(REG_CURRENT_POSITION, i & 0x3FF); return 0; });
+
+    RegisterHandle goal = ax.handle(REG_GOAL_POSITION);
+    RegisterHandle current = ax.handle(REG_CURRENT_POSITION);
+
+    runCase(cfg, "Servo::set/AX/goal_position", [&](int i) { ax.set(goal, i & 0x3FF); return 0; });
+    runCase(cfg, "Servo::get/AX/current_position", [&](int) { return ax.get(current); });
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,554 @@
+/*!
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 INRIA
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * \file ssf_reactorbench.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ *
+ * Drive several serial ports from one SerialPortReactor thread.
+ * Each port is a pseudo terminal, with a device thread answering Dynamixel
+ * 'Ping' instructions on the other side after a fixed response time.
+ * Report the transaction rate with the ports used one after the other, then
+ * with all of them at once. Finally, hang up one port while a transaction is
+ * in flight, and check that its transactions fail with COMM_TXFAIL and that the
+ * reactor thread goes back to sleep.
+ *
+ * Then run one Dynamixel or HerkuleX controller in reactor mode per port, each
+ * one against an emulated servo bus, and report their loop frequency, errors,
+ * and the number of threads used by the process.
+ *
+ * Usage: ssf_reactorbench [-ports count] [-transactions count] [-delay usec]
+ *                         [-servos count] [-freq hz]
+ */
+
+// SmartServoFramework
+#include "../src/SerialPortReactor.h"
+#include "../src/SerialPortVirtual.h"
+#include "../src/DynamixelController.h"
+#include "../src/HerkuleXController.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Linux specifics
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+/* ************************************************************************** */
+
+struct BenchConfig
+{
+    int ports = 2;              //!< Number of serial ports driven by the reactor.
+    int transactions = 2000;    //!< Number of transactions per port.
+    int delay = 200;            //!< Response time of the emulated devices, in microseconds.
+    int servos = 4;             //!< Number of servos on each controller bus.
+    int frequency = 100;        //!< Controllers synchronization frequency.
+};
+
+/*!
+ * \brief One pseudo terminal: the serial port used by the reactor, and the emulated device on the master side.
+ */
+struct BenchPort
+{
+    int master = -1;
+    std::string path;
+    std::unique_ptr <SerialPortLinux> port;
+    std::thread device;
+    std::atomic <bool> mute;    //!< Stop answering (the device is about to be unplugged).
+    std::atomic <bool> stop;    //!< Stop the device thread.
+
+    BenchPort(): mute(false), stop(false) {}
+};
+
+//! Dynamixel (protocol v1) 'Ping' instruction, and its status packet.
+static const unsigned char pingPacket[] = { 0xFF, 0xFF, 0x01, 0x02, 0x01, 0xFB };
+static const unsigned char statusPacket[] = { 0xFF, 0xFF, 0x01, 0x02, 0x00, 0xFC };
+
+/*!
+ * \brief Emulated device: answer every 'Ping' instruction after 'delay' microseconds.
+ */
+static void deviceThread(BenchPort *bp, const int delay)
+{
+    unsigned char buffer[64];
+    int received = 0;
+
+    while (bp->stop == false)
+    {
+        struct pollfd pfd = { bp->master, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0)
+        {
+            continue;
+        }
+
+        int n = read(bp->master, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            return;
+        }
+
+        received += n;
+        while (received >= static_cast<int>(sizeof(pingPacket)))
+        {
+            received -= sizeof(pingPacket);
+
+            if (bp->mute == false)
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds(delay));
+                if (write(bp->master, statusPacket, sizeof(statusPacket)) < 0)
+                {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+static bool openPort(BenchPort &bp, const int delay)
+{
+    bp.master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (bp.master < 0 || grantpt(bp.master) != 0 || unlockpt(bp.master) != 0)
+    {
+        printf("Unable to create a pseudo terminal\n");
+        return false;
+    }
+
+    bp.path = ptsname(bp.master);
+    bp.port.reset(new SerialPortLinux(bp.path, 1000000));
+    if (bp.port->openLink() != 1)
+    {
+        printf("Unable to open '%s'\n", bp.path.c_str());
+        return false;
+    }
+
+    bp.device = std::thread(deviceThread, &bp, delay);
+    return true;
+}
+
+/*!
+ * \brief Emulated servo bus: answer the instructions read on the master side of a pseudo terminal.
+ */
+static void busThread(BenchPort *bp, std::shared_ptr <VirtualServoBus> bus)
+{
+    unsigned char buffer[256];
+    std::vector <std::pair <int, std::vector <unsigned char> > > replies;
+
+    while (bp->stop == false)
+    {
+        struct pollfd pfd = { bp->master, POLLIN, 0 };
+        if (poll(&pfd, 1, 10) <= 0)
+        {
+            continue;
+        }
+
+        int n = read(bp->master, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            return;
+        }
+
+        replies.clear();
+        bus->process(buffer, n, replies);
+
+        for (const auto &r: replies)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(r.first));
+            if (write(bp->master, &r.second[0], r.second.size()) < 0)
+            {
+                return;
+            }
+        }
+    }
+}
+
+static int threadCount()
+{
+    int count = 0;
+    DIR *dir = opendir("/proc/self/task");
+    if (dir)
+    {
+        while (struct dirent *e = readdir(dir))
+        {
+            count += (e->d_name[0] != '.');
+        }
+        closedir(dir);
+    }
+    return count;
+}
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Chain 'count' transactions on each port, each one submitted by the callback of the previous one.
+ * \return Elapsed time in milliseconds, or a negative value if a transaction failed.
+ */
+static double runTransactions(SerialPortReactor &reactor, std::vector <BenchPort *> &ports, const int count)
+{
+    std::mutex m;
+    std::condition_variable cv;
+    int running = static_cast<int>(ports.size());
+    std::atomic <int> failures(0);
+
+    std::vector <int> remaining(ports.size(), count);
+    std::vector < std::function <void (int, const std::vector <unsigned char> &)> > callbacks(ports.size());
+
+    SerialTransaction t;
+    t.request.assign(pingPacket, pingPacket + sizeof(pingPacket));
+    t.responseLength = sizeof(statusPacket);
+    t.timeout = 100.0;
+
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        callbacks[i] = [&, i, t](int status, const std::vector <unsigned char> &) mutable {
+            if (status != COMM_RXSUCCESS)
+            {
+                failures++;
+            }
+
+            if (--remaining[i] > 0)
+            {
+                t.callback = callbacks[i];
+                reactor.submit(ports[i]->port.get(), t);
+            }
+            else
+            {
+                std::lock_guard <std::mutex> lock(m);
+                running--;
+                cv.notify_all();
+            }
+        };
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        t.callback = callbacks[i];
+        reactor.submit(ports[i]->port.get(), t);
+    }
+
+    {
+        std::unique_lock <std::mutex> lock(m);
+        cv.wait(lock, [&] { return running == 0; });
+    }
+
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return (failures > 0) ? -1.0 : elapsed;
+}
+
+/* ************************************************************************** */
+
+int main(int argc, char *argv[])
+{
+    BenchConfig cfg;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool hasValue = (i + 1 < argc);
+
+        if (strcmp(argv[i], "-ports") == 0 && hasValue)
+        {
+            cfg.ports = std::max(2, std::atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-transactions") == 0 && hasValue)
+        {
+            cfg.transactions = std::max(1, std::atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-delay") == 0 && hasValue)
+        {
+            cfg.delay = std::max(0, std::atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-servos") == 0 && hasValue)
+        {
+            cfg.servos = std::max(1, std::min(std::atoi(argv[++i]), 253));
+        }
+        else if (strcmp(argv[i], "-freq") == 0 && hasValue)
+        {
+            cfg.frequency = std::max(1, std::min(std::atoi(argv[++i]), 1000));
+        }
+        else
+        {
+            printf("Usage: %s [-ports count] [-transactions count] [-delay usec] [-servos count] [-freq hz]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector <BenchPort> ports(cfg.ports);
+    SerialPortReactor reactor;
+
+    for (auto &bp: ports)
+    {
+        if (openPort(bp, cfg.delay) == false || reactor.addPort(bp.port.get()) == false)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (reactor.start() == false)
+    {
+        return EXIT_FAILURE;
+    }
+
+    int status = EXIT_SUCCESS;
+
+    // One port at a time, then every port at once
+    ////////////////////////////////////////////////////////////////////////////
+
+    double sequential = 0.0;
+    for (auto &bp: ports)
+    {
+        std::vector <BenchPort *> one(1, &bp);
+        double ms = runTransactions(reactor, one, cfg.transactions);
+        if (ms < 0.0)
+        {
+            printf("sequential: transactions failed on '%s'\n", bp.path.c_str());
+            status = EXIT_FAILURE;
+        }
+        sequential += ms;
+    }
+
+    std::vector <BenchPort *> all;
+    for (auto &bp: ports)
+    {
+        all.push_back(&bp);
+    }
+
+    double concurrent = runTransactions(reactor, all, cfg.transactions);
+    if (concurrent < 0.0)
+    {
+        printf("concurrent: transactions failed\n");
+        status = EXIT_FAILURE;
+    }
+
+    double total = static_cast<double>(cfg.transactions) * cfg.ports;
+    printf("%i port(s), %i transaction(s) per port, %i us response time\n", cfg.ports, cfg.transactions, cfg.delay);
+    printf("sequential: %9.1f ms %10.0f transactions/s\n", sequential, total * 1000.0 / sequential);
+    printf("concurrent: %9.1f ms %10.0f transactions/s (x%.2f)\n", concurrent, total * 1000.0 / concurrent, sequential / concurrent);
+
+    // Hang up the first port while a transaction waits for its response
+    ////////////////////////////////////////////////////////////////////////////
+
+    BenchPort &gone = ports[0];
+    std::mutex m;
+    std::condition_variable cv;
+    std::vector <int> statuses;
+
+    SerialTransaction t;
+    t.request.assign(pingPacket, pingPacket + sizeof(pingPacket));
+    t.responseLength = sizeof(statusPacket);
+    t.timeout = 5000.0;
+    t.callback = [&](int s, const std::vector <unsigned char> &) {
+        std::lock_guard <std::mutex> lock(m);
+        statuses.push_back(s);
+        cv.notify_all();
+    };
+
+    gone.mute = true;
+    reactor.submit(gone.port.get(), t);
+    reactor.submit(gone.port.get(), t);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    gone.stop = true;
+    gone.device.join();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    close(gone.master);
+    gone.master = -1;
+
+    bool failed = false;
+    {
+        std::unique_lock <std::mutex> lock(m);
+        failed = cv.wait_for(lock, std::chrono::milliseconds(1000), [&] { return statuses.size() == 2; });
+    }
+    double hangup = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    for (auto s: statuses)
+    {
+        failed &= (s == COMM_TXFAIL);
+    }
+
+    // The other threads are idle, so the process CPU time is the reactor's
+    std::clock_t cpuStart = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    double cpu = static_cast<double>(std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC / 200.0 * 100.0;
+
+    printf("hang up:    %9.1f ms to fail %zu transaction(s) with COMM_TXFAIL, then %.0f%% CPU\n", hangup, statuses.size(), cpu);
+
+    if (failed == false || cpu > 20.0)
+    {
+        printf("hang up:    the transactions of the hung up port were not cancelled properly\n");
+        status = EXIT_FAILURE;
+    }
+
+    reactor.stop();
+
+    for (auto &bp: ports)
+    {
+        reactor.removePort(bp.port.get());
+        bp.port->closeLink();
+
+        if (bp.master >= 0)
+        {
+            bp.stop = true;
+            bp.device.join();
+            close(bp.master);
+        }
+    }
+
+    // One controller per port, every one of them in reactor mode
+    ////////////////////////////////////////////////////////////////////////////
+
+    std::vector <BenchPort> buses(cfg.ports);
+    std::vector <ControllerAPI *> controllers;
+    std::vector < std::vector <Servo *> > servos(cfg.ports);
+    std::vector < std::atomic <int> > cycles(cfg.ports);
+    int baseThreads = threadCount();
+
+    for (int i = 0; i < cfg.ports; i++)
+    {
+        BenchPort &bp = buses[i];
+        const bool hkx = (i % 2);
+
+        bp.master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (bp.master < 0 || grantpt(bp.master) != 0 || unlockpt(bp.master) != 0)
+        {
+            printf("Unable to create a pseudo terminal\n");
+            return EXIT_FAILURE;
+        }
+        bp.path = ptsname(bp.master);
+
+        std::string busName = "ssf_reactorbench_" + std::to_string(i);
+        std::shared_ptr <VirtualServoBus> bus = VirtualServoBus::getBus(busName);
+        for (int id = 1; id <= cfg.servos; id++)
+        {
+            if (hkx)
+            {
+                bus->addHerkuleX(id, 0x0101); // DRS-0101
+                servos[i].push_back(new ServoDRS(id, 0x0101));
+            }
+            else
+            {
+                bus->addDynamixel(id, 0x000C, PROTOCOL_DXLv1); // AX-12A
+                servos[i].push_back(new ServoAX(id, 0x000C));
+            }
+        }
+        bus->setReturnDelay(cfg.delay);
+        bp.device = std::thread(busThread, &bp, bus);
+
+        ControllerAPI *ctrl = nullptr;
+        if (hkx)
+        {
+            ctrl = new HerkuleXController(cfg.frequency);
+        }
+        else
+        {
+            ctrl = new DynamixelController(cfg.frequency, SERVO_AX);
+        }
+        controllers.push_back(ctrl);
+
+        cycles[i] = 0;
+        std::atomic <int> *counter = &cycles[i];
+        ctrl->setSyncLoopCallback([counter](double) { (*counter)++; });
+        ctrl->setReactorMode(true);
+
+        if (ctrl->connect(bp.path, 1000000) != 1)
+        {
+            printf("controllers: unable to connect to '%s'\n", bp.path.c_str());
+            return EXIT_FAILURE;
+        }
+        for (auto s: servos[i])
+        {
+            ctrl->registerServo(s);
+        }
+    }
+
+    for (auto ctrl: controllers)
+    {
+        ctrl->waitUntilReady();
+        ctrl->clearErrorCount();
+    }
+
+    // Every controller shares the same I/O and worker threads
+    int threads = threadCount() - baseThreads - cfg.ports;
+
+    for (auto &c: cycles)
+    {
+        c = 0;
+    }
+
+    const int duration = 1000;
+    for (int step = 0; step < duration / 10; step++)
+    {
+        for (auto &list: servos)
+        {
+            for (auto s: list)
+            {
+                s->setGoalPosition((step % 2) ? 400 : 600);
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    printf("controllers: %i bus(es), %i servo(s) per bus, %i Hz, %i thread(s) besides the emulated buses\n",
+           cfg.ports, cfg.servos, cfg.frequency, threads);
+
+    for (int i = 0; i < cfg.ports; i++)
+    {
+        double frequency = cycles[i] * 1000.0 / duration;
+        int errors = controllers[i]->getErrorCount();
+
+        printf("  %s %-12s %7.1f Hz %5i error(s)\n", (i % 2) ? "hkx " : "dxl1", buses[i].path.c_str(), frequency, errors);
+
+        if (frequency < cfg.frequency * 0.9 || errors > 0)
+        {
+            status = EXIT_FAILURE;
+        }
+    }
+
+    for (int i = 0; i < cfg.ports; i++)
+    {
+        // Registered servos are deleted by the controller
+        controllers[i]->disconnect();
+        delete controllers[i];
+        VirtualServoBus::removeBus("ssf_reactorbench_" + std::to_string(i));
+
+        buses[i].stop = true;
+        buses[i].device.join();
+        close(buses[i].master);
+    }
+
+    return status;
+}
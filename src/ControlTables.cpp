@@ -27,6 +27,11 @@
 
 // C++ standard libraries
 #include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 const int (*getRegisterTable(const int servo_model))[8]
 {
@@ -171,81 +176,194 @@ const int (*getRegisterTable(const int servo_serie, const int servo_model))[8]
     return ct;
 }
 
-unsigned getRegisterCount(const int ct[][8])
+/* ************************************************************************** */
+
+//! Number of slots of the control table index cache. Each translation unit including the control tables gets its own copies, so there is more than one pointer per table.
+#define CONTROL_TABLE_INDEX_SLOTS   256
+
+static std::atomic <const ControlTableIndex *> ctIndexSlots[CONTROL_TABLE_INDEX_SLOTS];
+static std::vector < std::unique_ptr <ControlTableIndex> > ctIndexes; //!< Owns every index built
+static std::mutex ctIndexLock; //!< Protects ctIndexes and the slots writes
+
+static unsigned ctIndexHash(const int ct[][8])
 {
-    unsigned count = 0;
+    return static_cast<unsigned>((reinterpret_cast<uintptr_t>(ct) >> 4) % CONTROL_TABLE_INDEX_SLOTS);
+}
 
-    if (ct != nullptr)
+static const ControlTableIndex *ctIndexFind(const int ct[][8])
+{
+    unsigned h = ctIndexHash(ct);
+
+    for (unsigned i = 0; i < CONTROL_TABLE_INDEX_SLOTS; i++)
     {
-        // Register count // Horrible hack
-        for (unsigned i = 0; i < 64; i++)
+        const ControlTableIndex *cti = ctIndexSlots[(h + i) % CONTROL_TABLE_INDEX_SLOTS].load(std::memory_order_acquire);
+
+        if (cti == nullptr)
         {
-            if (ct[i][0] == 999)
+            break; // not indexed yet
+        }
+        else if (cti->ct == ct)
+        {
+            return cti;
+        }
+    }
+
+    return nullptr;
+}
+
+static ControlTableIndex *ctIndexBuild(const int ct[][8])
+{
+    ControlTableIndex *cti = new ControlTableIndex;
+    cti->ct = ct;
+    cti->reg_count = 0;
+
+    for (int i = 0; i < REGISTER_NAME_COUNT; i++)
+    {
+        cti->reg_index[i] = -1;
+    }
+
+    // Register count
+    for (unsigned i = 0; i < MAX_REGISTER_COUNT; i++)
+    {
+        if (ct[i][0] == 999)
+        {
+            TRACE_1(TABLES, "Control table size is: '%i'", i);
+            cti->reg_count = i;
+            break; // exit search loop
+        }
+    }
+
+    for (unsigned i = 0; i < cti->reg_count; i++)
+    {
+        RegisterInfos &infos = cti->reg_infos[i];
+
+        infos.reg_index = i;
+
+        int rom = ct[i][3];
+        int ram = ct[i][4];
+
+        if (rom != -1)
+            infos.reg_addr = rom;
+        else
+            infos.reg_addr = ram;
+
+        infos.reg_addr_rom = rom;
+        infos.reg_addr_ram = ram;
+        infos.reg_size = ct[i][1];
+        infos.reg_access_mode = ct[i][2];
+        infos.reg_value_def = ct[i][5];
+        infos.reg_value_min = ct[i][6];
+        infos.reg_value_max = ct[i][7];
+
+        // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
+        if (infos.reg_value_min < 0)
+        {
+            infos.reg_value_min = 0;
+        }
+        if (infos.reg_value_max < 0)
+        {
+            if (ct[i][1] < 5)
             {
-                TRACE_1(TABLES, "Control table size is: '%i'", i);
-                count = i;
-                break; // exit search loop
+                infos.reg_value_max = static_cast<int>(std::pow(2, infos.reg_size*8));
             }
+            else
+            {
+                infos.reg_value_max = 0xFFFFFFFF;
+            }
+        }
+
+        // Keep the first occurrence of a register name
+        int reg_name = ct[i][0];
+        if (reg_name >= 0 && reg_name < REGISTER_NAME_COUNT && cti->reg_index[reg_name] < 0)
+        {
+            cti->reg_index[reg_name] = i;
         }
     }
 
-    return count;
+    return cti;
 }
 
-int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos)
+const ControlTableIndex *getControlTableIndex(const int ct[][8])
 {
-    int status = -1;
+    if (ct == nullptr)
+    {
+        return nullptr;
+    }
 
-    if (ct != nullptr)
+    // Fast path: lock-free lookup
+    const ControlTableIndex *cti = ctIndexFind(ct);
+
+    if (cti == nullptr)
     {
-        TRACE_1(TABLES, "Control table size is: '%i'", getRegisterCount(ct));
+        std::lock_guard <std::mutex> lock(ctIndexLock);
 
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
+        // Another thread may have indexed this table in the meantime
+        cti = ctIndexFind(ct);
+        if (cti == nullptr)
         {
-            TRACE_1(TABLES, "Control table [%i / %i] value: '%i'", i, getRegisterCount(ct), ct[i][0]);
-
-            if (ct[i][0] == reg_name) // match register name
+            for (const auto &i: ctIndexes)
             {
-                infos.reg_index = i;
-
-                int rom = ct[i][3];
-                int ram = ct[i][4];
-
-                if (rom != -1)
-                    infos.reg_addr = rom;
-                else if (ram != -1)
-                    infos.reg_addr = ram;
-
-                infos.reg_addr_rom = rom;
-                infos.reg_addr_ram = ram;
-                infos.reg_size = ct[i][1];
-                infos.reg_access_mode = ct[i][2];
-                infos.reg_value_def = ct[i][5];
-                infos.reg_value_min = ct[i][6];
-                infos.reg_value_max = ct[i][7];
-
-                // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
-                if (infos.reg_value_min < 0)
+                if (i->ct == ct)
                 {
-                    infos.reg_value_min = 0;
+                    return i.get(); // index exists, but the cache is full
                 }
-                if (infos.reg_value_max < 0)
+            }
+
+            ctIndexes.emplace_back(ctIndexBuild(ct));
+            cti = ctIndexes.back().get();
+
+            unsigned h = ctIndexHash(ct);
+            for (unsigned i = 0; i < CONTROL_TABLE_INDEX_SLOTS; i++)
+            {
+                std::atomic <const ControlTableIndex *> &slot = ctIndexSlots[(h + i) % CONTROL_TABLE_INDEX_SLOTS];
+
+                if (slot.load(std::memory_order_relaxed) == nullptr)
                 {
-                    if (ct[i][1] < 5)
-                    {
-                        infos.reg_value_max = static_cast<int>(std::pow(2, infos.reg_size*8));
-                    }
-                    else
-                    {
-                        infos.reg_value_max = 0xFFFFFFFF;
-                    }
+                    slot.store(cti, std::memory_order_release);
+                    break;
                 }
-                status = 1;
-                break; // exit search loop
             }
         }
     }
 
+    return cti;
+}
+
+/* ************************************************************************** */
+
+unsigned getRegisterCount(const int ct[][8])
+{
+    unsigned count = 0;
+    const ControlTableIndex *cti = getControlTableIndex(ct);
+
+    if (cti != nullptr)
+    {
+        count = cti->reg_count;
+    }
+
+    return count;
+}
+
+int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos)
+{
+    return getRegisterInfos(getControlTableIndex(ct), reg_name, infos);
+}
+
+int getRegisterInfos(const ControlTableIndex *cti, const int reg_name, RegisterInfos &infos)
+{
+    int status = -1;
+
+    if (cti != nullptr && reg_name >= 0 && reg_name < REGISTER_NAME_COUNT)
+    {
+        int i = cti->reg_index[reg_name];
+
+        if (i >= 0)
+        {
+            infos = cti->reg_infos[i];
+            status = 1;
+        }
+    }
+
     return status;
 }
 
@@ -267,17 +385,11 @@ int getRegisterName(const int ct[][8], const int reg_index)
 int getRegisterTableIndex(const int ct[][8], const int reg_name)
 {
     int index = -1;
+    const ControlTableIndex *cti = getControlTableIndex(ct);
 
-    if (ct != nullptr)
+    if (cti != nullptr && reg_name >= 0 && reg_name < REGISTER_NAME_COUNT)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                index = i;
-                break;
-            }
-        }
+        index = cti->reg_index[reg_name];
     }
 
     return index;
@@ -286,33 +398,21 @@ int getRegisterTableIndex(const int ct[][8], const int reg_name)
 int getRegisterAddr(const int ct[][8], const int reg_name, const int reg_type)
 {
     int addr = -1;
+    RegisterInfos infos;
 
-    if (ct != nullptr)
+    if (getRegisterInfos(getControlTableIndex(ct), reg_name, infos) == 1)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
+        if (reg_type == REGISTER_AUTO)
         {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                if (reg_type == REGISTER_AUTO)
-                {
-                    int rom = ct[i][3];
-                    int ram = ct[i][4];
-
-                    if (rom != -1)
-                        addr = rom;
-                    else if (ram != -1)
-                        addr = ram;
-                }
-                else if (reg_type == REGISTER_ROM)
-                {
-                    addr = ct[i][3];
-                }
-                else if (reg_type == REGISTER_RAM)
-                {
-                    addr = ct[i][4];
-                }
-                break;
-            }
+            addr = infos.reg_addr;
+        }
+        else if (reg_type == REGISTER_ROM)
+        {
+            addr = infos.reg_addr_rom;
+        }
+        else if (reg_type == REGISTER_RAM)
+        {
+            addr = infos.reg_addr_ram;
         }
     }
 
@@ -322,17 +422,11 @@ int getRegisterAddr(const int ct[][8], const int reg_name, const int reg_type)
 int getRegisterSize(const int ct[][8], const int reg_name)
 {
     int size = -1;
+    RegisterInfos infos;
 
-    if (ct != nullptr)
+    if (getRegisterInfos(getControlTableIndex(ct), reg_name, infos) == 1)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                size = ct[i][1];
-                break;
-            }
-        }
+        size = infos.reg_size;
     }
 
     return size;
@@ -341,17 +435,11 @@ int getRegisterSize(const int ct[][8], const int reg_name)
 int getRegisterAccessMode(const int ct[][8], const int reg_name)
 {
     int mode = -1;
+    RegisterInfos infos;
 
-    if (ct != nullptr)
+    if (getRegisterInfos(getControlTableIndex(ct), reg_name, infos) == 1)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                mode = ct[i][2];
-                break;
-            }
-        }
+        mode = infos.reg_access_mode;
     }
 
     return mode;
@@ -360,17 +448,11 @@ int getRegisterAccessMode(const int ct[][8], const int reg_name)
 int getRegisterInitialValue(const int ct[][8], const int reg_name)
 {
     int value = -1;
+    RegisterInfos infos;
 
-    if (ct != nullptr)
+    if (getRegisterInfos(getControlTableIndex(ct), reg_name, infos) == 1)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
-        {
-            if (ct[i][0] == reg_name) // match register name
-            {
-                value = ct[i][5];
-                break;
-            }
-        }
+        value = infos.reg_value_def;
     }
 
     return value;
@@ -379,38 +461,104 @@ int getRegisterInitialValue(const int ct[][8], const int reg_name)
 int getRegisterBounds(const int ct[][8], const int reg_name, int &min, int &max)
 {
     int status = -1;
+    RegisterInfos infos;
+
+    if (getRegisterInfos(getControlTableIndex(ct), reg_name, infos) == 1)
+    {
+        min = infos.reg_value_min;
+        max = infos.reg_value_max;
+        status = 1;
+    }
+
+    return status;
+}
+
+/*!
+ * \brief Merge (address, size) pairs of registers into blocks of contiguous registers.
+ */
+static int mergeRegisterBlocks(std::vector < std::pair <int, int> > &regs, std::vector <RegisterBlock> &blocks, const int max_gap)
+{
+    int end = 0;
+
+    std::sort(regs.begin(), regs.end());
+
+    for (const auto &r: regs)
+    {
+        if (blocks.empty() || r.first > end + max_gap)
+        {
+            blocks.push_back(RegisterBlock{r.first, r.second});
+        }
+        else if (r.first + r.second > end)
+        {
+            blocks.back().block_size = r.first + r.second - blocks.back().block_addr;
+        }
+
+        if (r.first + r.second > end)
+        {
+            end = r.first + r.second;
+        }
+    }
+
+    return end;
+}
+
+int getRegisterBlocks(const int ct[][8], const int reg_type, std::vector <RegisterBlock> &blocks, const int max_gap)
+{
+    int end = 0;
+    blocks.clear();
 
     if (ct != nullptr)
     {
-        for (unsigned i = 0; i < getRegisterCount(ct); i++)
+        // Gather (address, size) of every register
+        std::vector < std::pair <int, int> > regs;
+        unsigned count = getRegisterCount(ct);
+
+        for (unsigned i = 0; i < count; i++)
         {
-            if (ct[i][0] == reg_name) // match register name
+            int addr = -1;
+
+            if (reg_type == REGISTER_ROM)
+                addr = ct[i][3];
+            else if (reg_type == REGISTER_RAM)
+                addr = ct[i][4];
+            else
+                addr = (ct[i][3] >= 0) ? ct[i][3] : ct[i][4];
+
+            if (addr >= 0 && ct[i][1] > 0)
             {
-                min = ct[i][6];
-                max = ct[i][7];
+                regs.push_back(std::make_pair(addr, ct[i][1]));
+            }
+        }
 
-                // Ignore the '-1' and '-2' values for min and max, indicating "no boundaries"
-                if (min < 0)
-                {
-                    min = 0;
-                }
-                if (max < 0)
-                {
-                    if (ct[i][1] < 5)
-                    {
-                        max = static_cast<int>(std::pow(2, (ct[i][1])*8));
-                    }
-                    else
-                    {
-                        max = 0xFFFFFFFF;
-                    }
-                }
+        end = mergeRegisterBlocks(regs, blocks, max_gap);
+    }
+
+    return end;
+}
+
+int getRegisterBlocks(const int ct[][8], const int *reg_names, const int reg_count, const int reg_type, std::vector <RegisterBlock> &blocks, const int max_gap)
+{
+    int end = 0;
+    blocks.clear();
+
+    if (ct != nullptr && reg_names != nullptr)
+    {
+        // Gather (address, size) of the registers asked
+        std::vector < std::pair <int, int> > regs;
 
-                status = 1;
-                break;
+        for (int i = 0; i < reg_count; i++)
+        {
+            int addr = getRegisterAddr(ct, reg_names[i], reg_type);
+            int size = getRegisterSize(ct, reg_names[i]);
+
+            if (addr >= 0 && size > 0)
+            {
+                regs.push_back(std::make_pair(addr, size));
             }
         }
+
+        end = mergeRegisterBlocks(regs, blocks, max_gap);
     }
 
-    return status;
+    return end;
 }
@@ -24,6 +24,13 @@
 #define CONTROL_TABLES_H
 /* ************************************************************************** */
 
+#include "Utils.h"
+
+#include <vector>
+
+//! Maximum number of registers in a control table (excluding the '999' end marker).
+#define MAX_REGISTER_COUNT  64
+
 /** \addtogroup ControlTables
  *  @{
  */
@@ -72,6 +79,35 @@ typedef struct RegisterInfos
 
 } RegisterInfos;
 
+/*!
+ * \brief RegisterBlock structure
+ *
+ * A range of contiguous registers, that can be read or written with a single
+ * block instruction.
+ */
+typedef struct RegisterBlock
+{
+    int block_addr;      //!< Address of the first register of the block
+    int block_size;      //!< Size of the block in byte (including unused addresses between registers)
+
+} RegisterBlock;
+
+/*!
+ * \brief ControlTableIndex structure
+ *
+ * Register informations of a control table, indexed by register name. Built
+ * once per control table by getControlTableIndex(), so register lookups don't
+ * need to scan the control table.
+ */
+typedef struct ControlTableIndex
+{
+    const int (*ct)[8];                             //!< The indexed control table
+    unsigned reg_count;                             //!< Number of registers in the control table
+    int reg_index[REGISTER_NAME_COUNT];             //!< Register index in the control table for each register name, -1 if the register doesn't exist
+    RegisterInfos reg_infos[MAX_REGISTER_COUNT];    //!< Register informations, by register index
+
+} ControlTableIndex;
+
 /* ************************************************************************** */
 
 /*!
@@ -96,10 +132,29 @@ const int (*getRegisterTable(const int servo_serie, const int servo_model))[8];
  */
 unsigned getRegisterCount(const int ct[][8]);
 
+/*!
+ * \brief Get the register index of a control table.
+ * \param ct: A device's control table.
+ * \return The index of the given control table, or nullptr if ct is nullptr.
+ *
+ * The index is built the first time a control table is used, then kept for
+ * the lifetime of the program. Subsequent calls don't lock anything.
+ */
+const ControlTableIndex *getControlTableIndex(const int ct[][8]);
+
 /* ************************************************************************** */
 
 int getRegisterInfos(const int ct[][8], const int reg_name, RegisterInfos &infos);
 
+/*!
+ * \brief Get register informations directly from a control table index (constant time).
+ * \param cti: A control table index, from getControlTableIndex().
+ * \param reg_name: The register name.
+ * \param infos: The register informations, only written if the register exists.
+ * \return 1 if the register exists in the control table, -1 otherwise.
+ */
+int getRegisterInfos(const ControlTableIndex *cti, const int reg_name, RegisterInfos &infos);
+
 int getRegisterTableIndex(const int ct[][8], const int reg_name);
 
 int getRegisterName(const int ct[][8], const int reg_index);
@@ -114,6 +169,28 @@ int getRegisterInitialValue(const int ct[][8], const int reg_name);
 
 int getRegisterBounds(const int ct[][8], const int reg_name, int &min, int &max);
 
+/*!
+ * \brief Split a control table into blocks of contiguous registers.
+ * \param ct: A device's control table.
+ * \param reg_type: Use ROM or RAM addresses. REGISTER_AUTO uses ROM addresses if available, RAM otherwise.
+ * \param blocks: The list of blocks found, sorted by address.
+ * \param max_gap: Maximum number of unused bytes allowed between two registers of the same block.
+ * \return The address right after the last register of the last block (or 0 if no block has been found).
+ */
+int getRegisterBlocks(const int ct[][8], const int reg_type, std::vector <RegisterBlock> &blocks, const int max_gap = 16);
+
+/*!
+ * \brief Group a list of registers into blocks of contiguous registers.
+ * \param ct: A device's control table.
+ * \param reg_names: The registers to group.
+ * \param reg_count: Number of registers in the list.
+ * \param reg_type: Use ROM or RAM addresses. REGISTER_AUTO uses ROM addresses if available, RAM otherwise.
+ * \param blocks: The list of blocks found, sorted by address. Registers not available on this control table are ignored.
+ * \param max_gap: Maximum number of unused bytes allowed between two registers of the same block.
+ * \return The address right after the last register of the last block (or 0 if no block has been found).
+ */
+int getRegisterBlocks(const int ct[][8], const int *reg_names, const int reg_count, const int reg_type, std::vector <RegisterBlock> &blocks, const int max_gap = 16);
+
 /** @}*/
 
 /* ************************************************************************** */
@@ -21,30 +21,85 @@
  */
 
 #include "ControllerAPI.h"
+#include "SerialPortReactor.h"
 #include "minitraces.h"
 
 // C standard library
 #include <cstring>
 #include <cstdio>
+#include <cerrno>
 
 // C++ standard libraries
 #include <chrono>
 #include <thread>
 
+// Real-time scheduling
+#if defined(_WIN32) || defined(_WIN64)
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#endif
+
+// Enable latency timer
+//#define LATENCY_TIMER
+
+/* ************************************************************************** */
+
+/*!
+ * \brief Get current time from the monotonic clock used to schedule the synchronization loops.
+ * \return Current time in nanoseconds.
+ */
+static int64_t getMonotonicTime()
+{
+#if defined(__linux__) || defined(__gnu_linux)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/*!
+ * \brief Sleep until an absolute time of the monotonic clock.
+ * \param deadline: Wake up time, in nanoseconds, from getMonotonicTime().
+ */
+static void sleepUntil(const int64_t deadline)
+{
+#if defined(__linux__) || defined(__gnu_linux)
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(deadline / 1000000000LL);
+    ts.tv_nsec = static_cast<long>(deadline % 1000000000LL);
+
+    // Absolute deadline: a signal interruption can simply resume the same wait
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR);
+#else
+    std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)));
+#endif
+}
+
 /* ************************************************************************** */
 
 ControllerAPI::ControllerAPI(int ctrlFrequency)
 {
-    if (ctrlFrequency < 1 || ctrlFrequency > 120)
+    if (ctrlFrequency < 1)
     {
-        syncloopFrequency = 30;
-        syncloopDuration = 1000.0 / 30.0;
+        TRACE_WARNING(CAPI, "Invalid synchronization frequency (%i Hz), using 30 Hz", ctrlFrequency);
+        ctrlFrequency = 30;
     }
-    else
+    else if (ctrlFrequency > SYNCLOOP_FREQUENCY_MAX)
     {
-        syncloopFrequency = ctrlFrequency;
-        syncloopDuration = 1000.0 / static_cast<double>(ctrlFrequency);
+        TRACE_WARNING(CAPI, "Synchronization frequency (%i Hz) is too high, using %i Hz", ctrlFrequency, SYNCLOOP_FREQUENCY_MAX);
+        ctrlFrequency = SYNCLOOP_FREQUENCY_MAX;
     }
+
+    syncloopRequestedFrequency = ctrlFrequency;
+    syncloopFrequency = ctrlFrequency;
+    syncloopDuration = 1000.0 / static_cast<double>(ctrlFrequency);
+
+    pollingChanged = true;
+    m_control = -1;
 }
 
 ControllerAPI::~ControllerAPI()
@@ -54,13 +109,290 @@ ControllerAPI::~ControllerAPI()
 
 /* ************************************************************************** */
 
+void ControllerAPI::syncloopStart()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    if (syncloopPriority > 0 || syncloopCpu >= 0)
+    {
+        TRACE_WARNING(CAPI, "Real-time priority and CPU affinity are not available on this platform");
+    }
+#else
+    if (syncloopPriority > 0)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = syncloopPriority;
+
+        int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if (err != 0)
+        {
+            TRACE_WARNING(CAPI, "Unable to set SCHED_FIFO priority %i for the synchronization loop: %s", syncloopPriority, strerror(err));
+        }
+        else
+        {
+            TRACE_INFO(CAPI, "Synchronization loop running with SCHED_FIFO priority %i", syncloopPriority);
+        }
+    }
+
+    if (syncloopCpu >= 0)
+    {
+#if defined(__linux__) || defined(__gnu_linux)
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(syncloopCpu, &cpuset);
+
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+        if (err != 0)
+        {
+            TRACE_WARNING(CAPI, "Unable to pin the synchronization loop on CPU %i: %s", syncloopCpu, strerror(err));
+        }
+        else
+        {
+            TRACE_INFO(CAPI, "Synchronization loop pinned on CPU %i", syncloopCpu);
+        }
+#else
+        TRACE_WARNING(CAPI, "CPU affinity is not available on this platform");
+#endif
+    }
+#endif
+
+    syncloopDeadline = getMonotonicTime();
+}
+
+void ControllerAPI::run()
+{
+    TRACE_INFO(CAPI, "ControllerAPI::run(port: '%s' / tid: '%i')",
+               serialGetCurrentDevice_wrapper().c_str(), std::this_thread::get_id());
+
+    syncloopStart();
+
+    while (getState() >= state_started)
+    {
+        // Loop timer
+        syncloopCycleBegin();
+
+        // Messages, actions and initial reads
+        if (syncloopMaintenance() == false)
+        {
+            return;
+        }
+
+        // Follow the polling plans, and check that a cycle still fits on the bus
+        // if the synchronized devices changed
+        syncloopUpdatePolling();
+        syncloopCheckBudget();
+
+        // Register writes and feedback reads
+        syncloopSynchronize();
+        syncloopPhaseEnd(phase_sync);
+
+        syncloopCycleFinish();
+
+        // Wait for the next cycle boundary
+        syncloopWait();
+    }
+
+    TRACE_INFO(CAPI, ">> THREAD (tid: '%i') termination by 'loop exit'", std::this_thread::get_id());
+}
+
+void ControllerAPI::syncloopWait()
+{
+    sleepUntil(syncloopNextDeadline());
+}
+
+int64_t ControllerAPI::syncloopNextDeadline()
+{
+    const int64_t period = static_cast<int64_t>(syncloopDuration * 1000000.0);
+    const int64_t now = getMonotonicTime();
+
+    syncloopDeadline += period;
+
+    if (syncloopDeadline < now)
+    {
+        TRACE_1(CAPI, "Sync loop overrun: %fms late", (now - syncloopDeadline) / 1000000.0);
+
+        switch (syncloopOverrunPolicy)
+        {
+        case overrun_catchup:
+            // Keep the missed boundaries: next cycles start without waiting until we are back on schedule
+            break;
+
+        case overrun_stretch:
+            // The late cycle becomes the new reference
+            syncloopDeadline = now;
+            break;
+
+        case overrun_skip:
+        default:
+            // Jump to the first boundary still ahead of us
+            syncloopDeadline += ((now - syncloopDeadline) / period + 1) * period;
+            break;
+        }
+    }
+
+    return syncloopDeadline;
+}
+
+void ControllerAPI::syncloopCycleBegin()
+{
+    syncloopCycleStart = getMonotonicTime();
+    syncloopPhaseStart = syncloopCycleStart;
+
+    for (int i = 0; i < phase_count; i++)
+    {
+        syncloopPhaseTimes[i] = 0.0;
+    }
+}
+
+void ControllerAPI::syncloopPhaseEnd(const int phase)
+{
+    int64_t now = getMonotonicTime();
+
+    syncloopPhaseTimes[phase] += (now - syncloopPhaseStart) / 1000.0;
+    syncloopPhaseStart = now;
+}
+
+double ControllerAPI::syncloopCycleEnd(TimingHistogram &transactionTimes)
+{
+    const int64_t period = static_cast<int64_t>(syncloopDuration * 1000000.0);
+    const int64_t end = getMonotonicTime();
+
+    double cycle = (end - syncloopCycleStart) / 1000.0;
+    double late = (syncloopCycleStart > syncloopDeadline) ? (syncloopCycleStart - syncloopDeadline) / 1000.0 : 0.0;
+
+    {
+        std::lock_guard <std::mutex> lock(syncloopStatsLock);
+
+        syncloopStats.cycles++;
+        if (end > syncloopDeadline + period)
+        {
+            syncloopStats.overruns++;
+        }
+
+        syncloopStats.lastCycle = cycle;
+        syncloopStats.cycle.add(cycle);
+        syncloopStats.jitter.add(late);
+
+        for (int i = 0; i < phase_count; i++)
+        {
+            syncloopStats.lastPhases[i] = syncloopPhaseTimes[i];
+            syncloopStats.phases[i].add(syncloopPhaseTimes[i]);
+        }
+
+        syncloopStats.transactions.merge(transactionTimes);
+    }
+
+    transactionTimes.clear();
+
+    return cycle / 1000.0;
+}
+
+void ControllerAPI::syncloopCycleFinish()
+{
+    // Loop control
+    syncloopCounter++;
+
+    // Loop timer
+    double loopd = syncloopCycleEnd(syncloopTransactionTimes());
+
+    if (syncloopCallback)
+    {
+        syncloopCallback(loopd);
+    }
+
+#ifdef LATENCY_TIMER
+    if (loopd > syncloopDuration)
+    {
+        TRACE_WARNING(CAPI, "Sync loop duration: %fms of the %fms budget.", loopd, syncloopDuration);
+    }
+    else
+    {
+        TRACE_INFO(CAPI, "Sync loop duration: %fms of the %fms budget.", loopd, syncloopDuration);
+    }
+#endif
+}
+
+void ControllerAPI::syncloopUpdatePolling()
+{
+    bool plansChanged = pollingChanged.exchange(false);
+
+    std::lock_guard <std::mutex> lock(servoListLock);
+
+    if (plansChanged == false &&
+        pollingRevision == servoRegistry.getRevision() &&
+        pollingFrequency == syncloopFrequency)
+    {
+        return;
+    }
+
+    pollingRevision = servoRegistry.getRevision();
+    pollingFrequency = syncloopFrequency;
+
+    std::lock_guard <std::mutex> planLock(pollingLock);
+
+    pollingSchedule.clear();
+    for (auto s: servoRegistry.getSyncServos())
+    {
+        auto p = pollingPlans.find(s->getId());
+        pollingSchedule.add(s, (p != pollingPlans.end()) ? p->second : pollingPlan, syncloopFrequency);
+    }
+    pollingSchedule.balance();
+
+    if (plansChanged)
+    {
+        // The bus time needed by a cycle must be estimated again
+        syncloopBudgetDevices = 0;
+    }
+}
+
+void ControllerAPI::syncloopCheckBudget()
+{
+    std::lock_guard <std::mutex> lock(servoListLock);
+
+    // Wait for the initial reads, the estimation needs the devices settings
+    if (servoRegistry.getUpdateServos().empty() == false ||
+        servoRegistry.getSyncServos().size() == syncloopBudgetDevices)
+    {
+        return;
+    }
+
+    syncloopBudgetDevices = servoRegistry.getSyncServos().size();
+
+    double busTime = estimateCycleDuration();
+    double budget = (1000.0 / static_cast<double>(syncloopRequestedFrequency)) * SYNCLOOP_BUDGET_RATIO;
+    int frequency = syncloopRequestedFrequency;
+
+    if (busTime > budget)
+    {
+        TRACE_WARNING(CAPI, "Sync loop at %i Hz: %i device(s) need ~%fms of bus time per cycle, above the %fms budget",
+                      syncloopRequestedFrequency, static_cast<int>(syncloopBudgetDevices), busTime, budget);
+
+        if (syncloopBudgetPolicy == budget_adapt)
+        {
+            frequency = static_cast<int>((1000.0 * SYNCLOOP_BUDGET_RATIO) / busTime);
+            if (frequency < 1)
+            {
+                frequency = 1;
+            }
+        }
+    }
+
+    if (frequency != syncloopFrequency)
+    {
+        TRACE_WARNING(CAPI, "Sync loop frequency set to %i Hz (requested: %i Hz)", frequency, syncloopRequestedFrequency);
+
+        syncloopFrequency = frequency;
+        syncloopDuration = 1000.0 / static_cast<double>(frequency);
+    }
+}
+
 void ControllerAPI::startThread()
 {
-    if (getState() < state_started && syncloopThread.joinable() == 0)
+    if (getState() < state_started && syncloopRunning() == false)
     {
         clearErrorCount();
         setState(state_started);
-        syncloopThread = std::thread(&ControllerAPI::run, this);
+        syncloopLaunch();
     }
 }
 
@@ -68,7 +400,7 @@ void ControllerAPI::pauseThread()
 {
     int ctrlState = getState();
 
-    if (ctrlState >= state_started && syncloopThread.joinable() == 1)
+    if (ctrlState >= state_started && syncloopRunning() == true)
     {
         TRACE_INFO(CAPI, ">> Pausing thread (id: %i)...", syncloopThread.get_id());
 
@@ -77,15 +409,15 @@ void ControllerAPI::pauseThread()
         m.msg = ctrl_state_pause;
         sendMessage(&m);
 
-        syncloopThread.join();
+        syncloopJoin();
         setState(state_paused);
     }
-    else if (ctrlState == state_paused && syncloopThread.joinable() == 0)
+    else if (ctrlState == state_paused && syncloopRunning() == false)
     {
         TRACE_INFO(CAPI, ">> Unpausing thread (id: %i)...", syncloopThread.get_id());
 
         setState(state_ready);
-        syncloopThread = std::thread(&ControllerAPI::run, this);
+        syncloopLaunch();
     }
     else
     {
@@ -95,7 +427,7 @@ void ControllerAPI::pauseThread()
 
 void ControllerAPI::stopThread()
 {
-    if (getState() != state_stopped && syncloopThread.joinable() == 1)
+    if (getState() != state_stopped && syncloopRunning() == true)
     {
         TRACE_INFO(CAPI, ">> Stopping thread (id: %i)...", syncloopThread.get_id());
 
@@ -106,7 +438,7 @@ void ControllerAPI::stopThread()
         sendMessage(&m);
 
         // Wait for the thread to finish
-        syncloopThread.join();
+        syncloopJoin();
 
         // Cleanup controller
         unregisterServos_internal();
@@ -116,6 +448,286 @@ void ControllerAPI::stopThread()
     }
 }
 
+void ControllerAPI::syncloopLaunch()
+{
+    if (syncloopReactorMode == true)
+    {
+        if (syncloopReactorStart() == true)
+        {
+            return;
+        }
+
+        TRACE_WARNING(CAPI, "Unable to use the serial reactor, the synchronization loop will run inside its own thread");
+    }
+
+    syncloopThread = std::thread(&ControllerAPI::run, this);
+}
+
+void ControllerAPI::syncloopJoin()
+{
+    if (syncloopThread.joinable() == true)
+    {
+        syncloopThread.join();
+    }
+    else
+    {
+        std::unique_lock <std::mutex> lock(syncloopReactorLock);
+        syncloopReactorCondition.wait(lock, [this] { return syncloopReactorActive == false; });
+    }
+}
+
+bool ControllerAPI::syncloopRunning()
+{
+    if (syncloopThread.joinable() == true)
+    {
+        return true;
+    }
+
+    std::lock_guard <std::mutex> lock(syncloopReactorLock);
+    return syncloopReactorActive;
+}
+
+bool ControllerAPI::syncloopMaintenanceNeeded()
+{
+    if (m_control >= 0 || m_queue.empty() == false ||
+        (m_timers.empty() == false && m_timers.top().delay <= std::chrono::steady_clock::now()))
+    {
+        return true;
+    }
+
+    std::lock_guard <std::mutex> lock(servoListLock);
+
+    if (servoRegistry.getUpdateServos().empty() == false)
+    {
+        return true;
+    }
+
+    for (auto s: servoRegistry.getServos())
+    {
+        if (s->hasActions() == true)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+#if defined(__linux__) || defined(__gnu_linux)
+
+bool ControllerAPI::syncloopReactorStart()
+{
+    SerialPortLinux *port = dynamic_cast<SerialPortLinux *>(serialGetPort_wrapper());
+    if (port == nullptr)
+    {
+        TRACE_WARNING(CAPI, "Reactor mode needs a Linux serial port");
+        return false;
+    }
+
+    if (syncloopReactor == nullptr)
+    {
+        syncloopReactor = SerialPortReactor::getShared();
+    }
+
+    if (syncloopReactor == nullptr || syncloopReactor->addPort(port) == false)
+    {
+        return false;
+    }
+
+    if (syncloopPriority > 0 || syncloopCpu >= 0)
+    {
+        TRACE_WARNING(CAPI, "Real-time priority and CPU affinity are ignored in reactor mode");
+    }
+
+    TRACE_INFO(CAPI, "Synchronization loop for '%s' running from the serial reactor", serialGetCurrentDevice_wrapper().c_str());
+
+    syncloopReactorPort = port;
+    {
+        std::lock_guard <std::mutex> lock(syncloopReactorLock);
+        syncloopReactorActive = true;
+    }
+
+    syncloopDeadline = getMonotonicTime();
+    syncloopReactor->schedule(std::chrono::steady_clock::now(), [this] { syncloopReactorCycle(); });
+
+    return true;
+}
+
+void ControllerAPI::syncloopReactorCycle()
+{
+    if (getState() < state_started)
+    {
+        syncloopReactorEnd();
+        return;
+    }
+
+    // Loop timer
+    syncloopCycleBegin();
+
+    if (syncloopMaintenanceNeeded() == true)
+    {
+        // Messages, actions and initial reads are blocking: lend the port to the worker thread
+        bool offloaded = syncloopReactor->offload(syncloopReactorPort,
+                                                  [this] { syncloopReactorContinue = syncloopMaintenance(); },
+                                                  [this] {
+                                                      if (syncloopReactorContinue == true)
+                                                      {
+                                                          syncloopReactorSync();
+                                                      }
+                                                      else
+                                                      {
+                                                          syncloopReactorEnd();
+                                                      }
+                                                  });
+        if (offloaded == false)
+        {
+            syncloopReactorEnd();
+        }
+        return;
+    }
+
+    syncloopPhaseEnd(phase_messages);
+    syncloopPhaseEnd(phase_actions);
+    syncloopPhaseEnd(phase_initial_read);
+
+    syncloopReactorSync();
+}
+
+void ControllerAPI::syncloopReactorSync()
+{
+    syncloopUpdatePolling();
+    syncloopCheckBudget();
+
+    std::function <void ()> next = [this]() {
+        syncloopPhaseEnd(phase_sync);
+        syncloopCycleFinish();
+
+        int64_t deadline = syncloopNextDeadline();
+        syncloopReactor->schedule(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(deadline)),
+                                  [this] { syncloopReactorCycle(); });
+    };
+
+    if (syncloopSubmit(next) == false)
+    {
+        // Some synchronization steps still need blocking transactions
+        if (syncloopReactor->offload(syncloopReactorPort, [this] { syncloopSynchronize(); }, next) == false)
+        {
+            syncloopReactorEnd();
+        }
+    }
+}
+
+void ControllerAPI::syncloopReactorEnd()
+{
+    TRACE_INFO(CAPI, ">> Synchronization loop for '%s' leaving the serial reactor", serialGetCurrentDevice_wrapper().c_str());
+
+    syncloopReactor->removePort(syncloopReactorPort);
+    syncloopReactorPort = nullptr;
+
+    // The controller may be destroyed as soon as the lock is released
+    std::lock_guard <std::mutex> lock(syncloopReactorLock);
+    syncloopReactorActive = false;
+    syncloopReactorCondition.notify_all();
+}
+
+void ControllerAPI::syncloopSubmitTransactions(std::vector <SerialTransaction> &transactions, std::function <void ()> done)
+{
+    // Transactions without response are sent together, with one write
+    std::vector <SerialTransaction> merged;
+
+    for (auto &t: transactions)
+    {
+        if (t.responseLength <= 0 && merged.empty() == false && merged.back().responseLength <= 0 &&
+            merged.back().request.size() + t.request.size() <= SYNCLOOP_REACTOR_BATCH_SIZE)
+        {
+            SerialTransaction &m = merged.back();
+            std::function <void (int, const std::vector <unsigned char> &)> first = m.callback, second = t.callback;
+
+            m.request.insert(m.request.end(), t.request.begin(), t.request.end());
+            m.callback = [first, second](int status, const std::vector <unsigned char> &response) {
+                if (first) first(status, response);
+                if (second) second(status, response);
+            };
+        }
+        else
+        {
+            merged.push_back(t);
+        }
+    }
+
+    if (merged.empty() == true)
+    {
+        done();
+        return;
+    }
+
+    struct SubmitState
+    {
+        size_t remaining;
+        std::chrono::steady_clock::time_point last;
+        std::function <void ()> done;
+    };
+
+    std::shared_ptr <SubmitState> state = std::make_shared <SubmitState>();
+    state->remaining = merged.size();
+    state->last = std::chrono::steady_clock::now();
+    state->done = done;
+
+    for (auto &t: merged)
+    {
+        std::function <void (int, const std::vector <unsigned char> &)> callback = t.callback;
+        bool timed = (t.responseLength > 0);
+
+        // Transactions of a port are done one after the other: the round-trip
+        // time of one is measured from the completion of the previous one
+        t.callback = [this, state, callback, timed](int status, const std::vector <unsigned char> &response) {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (timed)
+            {
+                syncloopTransactionTimes().add(std::chrono::duration<double, std::micro>(now - state->last).count());
+            }
+            state->last = now;
+
+            if (callback)
+            {
+                callback(status, response);
+            }
+
+            if (--state->remaining == 0)
+            {
+                state->done();
+            }
+        };
+    }
+
+    for (auto &t: merged)
+    {
+        if (syncloopReactor->submit(syncloopReactorPort, t) == false)
+        {
+            t.callback(COMM_TXFAIL, std::vector <unsigned char>());
+        }
+    }
+}
+
+#else
+
+bool ControllerAPI::syncloopReactorStart()
+{
+    TRACE_WARNING(CAPI, "Reactor mode is not available on this platform");
+    return false;
+}
+
+void ControllerAPI::syncloopReactorCycle() {}
+void ControllerAPI::syncloopReactorSync() {}
+void ControllerAPI::syncloopReactorEnd() {}
+
+void ControllerAPI::syncloopSubmitTransactions(std::vector <SerialTransaction> &transactions, std::function <void ()> done)
+{
+    done();
+}
+
+#endif // __linux__ || __gnu_linux
+
 /* ************************************************************************** */
 
 void ControllerAPI::setState(const int state)
@@ -221,25 +833,14 @@ void ControllerAPI::registerServo_internal(Servo *servo)
             // Lock servoList
             std::lock_guard <std::mutex> lock(servoListLock);
 
-            // Check if the servo is already registered
-            for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end(); ++it)
+            // Add servo to the controller registry, and mark it for an "initial read" and "sync"
+            if (servoRegistry.add(servo) == false)
             {
-                if ((*it)->getId() == (*servo).getId())
-                {
-                    TRACE_ERROR(CAPI, "Unable to register servo #%i: already registered!", (*servo).getId());
-                    return;
-                }
+                TRACE_ERROR(CAPI, "Unable to register servo #%i: already registered!", (*servo).getId());
+                return;
             }
-            TRACE_INFO(CAPI, "Registering servo #%i", (*servo).getId());
-
-            // Add servo to the controller vector
-            servoList.push_back(servo);
 
-            // Mark it for an "initial read"
-            updateList.push_back((*servo).getId());
-
-            // Mark it for "sync"
-            syncList.push_back((*servo).getId());
+            TRACE_INFO(CAPI, "Registering servo #%i", (*servo).getId());
         }
         else
         {
@@ -257,43 +858,9 @@ void ControllerAPI::unregisterServo_internal(Servo *servo)
     // Lock servoList
     std::lock_guard <std::mutex> lock(servoListLock);
 
-    for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end();)
-    {
-        if ((*it)->getId() == (*servo).getId())
-        {
-            servoList.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
-
-    for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-    {
-        if (*it == (*servo).getId())
-        {
-            updateList.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
-
-    for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-    {
-        if (*it == (*servo).getId())
-        {
-            syncList.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    servoRegistry.remove((*servo).getId());
 
-    if (servoList.empty() == true)
+    if (servoRegistry.empty() == true)
     {
         // No more device(s), nothing left to do, we set the controller state back to idle
         setState(state_started);
@@ -305,39 +872,28 @@ void ControllerAPI::unregisterServos_internal()
     // Lock servoList
     std::lock_guard <std::mutex> lock(servoListLock);
 
-    for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end(); ++it)
+    for (auto s: servoRegistry.getServos())
     {
-        delete *it;
+        delete s;
     }
 
     clearErrorCount();
 
-    servoList.clear();
-    updateList.clear();
-    syncList.clear();
+    servoRegistry.clear();
 
     // No more device(s), nothing left to do, we set the controller state back to idle
     setState(state_started);
 }
 
-int ControllerAPI::delayedAddServos_internal(std::chrono::time_point <std::chrono::system_clock> delay, int id, int update)
+void ControllerAPI::delayedAddServos_internal(int id, int update)
 {
-    if (delay < std::chrono::system_clock::now())
-    {
-        TRACE_INFO(CAPI, "Adding back servo #%i to its controller", id);
-        servoListLock.lock();
+    TRACE_INFO(CAPI, "Adding back servo #%i to its controller", id);
+    servoListLock.lock();
 
-        syncList.push_back(id);
-        if (update == 1)
-        { updateList.push_back(id); }
-        servoListLock.unlock();
-
-        return 0;
-    }
-    else
-    {
-        return 1;
-    }
+    servoRegistry.setSync(id, true);
+    if (update == 1)
+    { servoRegistry.setUpdate(id, true); }
+    servoListLock.unlock();
 }
 
 /* ************************************************************************** */
@@ -347,15 +903,7 @@ Servo *ControllerAPI::getServo(const int id)
     // Lock servoList
     std::lock_guard <std::mutex> lock(servoListLock);
 
-    for (std::vector <Servo *>::iterator it = servoList.begin(); it != servoList.end(); ++it)
-    {
-        if ((*it)->getId() == id)
-        {
-            return *it;
-        }
-    }
-
-    return nullptr;
+    return servoRegistry.get(id);
 }
 
 const std::vector <Servo *> ControllerAPI::getServos()
@@ -364,7 +912,7 @@ const std::vector <Servo *> ControllerAPI::getServos()
     std::lock_guard <std::mutex> lock(servoListLock);
 
     // We only return a copy of the list
-    const std::vector <Servo *> servos(servoList);
+    const std::vector <Servo *> servos(servoRegistry.getServos());
     return servos;
 }
 
@@ -376,8 +924,20 @@ void ControllerAPI::sendMessage(miniMessages *m)
     {
         TRACE_3(CAPI, "> sendMessage()");
 
-        std::lock_guard <std::mutex> lock(m_mutex);
-        m_queue.push_back(*m);
+        if (m->msg == ctrl_state_stop)
+        {
+            m_control = ctrl_state_stop;
+        }
+        else if (m->msg == ctrl_state_pause)
+        {
+            // A pending stop request wins over a pause
+            int none = -1;
+            m_control.compare_exchange_strong(none, ctrl_state_pause);
+        }
+        else if (m_queue.push(*m) == false)
+        {
+            TRACE_ERROR(CAPI, "sendMiniMessage() error: message queue is full, message '%i' discarded", m->msg);
+        }
     }
     else
     {
@@ -385,11 +945,181 @@ void ControllerAPI::sendMessage(miniMessages *m)
     }
 }
 
+bool ControllerAPI::receiveMessage(miniMessages &m)
+{
+    // Pause and stop requests first
+    int control = m_control.exchange(-1);
+    if (control >= 0)
+    {
+        m = miniMessages();
+        m.msg = static_cast<controllerMessage_e>(control);
+        return true;
+    }
+
+    std::chrono::time_point <std::chrono::steady_clock> now = std::chrono::steady_clock::now();
+
+    // New messages first, delayed ones are moved into the timer heap
+    while (m_queue.pop(m))
+    {
+        if (m.delay > now)
+        {
+            m_timers.push(m);
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    // Then the delayed messages which deadline has passed
+    if (m_timers.empty() == false && m_timers.top().delay <= now)
+    {
+        m = m_timers.top();
+        m_timers.pop();
+        return true;
+    }
+
+    return false;
+}
+
+void ControllerAPI::setRegisterCacheFile(const std::string &path)
+{
+    registerCache.setCacheFile(path);
+}
+
+void ControllerAPI::setSyncLoopCallback(std::function <void (double duration_ms)> callback)
+{
+    syncloopCallback = callback;
+}
+
+void ControllerAPI::setOverrunPolicy(const int policy)
+{
+    if (policy >= overrun_skip && policy <= overrun_stretch)
+    {
+        syncloopOverrunPolicy = policy;
+    }
+    else
+    {
+        TRACE_ERROR(CAPI, "Unknown overrun policy: '%i'", policy);
+    }
+}
+
+void ControllerAPI::setRealtimePriority(const int priority)
+{
+    if (priority >= 0 && priority <= 99)
+    {
+        syncloopPriority = priority;
+    }
+    else
+    {
+        TRACE_ERROR(CAPI, "Invalid SCHED_FIFO priority: '%i', range is [1;99] (or 0 to disable)", priority);
+    }
+}
+
+void ControllerAPI::setCpuAffinity(const int cpu)
+{
+    syncloopCpu = (cpu < 0) ? -1 : cpu;
+}
+
+void ControllerAPI::setReactorMode(const bool enable)
+{
+#if defined(__linux__) || defined(__gnu_linux)
+    syncloopReactorMode = enable;
+#else
+    if (enable == true)
+    {
+        TRACE_WARNING(CAPI, "Reactor mode is only available on Linux");
+    }
+#endif
+}
+
+void ControllerAPI::setBudgetPolicy(const int policy)
+{
+    if (policy == budget_warn || policy == budget_adapt)
+    {
+        syncloopBudgetPolicy = policy;
+    }
+    else
+    {
+        TRACE_ERROR(CAPI, "Unknown budget policy: '%i'", policy);
+    }
+}
+
+void ControllerAPI::setPollingPlan(const PollingPlan &plan)
+{
+    std::lock_guard <std::mutex> lock(pollingLock);
+
+    pollingPlan = plan;
+    pollingChanged = true;
+}
+
+void ControllerAPI::setPollingPlan(const int id, const PollingPlan &plan)
+{
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS)
+    {
+        TRACE_ERROR(CAPI, "Cannot set a polling plan for invalid device ID #%i", id);
+        return;
+    }
+
+    std::lock_guard <std::mutex> lock(pollingLock);
+
+    pollingPlans[id] = plan;
+    pollingChanged = true;
+}
+
+void ControllerAPI::resetPollingPlan(const int id)
+{
+    std::lock_guard <std::mutex> lock(pollingLock);
+
+    if (pollingPlans.erase(id) > 0)
+    {
+        pollingChanged = true;
+    }
+}
+
+PollingPlan ControllerAPI::getPollingPlan(const int id)
+{
+    std::lock_guard <std::mutex> lock(pollingLock);
+
+    auto p = pollingPlans.find(id);
+    if (p != pollingPlans.end())
+    {
+        return p->second;
+    }
+
+    return pollingPlan;
+}
+
+int ControllerAPI::getSyncLoopFrequency()
+{
+    return syncloopFrequency;
+}
+
+SyncLoopStats ControllerAPI::getSyncLoopStats()
+{
+    std::lock_guard <std::mutex> lock(syncloopStatsLock);
+
+    // We only return a copy of the statistics
+    return syncloopStats;
+}
+
+void ControllerAPI::resetSyncLoopStats()
+{
+    std::lock_guard <std::mutex> lock(syncloopStatsLock);
+
+    syncloopStats = SyncLoopStats();
+}
+
 void ControllerAPI::clearMessageQueue()
 {
-    m_mutex.lock();
-    m_queue.clear();
-    m_mutex.unlock();
+    miniMessages m;
+    while (m_queue.pop(m));
+    m_control = -1;
+
+    while (m_timers.empty() == false)
+    {
+        m_timers.pop();
+    }
 }
 
 /* ************************************************************************** */
@@ -25,11 +25,28 @@
 
 #include "Servo.h"
 #include "Utils.h"
+#include "RegisterCache.h"
+#include "ServoRegistry.h"
+#include "MessageQueue.h"
+#include "TimingHistogram.h"
+#include "PollingPlan.h"
 
 #include <vector>
-#include <deque>
+#include <map>
+#include <queue>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+class SerialPort;
+class SerialPortLinux;
+class SerialPortReactor;
+struct SerialTransaction;
 
 /** \addtogroup ManagedAPIs
  *  @{
@@ -50,6 +67,66 @@ enum controllerState_e
     state_ready,
 };
 
+/*!
+ * \brief What to do when a synchronization loop cycle ends after the next cycle boundary.
+ */
+enum syncloopOverrun_e
+{
+    overrun_skip = 0,   //!< Drop the missed cycle(s), and wait for the next boundary of the original schedule.
+    overrun_catchup,    //!< Start the missed cycle(s) right away, until the loop is back on schedule.
+    overrun_stretch,    //!< Start the next cycle right away, and shift the schedule to that new reference.
+};
+
+/*!
+ * \brief What to do when the requested synchronization frequency does not fit the serial link capacity.
+ */
+enum syncloopBudget_e
+{
+    budget_warn = 0,    //!< Keep the requested frequency, and issue a warning.
+    budget_adapt,       //!< Lower the frequency to the highest one the serial link can sustain, and issue a warning.
+};
+
+/*!
+ * \brief The phases of a synchronization loop cycle.
+ */
+enum syncloopPhase_e
+{
+    phase_messages = 0, //!< Controller messages parsing.
+    phase_actions,      //!< Reboot, reset and refresh actions.
+    phase_initial_read, //!< "Full" register reads of new devices.
+    phase_sync,         //!< Register writes and feedback reads.
+
+    phase_count
+};
+
+/*!
+ * \brief Timing statistics of a synchronization loop, see ControllerAPI::getSyncLoopStats().
+ *
+ * Every duration is in microseconds.
+ */
+struct SyncLoopStats
+{
+    uint64_t cycles = 0;                //!< Number of cycles measured.
+    uint64_t overruns = 0;              //!< Number of cycles that ended after the next cycle boundary.
+
+    double lastCycle = 0.0;             //!< Duration of the last cycle, without the sleep time.
+    double lastPhases[phase_count] = {0.0}; //!< Duration of each phase of the last cycle.
+
+    TimingHistogram cycle;              //!< Cycle durations, without the sleep time.
+    TimingHistogram phases[phase_count]; //!< Durations of each cycle phase, see syncloopPhase_e.
+    TimingHistogram jitter;             //!< Delay between the scheduled start and the actual start of each cycle.
+    TimingHistogram transactions;       //!< Round-trip time of the transactions expecting status packet(s).
+};
+
+//! Maximum frequency of the synchronization loops, in Hz.
+#define SYNCLOOP_FREQUENCY_MAX  1000
+
+//! Part of a synchronization loop cycle that can be spent on the bus, the rest is kept for the host side (USB latency, processing...).
+#define SYNCLOOP_BUDGET_RATIO   0.8
+
+//! Maximum number of bytes sent with one write, when transactions without status packet are merged in reactor mode.
+#define SYNCLOOP_REACTOR_BATCH_SIZE 1024
+
 /*!
  * \brief The ControllerAPI abstract class, root of the ManagedAPI.
  *
@@ -57,6 +134,11 @@ enum controllerState_e
  * same time. A program must instanciate servos instances and register them to
  * a controller. Each servo object is synchronized with its hardware counterpart
  * by the run() method, running in its own backgound thread.
+ *
+ * In reactor mode (see setReactorMode()), the controller doesn't have its own
+ * thread: its serial port is driven by the SerialPortReactor shared by every
+ * controller in that mode, and its synchronization cycles are split into
+ * transactions completed from the reactor thread.
  */
 class ControllerAPI
 {
@@ -83,43 +165,216 @@ protected:
     struct miniMessages
     {
         controllerMessage_e msg;
-        std::chrono::time_point <std::chrono::system_clock> delay; //!< Used to delay message parsing
+        std::chrono::time_point <std::chrono::steady_clock> delay; //!< Used to delay message parsing
         void *p;
         int p1;
         int p2;
     };
 
-    int syncloopFrequency;              //!< Frequency of the synchronization loop, in Hz. May not be respected if there is too much traffic on the serial port.
-    int syncloopCounter = 0;
+    //! Orders the timer heap, the message with the closest deadline on top.
+    struct miniMessagesDeadline
+    {
+        bool operator()(const miniMessages &a, const miniMessages &b) const
+        {
+            return a.delay > b.delay;
+        }
+    };
+
+    std::atomic <int> syncloopFrequency; //!< Frequency of the synchronization loop, in Hz. May not be respected if there is too much traffic on the serial port.
+    int syncloopRequestedFrequency;     //!< Frequency asked by the user, in Hz. The 'budget_adapt' policy can run the loop at a lower frequency.
+    uint64_t syncloopCounter = 0;       //!< Number of cycles since the controller creation, used by the polling schedule.
     double syncloopDuration;            //!< Maximum duration for the synchronization loop, in milliseconds.
 
+    int syncloopOverrunPolicy = overrun_skip; //!< See syncloopOverrun_e.
+    int syncloopPriority = 0;           //!< SCHED_FIFO priority of the controller's thread, or 0 to keep the default scheduling.
+    int syncloopCpu = -1;               //!< CPU the controller's thread is pinned on, or -1 for no affinity.
+    int64_t syncloopDeadline = 0;       //!< Start of the current cycle on the schedule, in nanoseconds from the monotonic clock.
+
+    int syncloopBudgetPolicy = budget_warn; //!< See syncloopBudget_e.
+
+    SyncLoopStats syncloopStats;        //!< Timing statistics of the synchronization loop.
+    std::mutex syncloopStatsLock;       //!< Lock for the timing statistics.
+    int64_t syncloopCycleStart = 0;     //!< Start of the current cycle, in nanoseconds from the monotonic clock.
+    int64_t syncloopPhaseStart = 0;     //!< Start of the current cycle phase, in nanoseconds from the monotonic clock.
+    double syncloopPhaseTimes[phase_count]; //!< Phase durations of the current cycle, in microseconds.
+    size_t syncloopBudgetDevices = 0;   //!< Number of synchronized devices when the bus budget was last checked.
+
     std::thread syncloopThread;         //!< Controller's thread.
 
-    std::deque<struct miniMessages> m_queue; //!< Message queue.
-    std::mutex m_mutex;                 //!< Lock for the message queue.
+    bool syncloopReactorMode = false;   //!< Run the synchronization loop from the shared SerialPortReactor instead of a thread.
+    std::shared_ptr <SerialPortReactor> syncloopReactor; //!< The shared reactor, once the controller used it.
+    SerialPortLinux *syncloopReactorPort = nullptr; //!< Serial port registered to the reactor, while the loop runs in reactor mode.
+    bool syncloopReactorContinue = false; //!< Outcome of the last offloaded syncloopMaintenance().
+    bool syncloopReactorActive = false; //!< Set while the loop runs in reactor mode.
+    std::mutex syncloopReactorLock;     //!< Lock for syncloopReactorActive.
+    std::condition_variable syncloopReactorCondition; //!< Notified when the loop stops running in reactor mode.
+
+    MessageQueue <miniMessages, 256> m_queue; //!< Message queue, lock-free. Filled by any thread, emptied by the controller's thread.
+    std::atomic <int> m_control;        //!< Pending ctrl_state_pause or ctrl_state_stop request, or -1. Never queued, so it can't be lost when the queue is full.
+    std::priority_queue <miniMessages, std::vector <miniMessages>, miniMessagesDeadline> m_timers; //!< Delayed messages, waiting for their deadline. Only used by the controller's thread.
 
-    std::vector <Servo *> servoList;    //!< List containing device object managed by this controller.
-    std::mutex servoListLock;           //!< Lock for the device list.
+    ServoRegistry servoRegistry;        //!< Device objects managed by this controller, indexed by ID, with their sync and "full" register update lists.
+    std::mutex servoListLock;           //!< Lock for the device registry.
 
-    std::vector <int> updateList;       //!< List of device object marked for a "full" register update.
-    std::vector <int> syncList;         //!< List of device object to keep in sync.
+    RegisterCache registerCache;        //!< Optional on-disk cache of the devices EEPROM images.
+
+    PollingPlan pollingPlan;            //!< Registers read by the synchronization loop, for every device without its own plan.
+    std::map <int, PollingPlan> pollingPlans; //!< Per device polling plans, indexed by device ID.
+    std::mutex pollingLock;             //!< Lock for the polling plans.
+    std::atomic <bool> pollingChanged;  //!< Set when a polling plan has been modified.
+    PollingSchedule pollingSchedule;    //!< Registers to read during each cycle, built from the polling plans. Only used by the controller's thread.
+    unsigned pollingRevision = 0;       //!< Revision of the synchronization list used by the polling schedule.
+    int pollingFrequency = 0;           //!< Synchronization loop frequency used by the polling schedule.
+
+    std::function <void (double)> syncloopCallback; //!< Called at the end of every synchronization loop cycle.
 
     //! Read/write synchronization loop, running inside its own background thread
-    virtual void run() = 0;
+    void run();
+
+    /*!
+     * \brief Messages parsing, actions and initial reads of a synchronization loop cycle.
+     * \return false if the loop must end (pause or stop request).
+     *
+     * Blocking, it uses the serial link directly. Ends the phase_messages,
+     * phase_actions and phase_initial_read phases.
+     */
+    virtual bool syncloopMaintenance() = 0;
+
+    /*!
+     * \brief Register writes and feedback reads of a synchronization loop cycle, using blocking transactions.
+     */
+    virtual void syncloopSynchronize() = 0;
+
+    /*!
+     * \brief Register writes and feedback reads of a synchronization loop cycle, submitted to the reactor.
+     * \param done: To be called once every transaction of the cycle is complete.
+     * \return false if nothing has been submitted, and syncloopSynchronize() must be used for this cycle.
+     */
+    virtual bool syncloopSubmit(std::function <void ()> done) = 0;
+
+    /*!
+     * \brief Submit the transactions of a cycle to the reactor.
+     * \param transactions: The transactions, in order. Consecutive transactions without response are merged.
+     * \param done: Called once every transaction callback has been called.
+     *
+     * Round-trip times are added to syncloopTransactionTimes(). A transaction
+     * that cannot be submitted completes right away with COMM_TXFAIL.
+     */
+    void syncloopSubmitTransactions(std::vector <SerialTransaction> &transactions, std::function <void ()> done);
+
+    //! Round-trip times of the transactions done during the current cycle.
+    virtual TimingHistogram &syncloopTransactionTimes() = 0;
+
+    //! Serial port used by the controller, to register it to the reactor.
+    virtual SerialPort *serialGetPort_wrapper() = 0;
+
+    /*!
+     * \brief Prepare the synchronization loop. Must be called from the controller's thread, before the first cycle.
+     *
+     * Apply the real-time priority and CPU affinity settings to the calling
+     * thread, and start the cycle schedule from the current time.
+     */
+    void syncloopStart();
+
+    /*!
+     * \brief Wait for the beginning of the next synchronization loop cycle.
+     *
+     * Cycles are scheduled on absolute deadlines of the monotonic clock, so
+     * the time spent inside a cycle, or waking up late, does not accumulate
+     * into a drift. Overruns are handled following syncloopOverrunPolicy.
+     */
+    void syncloopWait();
+
+    /*!
+     * \brief Move the schedule to the beginning of the next synchronization loop cycle.
+     * \return The beginning of the next cycle, in nanoseconds from the monotonic clock.
+     *
+     * Overruns are handled following syncloopOverrunPolicy.
+     */
+    int64_t syncloopNextDeadline();
+
+    /*!
+     * \brief Mark the beginning of a synchronization loop cycle (and of its first phase).
+     */
+    void syncloopCycleBegin();
+
+    /*!
+     * \brief Mark the end of a synchronization loop cycle phase. The next phase begins right away.
+     * \param phase: The phase ending, see syncloopPhase_e.
+     */
+    void syncloopPhaseEnd(const int phase);
+
+    /*!
+     * \brief Mark the end of a synchronization loop cycle, and publish its timings.
+     * \param transactionTimes: Round-trip times of the transactions done during this cycle. Emptied after use.
+     * \return The duration of the cycle, in milliseconds.
+     *
+     * The statistics lock is only taken once per cycle, here.
+     */
+    double syncloopCycleEnd(TimingHistogram &transactionTimes);
+
+    /*!
+     * \brief Close a synchronization loop cycle: publish its timings and call the cycle callback.
+     */
+    void syncloopCycleFinish();
+
+    /*!
+     * \brief Build the polling schedule again if needed. Must be called from the controller's thread.
+     *
+     * The schedule is only built again when a polling plan, the list of
+     * synchronized devices, or the synchronization loop frequency changed.
+     */
+    void syncloopUpdatePolling();
+
+    /*!
+     * \brief Check that a synchronization loop cycle fits into its period. Must be called from the controller's thread.
+     *
+     * The bus time is only estimated again when the list of synchronized devices
+     * changed, once their initial read is done. If it exceeds SYNCLOOP_BUDGET_RATIO
+     * of the requested period, a warning is issued and, with the 'budget_adapt'
+     * policy, the frequency is lowered.
+     */
+    void syncloopCheckBudget();
+
+    /*!
+     * \brief Estimate the time a synchronization loop cycle spends on the serial link.
+     * \return The bus time of an average cycle, in milliseconds.
+     *
+     * Computed from the devices currently synchronized, the size of the packets
+     * exchanged with them, the serial link speed and the devices return delay.
+     * Called with servoListLock held.
+     */
+    virtual double estimateCycleDuration() = 0;
 
     /*!
      * \brief Internal thread messaging system.
      * \param m: A pointer to a miniMessages structure. Will be copied.
      *
-     * Push a message into the back of a deque (if the thread is running, otherwise
-     * messages will be discarded with an error).
+     * Push a message into the back of a lock-free queue (if the thread is running,
+     * otherwise messages will be discarded with an error). Never blocks: if the
+     * queue is full the message is discarded with an error.
+     * A message with a 'delay' in the future will only be received once its
+     * deadline has passed.
+     *
+     * ctrl_state_pause and ctrl_state_stop are not queued but set a dedicated
+     * flag, so they are never discarded (the caller then waits for the thread).
      */
     void sendMessage(miniMessages *m);
 
+    /*!
+     * \brief Get the next message to process. Must only be called from the controller's thread.
+     * \param[out] m: The message.
+     * \return true if a message has been received, false if there is nothing to process right now.
+     *
+     * A pause or stop request comes first. Delayed messages are parked inside a
+     * timer heap, and are returned once their deadline has passed.
+     */
+    bool receiveMessage(miniMessages &m);
+
     void registerServo_internal(Servo *servo);
     void unregisterServo_internal(Servo *servo);
     void unregisterServos_internal();
-    int delayedAddServos_internal(std::chrono::time_point<std::chrono::system_clock> delay, int id, int update);
+    void delayedAddServos_internal(int id, int update);
     virtual void autodetect_internal(int start = 0, int stop = 253) = 0;
 
     /*!
@@ -132,6 +387,34 @@ protected:
      */
     void stopThread();
 
+    //! Start the synchronization loop, from the reactor or inside a new thread.
+    void syncloopLaunch();
+
+    //! Wait for the synchronization loop to end, after a pause or stop request.
+    void syncloopJoin();
+
+    //! true if the synchronization loop is running, from its thread or from the reactor.
+    bool syncloopRunning();
+
+    /*!
+     * \brief Check if the next cycle has some maintenance to do (see syncloopMaintenance()).
+     *
+     * In reactor mode, cycles without maintenance don't need the worker thread.
+     */
+    bool syncloopMaintenanceNeeded();
+
+    //! Register the serial port to the shared reactor, and schedule the first cycle.
+    bool syncloopReactorStart();
+
+    //! One synchronization loop cycle in reactor mode, run from the reactor thread.
+    void syncloopReactorCycle();
+
+    //! Second half of a reactor mode cycle: register writes and feedback reads.
+    void syncloopReactorSync();
+
+    //! Unregister the serial port from the reactor, and wake the threads waiting for the loop to end.
+    void syncloopReactorEnd();
+
     /*!
      * \brief Change the current state of the controller.
      */
@@ -146,7 +429,7 @@ protected:
 public:
     /*!
      * \brief ControllerAPI constructor.
-     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;120].
+     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;1000].
      */
     ControllerAPI(int ctrlFrequency);
 
@@ -211,7 +494,126 @@ public:
     virtual void serialSetLatency_wrapper(int latency) = 0;
 
     /*!
-     * \brief clearMessageQueue
+     * \brief Use a cache file to store the EEPROM registers of the devices managed by this controller.
+     * \param path: Path to the cache file. Use an empty path to disable the cache (default).
+     *
+     * When a device is registered, its cached EEPROM image is verified with one
+     * small read (model number, firmware version, ID, baud rate...) and used
+     * instead of reading the whole EEPROM area. Cached images are invalidated
+     * when the controller writes an EEPROM register.
+     */
+    void setRegisterCacheFile(const std::string &path);
+
+    /*!
+     * \brief Set a function to call at the end of every synchronization loop cycle.
+     * \param callback: Called from the controller's thread with the duration (in millisecond) of the cycle, without the sleep time.
+     *
+     * Must be set before connect(). Keep it short, it runs inside the synchronization loop.
+     */
+    void setSyncLoopCallback(std::function <void (double duration_ms)> callback);
+
+    /*!
+     * \brief Set what the synchronization loop does when a cycle overruns its period.
+     * \param policy: See syncloopOverrun_e. Default is overrun_skip.
+     */
+    void setOverrunPolicy(const int policy);
+
+    /*!
+     * \brief Run the synchronization loop with the SCHED_FIFO real-time scheduling policy.
+     * \param priority: SCHED_FIFO priority [1;99], or 0 to keep the default scheduling.
+     *
+     * Must be set before connect(). Needs the appropriate privileges (CAP_SYS_NICE
+     * or an 'rtprio' limit), a warning is issued if the priority cannot be applied.
+     * Not available on Windows.
+     */
+    void setRealtimePriority(const int priority);
+
+    /*!
+     * \brief Pin the synchronization loop thread on a CPU.
+     * \param cpu: CPU index, or -1 for no affinity (default).
+     *
+     * Must be set before connect(). Only available on Linux.
+     */
+    void setCpuAffinity(const int cpu);
+
+    /*!
+     * \brief Run the synchronization loop from the reactor shared by every controller in that mode.
+     * \param enable: true to use the shared reactor, false to use a thread (default).
+     *
+     * Must be set before connect(). Only available on Linux, with a regular
+     * serial port. The register writes and feedback reads of every controller
+     * are then multiplexed by one I/O thread, and the rare blocking work
+     * (scans, initial reads, actions) is done by one worker thread. This keeps
+     * a large number of buses running with two threads instead of one per bus.
+     * Real-time priority and CPU affinity settings are ignored in this mode.
+     */
+    void setReactorMode(const bool enable);
+
+    /*!
+     * \brief Set what the controller does when the requested frequency cannot be sustained by the serial link.
+     * \param policy: See syncloopBudget_e. Default is budget_warn.
+     *
+     * Must be set before connect().
+     * The bus time needed by a cycle is estimated from the baudrate, the number
+     * of devices and the size of the packets exchanged with them.
+     */
+    void setBudgetPolicy(const int policy);
+
+    /*!
+     * \brief Set the registers read from every device by the synchronization loop, and how often.
+     * \param plan: The polling plan. Devices with their own plan are not affected.
+     *
+     * Each controller starts with a default plan: the current position on every
+     * cycle, a few feedback registers every 4 cycles, voltage and temperature at 1 Hz.
+     * Can be called while the controller is running.
+     */
+    void setPollingPlan(const PollingPlan &plan);
+
+    /*!
+     * \brief Set the registers read from one device by the synchronization loop, and how often.
+     * \param id: The device ID.
+     * \param plan: The polling plan, replacing the controller's plan for this device.
+     *
+     * Can be called while the controller is running.
+     */
+    void setPollingPlan(const int id, const PollingPlan &plan);
+
+    /*!
+     * \brief Use the controller's polling plan again for a device.
+     * \param id: The device ID.
+     */
+    void resetPollingPlan(const int id);
+
+    /*!
+     * \brief Get the polling plan used for a device.
+     * \param id: The device ID, or -1 for the controller's plan.
+     * \return A copy of the polling plan.
+     */
+    PollingPlan getPollingPlan(const int id = -1);
+
+    /*!
+     * \brief Get the frequency of the synchronization loop.
+     * \return The frequency in Hz. Can be lower than the requested one with the 'budget_adapt' policy.
+     */
+    int getSyncLoopFrequency();
+
+    /*!
+     * \brief Get the timing statistics of the synchronization loop.
+     * \return A copy of the statistics, accumulated since the controller creation or the last resetSyncLoopStats().
+     *
+     * Always available, and cheap enough to be called periodically to monitor
+     * the loop health: per-cycle and per-phase durations, overruns, period
+     * jitter and transactions round-trip time.
+     */
+    SyncLoopStats getSyncLoopStats();
+
+    /*!
+     * \brief Reset the timing statistics of the synchronization loop.
+     */
+    void resetSyncLoopStats();
+
+    /*!
+     * \brief Discard every pending message, delayed ones included. The controller's thread must not be running.
      */
     void clearMessageQueue();
 
@@ -24,6 +24,8 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -154,20 +156,28 @@ int Dynamixel::serialInitialize(std::string &devicePath, const int baud)
         serialTerminate();
     }
 
-    // Instanciate a different serial subclass, depending on the current OS
+    // Instanciate a different serial subclass, depending on the current OS,
+    // or connect to an emulated bus
+    if (devicePath.compare(0, strlen(VIRTUAL_PORT_PREFIX), VIRTUAL_PORT_PREFIX) == 0)
+    {
+        serial = new SerialPortVirtual(devicePath, baud, serialDevice, servoSerie);
+    }
+    else
+    {
 #if defined(FEATURE_QTSERIAL)
-    //serial = new SerialPortQt(devicePath, baud, serialDevice, servoSerie);
+        //serial = new SerialPortQt(devicePath, baud, serialDevice, servoSerie);
 #else
 #if defined(__linux__) || defined(__gnu_linux)
-    serial = new SerialPortLinux(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortLinux(devicePath, baud, serialDevice, servoSerie);
 #elif defined(_WIN32) || defined(_WIN64)
-    serial = new SerialPortWindows(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortWindows(devicePath, baud, serialDevice, servoSerie);
 #elif defined(__APPLE__) || defined(__MACH__)
-    serial = new SerialPortMacOS(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortMacOS(devicePath, baud, serialDevice, servoSerie);
 #else
     #error "No compatible operating system detected!"
 #endif
 #endif
+    }
 
     // Initialize the serial link
     if (serial != nullptr)
@@ -202,6 +212,11 @@ void Dynamixel::serialTerminate()
     }
 }
 
+SerialPort *Dynamixel::serialGetPort()
+{
+    return serial;
+}
+
 std::string Dynamixel::serialGetCurrentDevice()
 {
     std::string serialName;
@@ -239,6 +254,31 @@ void Dynamixel::serialSetLatency(int latency)
     serial->setLatency(latency);
 }
 
+int Dynamixel::serialGetLatency()
+{
+    return serial->getLatency();
+}
+
+double Dynamixel::serialGetByteTransfertTime()
+{
+    if (serial == nullptr)
+    {
+        return 0.0;
+    }
+
+    return serial->getByteTransfertTime();
+}
+
+bool Dynamixel::serialSwitchHighSpeed()
+{
+    return serial->switchHighSpeed();
+}
+
+bool Dynamixel::serialSetRS485(const bool enable, const int delayBeforeSend, const int delayAfterSend, const bool rtsOnSend)
+{
+    return serial->setRS485(enable, delayBeforeSend, delayAfterSend, rtsOnSend);
+}
+
 void Dynamixel::setAckPolicy(int ack)
 {
     if (ackPolicy >= ACK_NO_REPLY && ack <= ACK_REPLY_ALL)
@@ -251,7 +291,7 @@ void Dynamixel::setAckPolicy(int ack)
     }
 }
 
-void Dynamixel::dxl_tx_packet()
+void Dynamixel::dxl_tx_packet(const bool batch)
 {
     if (serial == nullptr)
     {
@@ -281,8 +321,30 @@ void Dynamixel::dxl_tx_packet()
     dxl_checksum_packet();
 
     // Send packet
-    unsigned char txPacketSize = dxl_get_txpacket_size();
-    unsigned char txPacketSizeSent = 0;
+    int txPacketSize = dxl_get_txpacket_size();
+    int txPacketSizeSent = 0;
+
+    // Packets without status are only queued, and sent all at once later
+    if (batch == true)
+    {
+        if (static_cast<int>(txBatch.size()) + txPacketSize > MAX_TX_BATCH_SIZE &&
+            dxl_tx_batch_write() == false)
+        {
+            commLock = 0;
+            return;
+        }
+
+        txBatch.insert(txBatch.end(), txPacket, txPacket + txPacketSize);
+        commStatus = COMM_TXSUCCESS;
+        return;
+    }
+
+    // Packets queued before this one must be sent first
+    if (dxl_tx_batch_write() == false)
+    {
+        commLock = 0;
+        return;
+    }
 
     if (serial != nullptr)
     {
@@ -306,7 +368,7 @@ void Dynamixel::dxl_tx_packet()
     if (protocolVersion == PROTOCOL_DXLv2)
     {
         // 11 is the min size of a v2 status packet
-        if (txPacket[PKT1_INSTRUCTION] == INST_READ)
+        if (txPacket[PKT2_INSTRUCTION] == INST_READ)
         {
             serial->setTimeOut(11 + make_short_word(txPacket[PKT2_PARAMETER+2], txPacket[PKT2_PARAMETER+3]));
         }
@@ -346,8 +408,10 @@ void Dynamixel::dxl_rx_packet()
     }
 
     // Packet sent to a broadcast address? No need to wait for a status packet.
-    if ((protocolVersion == PROTOCOL_DXLv1 && txPacket[PKT1_ID] == BROADCAST_ID) ||
-        (protocolVersion == PROTOCOL_DXLv2 && txPacket[PKT2_ID] == BROADCAST_ID))
+    // (unless it is a 'Sync Read' or 'Bulk Read' instruction)
+    if (rxMultiplePackets == false &&
+        ((protocolVersion == PROTOCOL_DXLv1 && txPacket[PKT1_ID] == BROADCAST_ID) ||
+         (protocolVersion == PROTOCOL_DXLv2 && txPacket[PKT2_ID] == BROADCAST_ID)))
     {
         commStatus = COMM_RXSUCCESS;
         commLock = 0;
@@ -395,60 +459,11 @@ void Dynamixel::dxl_rx_packet()
     }
 
     // Find packet header
-    unsigned char i, j;
-    if (protocolVersion == PROTOCOL_DXLv2)
+    int headerOffset = dxl_find_header(rxPacket, rxPacketSizeReceived);
+    if (headerOffset > 0)
     {
-        for (i = 0; i < (rxPacketSizeReceived - 1); i++)
-        {
-            if (rxPacket[i] == 0xFF &&
-                rxPacket[i+1] == 0xFF &&
-                rxPacket[i+2] == 0xFD &&
-                rxPacket[i+3] == 0x00)
-            {
-                break;
-            }
-            else if (i == (rxPacketSizeReceived - 2) &&
-                     rxPacket[rxPacketSizeReceived-1] == 0xFF)
-            {
-                break;
-            }
-        }
-
-        if (i > 0)
-        {
-            for (j = 0; j < (rxPacketSizeReceived-i); j++)
-            {
-                rxPacket[j] = rxPacket[j + i];
-            }
-
-            rxPacketSizeReceived -= i;
-        }
-    }
-    else
-    {
-        for (i = 0; i < (rxPacketSizeReceived - 1); i++)
-        {
-            if (rxPacket[i] == 0xFF &&
-                rxPacket[i+1] == 0xFF)
-            {
-                break;
-            }
-            else if (i == (rxPacketSizeReceived - 2) &&
-                     rxPacket[rxPacketSizeReceived-1] == 0xFF)
-            {
-                break;
-            }
-        }
-
-        if (i > 0)
-        {
-            for (j = 0; j < (rxPacketSizeReceived-i); j++)
-            {
-                rxPacket[j] = rxPacket[j + i];
-            }
-
-            rxPacketSizeReceived -= i;
-        }
+        memmove(rxPacket, rxPacket + headerOffset, rxPacketSizeReceived - headerOffset);
+        rxPacketSizeReceived -= headerOffset;
     }
 
     // Incomplete packet?
@@ -459,8 +474,10 @@ void Dynamixel::dxl_rx_packet()
     }
 
     // Check ID pairing
-    if (((protocolVersion == PROTOCOL_DXLv1) && (txPacket[PKT1_ID] != rxPacket[PKT1_ID])) ||
-        ((protocolVersion == PROTOCOL_DXLv2) && (txPacket[PKT2_ID] != rxPacket[PKT2_ID])))
+    // (status packets of a 'Sync Read' or 'Bulk Read' instruction are paired by dxl_txrx_multiple_packets())
+    if (rxMultiplePackets == false &&
+        (((protocolVersion == PROTOCOL_DXLv1) && (txPacket[PKT1_ID] != rxPacket[PKT1_ID])) ||
+         ((protocolVersion == PROTOCOL_DXLv2) && (txPacket[PKT2_ID] != rxPacket[PKT2_ID]))))
     {
         commStatus = COMM_RXCORRUPT;
         commLock = 0;
@@ -515,13 +532,39 @@ void Dynamixel::dxl_rx_packet()
 
 void Dynamixel::dxl_txrx_packet(int ack)
 {
+    // Round-trip timer, for the transactions expecting a status packet
+    std::chrono::time_point<std::chrono::steady_clock> rttStart = std::chrono::steady_clock::now();
+
 #ifdef LATENCY_TIMER
     // Latency timer for a complete transaction (instruction sent and status received)
     std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
     start = std::chrono::high_resolution_clock::now();
 #endif
 
-    dxl_tx_packet();
+    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we just sent
+    if (ack == ACK_DEFAULT)
+    {
+        ack = ackPolicy;
+    }
+
+    int cmd = 0, id = 0;
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        cmd = txPacket[PKT2_INSTRUCTION];
+        id = txPacket[PKT2_ID];
+    }
+    else
+    {
+        cmd = txPacket[PKT1_INSTRUCTION];
+        id = txPacket[PKT1_ID];
+    }
+
+    bool reply = dxl_status_expected(ack, cmd, id);
+
+    // Batch mode: packets without status are queued until dxl_tx_batch_end()
+    bool batch = txBatching && (reply == false || id == BROADCAST_ID);
+
+    dxl_tx_packet(batch);
 
     if (commStatus != COMM_TXSUCCESS)
     {
@@ -529,118 +572,712 @@ void Dynamixel::dxl_txrx_packet(int ack)
         return;
     }
 
-    // Depending on 'ackPolicy' value and current instruction, we wait for an answer to the packet we just sent
+    if (reply == true && batch == false)
+    {
+        do {
+            dxl_rx_packet();
+        }
+        while (commStatus == COMM_RXWAITING);
+
+        transactionTimes.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - rttStart).count());
+    }
+    else
+    {
+        commStatus = COMM_RXSUCCESS;
+        commLock = 0;
+    }
+
+#ifdef PACKET_DEBUGGER
+    printTxPacket();
+    printRxPacket();
+#endif
+
+#ifdef LATENCY_TIMER
+    end = std::chrono::high_resolution_clock::now();
+    int loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
+    TRACE_1(DXL, "TX > RX loop: %iµs", loopd);
+#endif
+}
+
+bool Dynamixel::dxl_tx_batch_write()
+{
+    if (txBatch.empty() == true)
+    {
+        return true;
+    }
+
+    int txBatchSize = static_cast<int>(txBatch.size());
+    int txBatchSizeSent = 0;
+
+    if (serial != nullptr)
+    {
+        txBatchSizeSent = serial->tx(txBatch.data(), txBatchSize);
+    }
+
+    txBatch.clear();
+
+    if (txBatchSizeSent != txBatchSize)
+    {
+        TRACE_ERROR(DXL, "Unable to send %i batched bytes on serial link: '%s'", txBatchSize, serialGetCurrentDevice().c_str());
+        commStatus = COMM_TXFAIL;
+        return false;
+    }
+
+    return true;
+}
+
+void Dynamixel::dxl_tx_batch_begin()
+{
+    txBatching = true;
+}
+
+void Dynamixel::dxl_tx_batch_end()
+{
+    while(commLock);
+    commLock = 1;
+
+    commStatus = COMM_TXSUCCESS;
+    dxl_tx_batch_write();
+    txBatching = false;
+
+    commLock = 0;
+}
+
+int Dynamixel::dxl_txrx_multiple_packets(BulkReadEntry *entries, const int count)
+{
+    int received = 0;
+    std::chrono::time_point<std::chrono::steady_clock> rttStart = std::chrono::steady_clock::now();
+
+    dxl_tx_packet();
+
+    if (commStatus != COMM_TXSUCCESS)
+    {
+        TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'", serialGetCurrentDevice().c_str());
+
+        for (int i = 0; i < count; i++)
+        {
+            entries[i].commStatus = commStatus;
+        }
+        commLock = 0;
+
+        return received;
+    }
+
+    // Min size of a status packet, without data
+    const int statusPacketSize = (protocolVersion == PROTOCOL_DXLv2) ? 11 : 6;
+
+    rxMultiplePackets = true;
+
+    for (int i = 0; i < count; i++)
+    {
+        // Each servo answers in turn, so every status packet gets its own timeout
+        commLock = 1;
+        commStatus = COMM_TXSUCCESS;
+        serial->setTimeOut(statusPacketSize + entries[i].size);
+
+        do {
+            dxl_rx_packet();
+        }
+        while (commStatus == COMM_RXWAITING);
+
+        if (commStatus != COMM_RXSUCCESS)
+        {
+            entries[i].commStatus = commStatus;
+            continue;
+        }
+
+        if (dxl_rx_multiple_entry(entries, count, i))
+        {
+            received++;
+        }
+    }
+
+    rxMultiplePackets = false;
+    commLock = 0;
+
+    transactionTimes.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - rttStart).count());
+
+    // Report the communication status of the whole transaction
+    commStatus = (received == count) ? COMM_RXSUCCESS : COMM_RXTIMEOUT;
+
+    return received;
+}
+
+bool Dynamixel::dxl_rx_multiple_entry(BulkReadEntry *entries, const int count, int &index)
+{
+    // Match the status packet with its entry. If some servos did not answer,
+    // the packet may come from a servo further in the list.
+    int id = (protocolVersion == PROTOCOL_DXLv2) ? rxPacket[PKT2_ID] : rxPacket[PKT1_ID];
+    int k = index;
+    while (k < count && entries[k].id != id)
+    {
+        k++;
+    }
+
+    if (k >= count)
+    {
+        entries[index].commStatus = COMM_RXCORRUPT;
+        return false;
+    }
+
+    for (; index < k; index++)
+    {
+        entries[index].commStatus = COMM_RXTIMEOUT;
+    }
+
+    // Check the amount of data received
+    int dataSize = dxl_get_rxpacket_length_field() - ((protocolVersion == PROTOCOL_DXLv2) ? 4 : 2);
+    if (dataSize != entries[index].size)
+    {
+        entries[index].commStatus = COMM_RXCORRUPT;
+        return false;
+    }
+
+    for (int j = 0; j < dataSize; j++)
+    {
+        entries[index].data[j] = static_cast<unsigned char>(dxl_get_rxpacket_parameter(j));
+    }
+    entries[index].error = dxl_get_rxpacket_error();
+    entries[index].commStatus = COMM_RXSUCCESS;
+
+    return true;
+}
+
+bool Dynamixel::dxl_status_expected(int ack, const int instruction, const int id)
+{
     if (ack == ACK_DEFAULT)
     {
         ack = ackPolicy;
     }
 
-    if (ack != ACK_NO_REPLY)
+    // 'Sync Read' and 'Bulk Read' instructions are sent to the broadcast ID,
+    // but every servo addressed answers in turn
+    if (instruction == INST_SYNC_READ || instruction == INST_BULK_READ)
     {
-        int cmd = 0;
-        if (protocolVersion == PROTOCOL_DXLv2)
+        return (ack != ACK_NO_REPLY);
+    }
+
+    if (id == BROADCAST_ID)
+    {
+        return false;
+    }
+
+    return (ack == ACK_REPLY_ALL) || (ack == ACK_REPLY_READ && instruction == INST_READ);
+}
+
+bool Dynamixel::dxl_get_transaction(SerialTransaction &transaction, const int ack)
+{
+    if (dxl_validate_packet() == 0)
+    {
+        return false;
+    }
+    dxl_checksum_packet();
+
+    const bool v2 = (protocolVersion == PROTOCOL_DXLv2);
+    const int instruction = v2 ? txPacket[PKT2_INSTRUCTION] : txPacket[PKT1_INSTRUCTION];
+    const int id = v2 ? txPacket[PKT2_ID] : txPacket[PKT1_ID];
+    const int statusPacketSize = v2 ? 11 : 6;
+
+    transaction.request.assign(txPacket, txPacket + dxl_get_txpacket_size());
+    transaction.responseLength = 0;
+    transaction.frame = nullptr;
+
+    if (dxl_status_expected(ack, instruction, id) == false)
+    {
+        return true;
+    }
+
+    // Exact size of the status packet(s) expected
+    int count = 1;
+    int length = statusPacketSize;
+
+    if (instruction == INST_READ)
+    {
+        length += v2 ? make_short_word(txPacket[PKT2_PARAMETER+2], txPacket[PKT2_PARAMETER+3]) : txPacket[PKT1_PARAMETER+1];
+    }
+    else if (instruction == INST_SYNC_READ)
+    {
+        count = dxl_get_txpacket_length_field() - 7;
+        length = count * (statusPacketSize + make_short_word(txPacket[PKT2_PARAMETER+2], txPacket[PKT2_PARAMETER+3]));
+    }
+    else if (instruction == INST_BULK_READ)
+    {
+        length = 0;
+
+        if (v2)
         {
-            cmd = txPacket[PKT2_INSTRUCTION];
+            count = (dxl_get_txpacket_length_field() - 3) / 5;
+            for (int i = 0; i < count; i++)
+            {
+                length += statusPacketSize + make_short_word(txPacket[PKT2_PARAMETER + i*5 + 3], txPacket[PKT2_PARAMETER + i*5 + 4]);
+            }
         }
         else
         {
-            cmd = txPacket[PKT1_INSTRUCTION];
+            count = (dxl_get_txpacket_length_field() - 3) / 3;
+            for (int i = 0; i < count; i++)
+            {
+                length += statusPacketSize + txPacket[PKT1_PARAMETER + 1 + i*3];
+            }
+        }
+    }
+
+    // Leave some room for garbage bytes before the first header
+    transaction.responseLength = length + statusPacketSize;
+    transaction.frame = [this, count](const unsigned char *data, const int size) {
+        return dxl_frame_status(data, size, count);
+    };
+
+    return true;
+}
+
+int Dynamixel::dxl_frame_status(const unsigned char *data, const int size, const int count)
+{
+    const bool v2 = (protocolVersion == PROTOCOL_DXLv2);
+    const int statusPacketSize = v2 ? 11 : 6;
+    int offset = 0;
+
+    for (int i = 0; i < count; i++)
+    {
+        offset += dxl_find_header(data + offset, size - offset);
+
+        if (size - offset < statusPacketSize)
+        {
+            return 0;
+        }
+
+        const unsigned char *packet = data + offset;
+        int lengthField = v2 ? make_short_word(packet[PKT2_LENGTH_L], packet[PKT2_LENGTH_H]) : packet[PKT1_LENGTH];
+        int packetSize = lengthField + (v2 ? 7 : 4);
+
+        if (packetSize < statusPacketSize || packetSize > MAX_PACKET_LENGTH_dxlv1)
+        {
+            return -1;
+        }
+
+        if (size - offset < packetSize)
+        {
+            return 0;
         }
 
-        if ((ack == ACK_REPLY_ALL) ||
-            (ack == ACK_REPLY_READ && cmd == INST_READ))
+        if (v2)
         {
-            do {
-                dxl_rx_packet();
+            unsigned short crc = dxl2_checksum_packet(packet, packetSize);
+
+            if (packet[packetSize - 2] != get_lowbyte(crc) ||
+                packet[packetSize - 1] != get_highbyte(crc))
+            {
+                return -1;
             }
-            while (commStatus == COMM_RXWAITING);
         }
         else
         {
-            commStatus = COMM_RXSUCCESS;
-            commLock = 0;
+            if (packet[packetSize - 1] != dxl1_checksum_packet(packet, lengthField))
+            {
+                return -1;
+            }
         }
+
+        offset += packetSize;
     }
-    else
+
+    return offset;
+}
+
+int Dynamixel::dxl_rx_status(const SerialTransaction &transaction, const int status, const std::vector <unsigned char> &response)
+{
+    // Put the instruction packet back, for the error reporting functions
+    size_t txSize = (transaction.request.size() < sizeof(txPacket)) ? transaction.request.size() : sizeof(txPacket);
+    std::copy(transaction.request.begin(), transaction.request.begin() + txSize, txPacket);
+
+    commStatus = status;
+    rxPacketSize = 0;
+
+    if (status == COMM_RXSUCCESS && response.empty() == false)
     {
-        commStatus = COMM_RXSUCCESS;
+        int offset = dxl_find_header(response.data(), static_cast<int>(response.size()));
+        int size = static_cast<int>(response.size()) - offset;
+
+        if (size > static_cast<int>(sizeof(rxPacket)))
+        {
+            size = sizeof(rxPacket);
+        }
+
+        std::copy(response.begin() + offset, response.begin() + offset + size, rxPacket);
+        rxPacketSize = size;
+
+        // Check ID pairing
+        if (((protocolVersion == PROTOCOL_DXLv1) && (txPacket[PKT1_ID] != rxPacket[PKT1_ID])) ||
+            ((protocolVersion == PROTOCOL_DXLv2) && (txPacket[PKT2_ID] != rxPacket[PKT2_ID])))
+        {
+            commStatus = COMM_RXCORRUPT;
+        }
+    }
+
+    return commStatus;
+}
+
+int Dynamixel::dxl_rx_multiple_status(const int status, const std::vector <unsigned char> &response, BulkReadEntry *entries, const int count)
+{
+    const int packetOverhead = (protocolVersion == PROTOCOL_DXLv2) ? 7 : 4;
+    int received = 0;
+    int i = 0;
+
+    // Servos that did not answer leave an incomplete response: use the status packets received anyway
+    if (status != COMM_TXFAIL)
+    {
+        const unsigned char *data = response.data();
+        int size = static_cast<int>(response.size());
+
+        for (; i < count && size > 0; i++)
+        {
+            int framed = dxl_frame_status(data, size, 1);
+            if (framed == 0)
+            {
+                break;
+            }
+            if (framed < 0)
+            {
+                entries[i].commStatus = COMM_RXCORRUPT;
+                i++;
+                break;
+            }
+
+            int offset = dxl_find_header(data, size);
+            std::copy(data + offset, data + framed, rxPacket);
+            rxPacketSize = dxl_get_rxpacket_length_field() + packetOverhead;
+
+            if (dxl_rx_multiple_entry(entries, count, i))
+            {
+                received++;
+            }
+
+            data += framed;
+            size -= framed;
+        }
+    }
+
+    for (; i < count; i++)
+    {
+        entries[i].commStatus = (status == COMM_TXFAIL) ? COMM_TXFAIL : COMM_RXTIMEOUT;
+    }
+
+    // Report the communication status of the whole transaction
+    commStatus = (received == count) ? COMM_RXSUCCESS : COMM_RXTIMEOUT;
+
+    return received;
+}
+
+int Dynamixel::dxl_broadcast_ping(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &responses)
+{
+    int found = 0;
+
+    while(commLock);
+
+    txPacket[PKT2_ID] = BROADCAST_ID;
+    txPacket[PKT2_INSTRUCTION] = INST_PING;
+    txPacket[PKT2_LENGTH_L] = 3;
+    txPacket[PKT2_LENGTH_H] = 0;
+
+    dxl_tx_packet();
+
+    if (commStatus != COMM_TXSUCCESS)
+    {
+        TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'", serialGetCurrentDevice().c_str());
         commLock = 0;
+        return found;
     }
 
-#ifdef PACKET_DEBUGGER
-    printTxPacket();
-    printRxPacket();
-#endif
+    // Size of a ping status packet
+    const int statusPacketSize = 14;
 
-#ifdef LATENCY_TIMER
-    end = std::chrono::high_resolution_clock::now();
-    int loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
-    TRACE_1(DXL, "TX > RX loop: %iµs", loopd);
-#endif
+    rxMultiplePackets = true;
+
+    // Servos answer in ID order, each one in its own time slot, so we keep
+    // receiving status packets until the slots of every ID that can still be
+    // reported are over, then until nothing comes in for a few packet durations
+    int lastId = -1;
+
+    for (int i = 0; i < BROADCAST_ID; i++)
+    {
+        commLock = 1;
+        commStatus = COMM_TXSUCCESS;
+
+        if (lastId < stop)
+        {
+            double slot = BROADCAST_PING_SLOT_TIME + serial->getByteTransfertTime() * statusPacketSize;
+            serial->setTimeOut(slot * (stop - lastId) + 2.0 * serial->getLatency());
+        }
+        else
+        {
+            serial->setTimeOut(statusPacketSize * BROADCAST_PING_QUIET_PACKETS);
+        }
+
+        do {
+            dxl_rx_packet();
+        }
+        while (commStatus == COMM_RXWAITING);
+
+        if (commStatus == COMM_RXTIMEOUT)
+        {
+            break;
+        }
+        else if (commStatus != COMM_RXSUCCESS)
+        {
+            continue;
+        }
+
+        if (rxPacket[PKT2_INSTRUCTION] != INST_STATUS ||
+            dxl_get_rxpacket_length_field() != 7)
+        {
+            continue;
+        }
+
+        int id = rxPacket[PKT2_ID];
+        if (id > lastId)
+        {
+            lastId = id;
+        }
+
+        if (id >= start && id <= stop)
+        {
+            PingResponse pingstats;
+            pingstats.model_number = make_short_word(rxPacket[PKT2_PARAMETER+1], rxPacket[PKT2_PARAMETER+2]);
+            pingstats.firmware_version = rxPacket[PKT2_PARAMETER+3];
+
+            ids.push_back(id);
+            responses.push_back(pingstats);
+            found++;
+        }
+    }
+
+    rxMultiplePackets = false;
+    commLock = 0;
+
+    // The quiet period always ends with a timeout, which is expected here
+    commStatus = (found > 0) ? COMM_RXSUCCESS : COMM_RXTIMEOUT;
+
+    return found;
+}
+
+// Low level API
+////////////////////////////////////////////////////////////////////////////////
+
+void Dynamixel::dxl_set_txpacket_header()
+{
+    txPacket[PKT1_HEADER0] = 0xFF;
+    txPacket[PKT1_HEADER1] = 0xFF;
+
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        txPacket[PKT2_HEADER2] = 0xFD;
+        txPacket[PKT2_RESERVED] = 0x00;
+    }
+}
+
+void Dynamixel::dxl_set_txpacket_id(int id)
+{
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        txPacket[PKT2_ID] = get_lowbyte(id);
+    }
+    else
+    {
+        txPacket[PKT1_ID] = get_lowbyte(id);
+    }
+}
+
+void Dynamixel::dxl_set_txpacket_length_field(int length)
+{
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        txPacket[PKT2_LENGTH_L] = get_lowbyte(length);
+        txPacket[PKT2_LENGTH_H] = get_highbyte(length);
+    }
+    else
+    {
+        txPacket[PKT1_LENGTH] = get_lowbyte(length);
+    }
+}
+
+void Dynamixel::dxl_set_txpacket_instruction(int instruction)
+{
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        txPacket[PKT2_INSTRUCTION] = get_lowbyte(instruction);
+    }
+    else
+    {
+        txPacket[PKT1_INSTRUCTION] = get_lowbyte(instruction);
+    }
 }
 
-// Low level API
-////////////////////////////////////////////////////////////////////////////////
-
-void Dynamixel::dxl_set_txpacket_header()
+void Dynamixel::dxl_set_txpacket_parameter(int index, int value)
 {
-    txPacket[PKT1_HEADER0] = 0xFF;
-    txPacket[PKT1_HEADER1] = 0xFF;
-
     if (protocolVersion == PROTOCOL_DXLv2)
     {
-        txPacket[PKT2_HEADER2] = 0xFD;
-        txPacket[PKT2_RESERVED] = 0x00;
+        txPacket[PKT2_PARAMETER+index] = get_lowbyte(value);
+    }
+    else
+    {
+        txPacket[PKT1_PARAMETER+index] = get_lowbyte(value);
     }
 }
 
-void Dynamixel::dxl_set_txpacket_id(int id)
+int Dynamixel::dxl_set_read_packet(const int id, const int address, const int length)
 {
+    // Status packet overhead is 6 bytes with protocol v1, 11 bytes with v2
+    const int chunkMaxSize = MAX_PACKET_LENGTH_dxlv1 - ((protocolVersion == PROTOCOL_DXLv2) ? 11 : 6);
+    const int chunkSize = (length > chunkMaxSize) ? chunkMaxSize : length;
+
     if (protocolVersion == PROTOCOL_DXLv2)
     {
         txPacket[PKT2_ID] = get_lowbyte(id);
+        txPacket[PKT2_INSTRUCTION] = INST_READ;
+        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
+        txPacket[PKT2_PARAMETER+2] = get_lowbyte(chunkSize);
+        txPacket[PKT2_PARAMETER+3] = get_highbyte(chunkSize);
+        txPacket[PKT2_LENGTH_L] = 7;
+        txPacket[PKT2_LENGTH_H] = 0;
     }
     else
     {
         txPacket[PKT1_ID] = get_lowbyte(id);
+        txPacket[PKT1_INSTRUCTION] = INST_READ;
+        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT1_PARAMETER+1] = get_lowbyte(chunkSize);
+        txPacket[PKT1_LENGTH] = 4;
     }
+
+    return chunkSize;
 }
 
-void Dynamixel::dxl_set_txpacket_length_field(int length)
+int Dynamixel::dxl_set_write_packet(const int id, const int address, const int length, const unsigned char *data)
 {
+    // Instruction packet overhead is 7 bytes with protocol v1, 12 bytes with v2
+    const int chunkMaxSize = MAX_PACKET_LENGTH_dxlv1 - ((protocolVersion == PROTOCOL_DXLv2) ? 12 : 7);
+    const int chunkSize = (length > chunkMaxSize) ? chunkMaxSize : length;
+
     if (protocolVersion == PROTOCOL_DXLv2)
     {
-        txPacket[PKT2_LENGTH_L] = get_lowbyte(length);
-        txPacket[PKT2_LENGTH_H] = get_highbyte(length);
+        txPacket[PKT2_ID] = get_lowbyte(id);
+        txPacket[PKT2_INSTRUCTION] = INST_WRITE;
+        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
+        memcpy(&txPacket[PKT2_PARAMETER+2], data, chunkSize);
+        txPacket[PKT2_LENGTH_L] = get_lowbyte(chunkSize + 5);
+        txPacket[PKT2_LENGTH_H] = get_highbyte(chunkSize + 5);
     }
     else
     {
-        txPacket[PKT1_LENGTH] = get_lowbyte(length);
+        txPacket[PKT1_ID] = get_lowbyte(id);
+        txPacket[PKT1_INSTRUCTION] = INST_WRITE;
+        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
+        memcpy(&txPacket[PKT1_PARAMETER+1], data, chunkSize);
+        txPacket[PKT1_LENGTH] = get_lowbyte(chunkSize + 3);
     }
+
+    return chunkSize;
 }
 
-void Dynamixel::dxl_set_txpacket_instruction(int instruction)
+int Dynamixel::dxl_set_sync_write_packet(const std::vector <int> &ids, const std::vector <int> &values, const int first, const int address, const int size)
 {
+    // Maximum number of (id, data) tuples that can fit inside one packet
+    // v1 packet overhead is 8 bytes (header, id, length, instruction, address, data length, checksum)
+    // v2 packet overhead is 14 bytes (header, id, length, instruction, address, data length, crc)
+    const int overhead = (protocolVersion == PROTOCOL_DXLv2) ? 14 : 8;
+    const int tuplesPerPacket = (MAX_PACKET_LENGTH_dxlv1 - overhead) / (size + 1);
+
+    int count = static_cast<int>(ids.size()) - first;
+    if (count > tuplesPerPacket)
+    {
+        count = tuplesPerPacket;
+    }
+
+    unsigned char *tuple = nullptr;
+
     if (protocolVersion == PROTOCOL_DXLv2)
     {
-        txPacket[PKT2_INSTRUCTION] = get_lowbyte(instruction);
+        int length = 7 + count * (size + 1);
+
+        txPacket[PKT2_ID] = BROADCAST_ID;
+        txPacket[PKT2_INSTRUCTION] = INST_SYNC_WRITE;
+        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
+        txPacket[PKT2_PARAMETER+2] = get_lowbyte(size);
+        txPacket[PKT2_PARAMETER+3] = 0;
+        txPacket[PKT2_LENGTH_L] = get_lowbyte(length);
+        txPacket[PKT2_LENGTH_H] = get_highbyte(length);
+
+        tuple = &txPacket[PKT2_PARAMETER+4];
     }
     else
     {
-        txPacket[PKT1_INSTRUCTION] = get_lowbyte(instruction);
+        txPacket[PKT1_ID] = BROADCAST_ID;
+        txPacket[PKT1_INSTRUCTION] = INST_SYNC_WRITE;
+        txPacket[PKT1_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT1_PARAMETER+1] = get_lowbyte(size);
+        txPacket[PKT1_LENGTH] = get_lowbyte(4 + count * (size + 1));
+
+        tuple = &txPacket[PKT1_PARAMETER+2];
+    }
+
+    for (int i = first; i < first + count; i++)
+    {
+        *tuple++ = get_lowbyte(ids[i]);
+        for (int j = 0; j < size; j++)
+        {
+            *tuple++ = static_cast<unsigned char>((values[i] >> (8*j)) & 0xFF);
+        }
     }
+
+    return count;
 }
 
-void Dynamixel::dxl_set_txpacket_parameter(int index, int value)
+int Dynamixel::dxl_set_bulk_read_packet(const BulkReadEntry *entries, const int count)
 {
+    // v1 packet overhead is 7 bytes (header, id, length, instruction, 0x00, checksum), then 3 bytes per servo
+    // v2 packet overhead is 10 bytes (header, id, length, instruction, crc), then 5 bytes per servo
+    const int entriesPerPacket = (protocolVersion == PROTOCOL_DXLv2) ?
+                                 (MAX_PACKET_LENGTH_dxlv1 - 10) / 5 :
+                                 (MAX_PACKET_LENGTH_dxlv1 - 7) / 3;
+    const int packed = (count > entriesPerPacket) ? entriesPerPacket : count;
+
     if (protocolVersion == PROTOCOL_DXLv2)
     {
-        txPacket[PKT2_PARAMETER+index] = get_lowbyte(value);
+        txPacket[PKT2_ID] = BROADCAST_ID;
+        txPacket[PKT2_INSTRUCTION] = INST_BULK_READ;
+        txPacket[PKT2_LENGTH_L] = get_lowbyte(3 + packed*5);
+        txPacket[PKT2_LENGTH_H] = get_highbyte(3 + packed*5);
+
+        for (int i = 0; i < packed; i++)
+        {
+            const BulkReadEntry &e = entries[i];
+            txPacket[PKT2_PARAMETER + i*5] = get_lowbyte(e.id);
+            txPacket[PKT2_PARAMETER + i*5 + 1] = get_lowbyte(e.address);
+            txPacket[PKT2_PARAMETER + i*5 + 2] = get_highbyte(e.address);
+            txPacket[PKT2_PARAMETER + i*5 + 3] = get_lowbyte(e.size);
+            txPacket[PKT2_PARAMETER + i*5 + 4] = get_highbyte(e.size);
+        }
     }
     else
     {
-        txPacket[PKT1_PARAMETER+index] = get_lowbyte(value);
+        txPacket[PKT1_ID] = BROADCAST_ID;
+        txPacket[PKT1_INSTRUCTION] = INST_BULK_READ;
+        txPacket[PKT1_PARAMETER] = 0x00;
+        txPacket[PKT1_LENGTH] = get_lowbyte(3 + packed*3);
+
+        for (int i = 0; i < packed; i++)
+        {
+            const BulkReadEntry &e = entries[i];
+            txPacket[PKT1_PARAMETER + 1 + i*3] = get_lowbyte(e.size);
+            txPacket[PKT1_PARAMETER + 1 + i*3 + 1] = get_lowbyte(e.id);
+            txPacket[PKT1_PARAMETER + 1 + i*3 + 2] = get_lowbyte(e.address);
+        }
     }
+
+    return packed;
 }
 
 void Dynamixel::dxl_checksum_packet()
@@ -665,11 +1302,11 @@ void Dynamixel::dxl_checksum_packet()
     }
 }
 
-unsigned char Dynamixel::dxl1_checksum_packet(unsigned char *packetData, const int packetLengthField)
+unsigned char Dynamixel::dxl1_checksum_packet(const unsigned char *packetData, const int packetLengthField)
 {
     unsigned char checksum = 0;
 
-    for (unsigned char i = 0; i < (packetLengthField + 1); i++) // 'length field + 1': whut
+    for (int i = 0; i < (packetLengthField + 1); i++) // 'length field + 1': whut
     {
         checksum += packetData[i+2];
     }
@@ -678,7 +1315,7 @@ unsigned char Dynamixel::dxl1_checksum_packet(unsigned char *packetData, const i
     return checksum;
 }
 
-unsigned short Dynamixel::dxl2_checksum_packet(unsigned char *packetData, const int packetSize)
+unsigned short Dynamixel::dxl2_checksum_packet(const unsigned char *packetData, const int packetSize)
 {
     unsigned short crc = 0;
     unsigned short i = 0, j = 0;
@@ -692,6 +1329,30 @@ unsigned short Dynamixel::dxl2_checksum_packet(unsigned char *packetData, const
     return crc;
 }
 
+int Dynamixel::dxl_find_header(const unsigned char *packetData, const int packetSize)
+{
+    static const unsigned char header[4] = {0xFF, 0xFF, 0xFD, 0x00};
+    const int headerSize = (protocolVersion == PROTOCOL_DXLv2) ? 4 : 2;
+
+    int i = 0;
+    for (i = 0; i < packetSize; i++)
+    {
+        int j = 0;
+        while (j < headerSize && (i + j) < packetSize && packetData[i + j] == header[j])
+        {
+            j++;
+        }
+
+        // Complete header, or the beginning of a header at the end of the buffer
+        if (j == headerSize || (i + j) == packetSize)
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
 int Dynamixel::dxl_get_txpacket_length_field()
 {
     int size = -1;
@@ -760,7 +1421,9 @@ int Dynamixel::dxl1_validate_packet()
         txPacket[PKT1_INSTRUCTION] != INST_WRITE &&
         txPacket[PKT1_INSTRUCTION] != INST_REG_WRITE &&
         txPacket[PKT1_INSTRUCTION] != INST_ACTION &&
-        txPacket[PKT1_INSTRUCTION] != INST_SYNC_READ)
+        txPacket[PKT1_INSTRUCTION] != INST_SYNC_READ &&
+        txPacket[PKT1_INSTRUCTION] != INST_SYNC_WRITE &&
+        txPacket[PKT1_INSTRUCTION] != INST_BULK_READ)
     {
         commStatus = COMM_TXERROR;
         commLock = 0;
@@ -877,6 +1540,25 @@ int Dynamixel::dxl_get_rxpacket_parameter(int index)
     return value;
 }
 
+int Dynamixel::dxl_get_rxpacket_data(unsigned char *buffer, const int length)
+{
+    // A status packet carrying an error can come without the data asked
+    int dataSize = dxl_get_rxpacket_length_field() - ((protocolVersion == PROTOCOL_DXLv2) ? 4 : 2);
+    if (dataSize != length)
+    {
+        TRACE_ERROR(DXL, "[#%i] %i byte(s) received instead of %i", dxl_get_last_packet_id(), dataSize, length);
+        commStatus = COMM_RXCORRUPT;
+        return commStatus;
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        buffer[i] = static_cast<unsigned char>(dxl_get_rxpacket_parameter(i));
+    }
+
+    return length;
+}
+
 int Dynamixel::dxl_get_last_packet_id()
 {
     int id = 0;
@@ -1387,3 +2069,275 @@ void Dynamixel::dxl_write_word(const int id, const int address, const int value,
 
     dxl_txrx_packet(ack);
 }
+
+int Dynamixel::dxl_read_block(const int id, const int address, const int length, unsigned char *buffer, const int ack)
+{
+    int retcode = -1;
+
+    if (id == 254)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Read' instruction to broadcast address!");
+    }
+    else if (ack == ACK_NO_REPLY || (ack == ACK_DEFAULT && ackPolicy == ACK_NO_REPLY))
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Read' instruction if ACK_NO_REPLY is set!");
+    }
+    else if (length < 1 || buffer == nullptr)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Read' instruction: invalid block length '%i'!", length);
+    }
+    else
+    {
+        retcode = 0;
+
+        while (retcode < length)
+        {
+            while(commLock);
+
+            int chunkSize = dxl_set_read_packet(id, address + retcode, length - retcode);
+
+            dxl_txrx_packet(ack);
+
+            if (commStatus != COMM_RXSUCCESS ||
+                dxl_get_rxpacket_data(&buffer[retcode], chunkSize) != chunkSize)
+            {
+                retcode = commStatus;
+                break;
+            }
+
+            retcode += chunkSize;
+        }
+    }
+
+    return retcode;
+}
+
+void Dynamixel::dxl_write_block(const int id, const int address, const int length, const unsigned char *buffer, const int ack)
+{
+    if (length < 1 || buffer == nullptr)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Write' instruction: invalid block length '%i'!", length);
+        return;
+    }
+
+    for (int written = 0; written < length;)
+    {
+        while(commLock);
+
+        int chunkSize = dxl_set_write_packet(id, address + written, length - written, &buffer[written]);
+
+        dxl_txrx_packet(ack);
+
+        if (commStatus < 0)
+        {
+            break;
+        }
+        written += chunkSize;
+    }
+}
+
+void Dynamixel::dxl_sync_write(const std::vector <int> &ids, const int address, const std::vector <int> &values, const int size)
+{
+    if (ids.empty() || ids.size() != values.size())
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Sync Write' instruction: %i ids for %i values!",
+                    static_cast<int>(ids.size()), static_cast<int>(values.size()));
+        return;
+    }
+
+    if (size != 1 && size != 2 && size != 4)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Sync Write' instruction: invalid data size '%i'!", size);
+        return;
+    }
+
+    const int tuplesCount = static_cast<int>(ids.size());
+
+    for (int first = 0; first < tuplesCount;)
+    {
+        while(commLock);
+
+        first += dxl_set_sync_write_packet(ids, values, first, address, size);
+
+        // Broadcast instruction: no status packet will be returned
+        dxl_txrx_packet(ACK_NO_REPLY);
+    }
+}
+
+void Dynamixel::dxl_sync_write_byte(const std::vector <int> &ids, const int address, const std::vector <int> &values)
+{
+    dxl_sync_write(ids, address, values, 1);
+}
+
+void Dynamixel::dxl_sync_write_word(const std::vector <int> &ids, const int address, const std::vector <int> &values)
+{
+    dxl_sync_write(ids, address, values, 2);
+}
+
+int Dynamixel::dxl_sync_read(const std::vector <int> &ids, const int address, const int size, std::vector <BulkReadEntry> &results)
+{
+    results.resize(ids.size());
+
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        results[i].id = ids[i];
+        results[i].address = address;
+        results[i].size = size;
+        results[i].commStatus = COMM_UNKNOWN;
+        results[i].error = 0;
+    }
+
+    // No 'Sync Read' with protocol v1, emulate it with a 'Bulk Read'
+    if (protocolVersion != PROTOCOL_DXLv2)
+    {
+        return dxl_bulk_read(results);
+    }
+
+    if (ids.empty())
+    {
+        return 0;
+    }
+
+    if (size < 1 || size > MAX_BULK_READ_SIZE)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Sync Read' instruction: invalid data size '%i'!", size);
+        return 0;
+    }
+
+    if (ackPolicy == ACK_NO_REPLY)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Sync Read' instruction if ACK_NO_REPLY is set!");
+        return 0;
+    }
+
+    // v2 'Sync Read' packet overhead is 14 bytes (header, id, length, instruction, address, data length, crc), then 1 byte per ID
+    const int idsPerPacket = MAX_PACKET_LENGTH_dxlv1 - 14;
+    const int idsCount = static_cast<int>(ids.size());
+    int received = 0;
+
+    for (int first = 0; first < idsCount; first += idsPerPacket)
+    {
+        int count = idsCount - first;
+        if (count > idsPerPacket)
+        {
+            count = idsPerPacket;
+        }
+
+        while(commLock);
+
+        txPacket[PKT2_ID] = BROADCAST_ID;
+        txPacket[PKT2_INSTRUCTION] = INST_SYNC_READ;
+        txPacket[PKT2_PARAMETER] = get_lowbyte(address);
+        txPacket[PKT2_PARAMETER+1] = get_highbyte(address);
+        txPacket[PKT2_PARAMETER+2] = get_lowbyte(size);
+        txPacket[PKT2_PARAMETER+3] = get_highbyte(size);
+        txPacket[PKT2_LENGTH_L] = get_lowbyte(7 + count);
+        txPacket[PKT2_LENGTH_H] = get_highbyte(7 + count);
+
+        for (int i = 0; i < count; i++)
+        {
+            txPacket[PKT2_PARAMETER+4+i] = get_lowbyte(ids[first + i]);
+        }
+
+        received += dxl_txrx_multiple_packets(&results[first], count);
+    }
+
+    return received;
+}
+
+int Dynamixel::dxl_bulk_read(std::vector <BulkReadEntry> &entries)
+{
+    if (entries.empty())
+    {
+        return 0;
+    }
+
+    for (const auto &e: entries)
+    {
+        if (e.size < 1 || e.size > MAX_BULK_READ_SIZE)
+        {
+            TRACE_ERROR(DXL, "Cannot send 'Bulk Read' instruction: invalid data size '%i' for [#%i]!", e.size, e.id);
+            return 0;
+        }
+    }
+
+    if (ackPolicy == ACK_NO_REPLY)
+    {
+        TRACE_ERROR(DXL, "Cannot send 'Bulk Read' instruction if ACK_NO_REPLY is set!");
+        return 0;
+    }
+
+    const int entriesCount = static_cast<int>(entries.size());
+    int received = 0;
+
+    for (int first = 0; first < entriesCount;)
+    {
+        while(commLock);
+
+        int count = dxl_set_bulk_read_packet(&entries[first], entriesCount - first);
+
+        received += dxl_txrx_multiple_packets(&entries[first], count);
+        first += count;
+    }
+
+    return received;
+}
+
+int Dynamixel::dxl_scan(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &responses)
+{
+    ids.clear();
+    responses.clear();
+
+    if (serial == nullptr)
+    {
+        TRACE_ERROR(DXL, "Serial interface is not initialized!");
+        return 0;
+    }
+
+    if (protocolVersion == PROTOCOL_DXLv2)
+    {
+        return dxl_broadcast_ping(start, stop, ids, responses);
+    }
+
+    // Protocol v1 has no broadcast ping. Only wait for the transfer of one status
+    // packet, the default 'return delay' (0.5ms) and the serial port latency.
+    const double pingTimeout = serial->getByteTransfertTime() * 6.0 + 0.5 + static_cast<double>(serial->getLatency());
+
+    for (int id = start; id <= stop && id < BROADCAST_ID; id++)
+    {
+        while(commLock);
+
+        txPacket[PKT1_ID] = get_lowbyte(id);
+        txPacket[PKT1_INSTRUCTION] = INST_PING;
+        txPacket[PKT1_LENGTH] = 2;
+
+        dxl_tx_packet();
+
+        if (commStatus != COMM_TXSUCCESS)
+        {
+            TRACE_ERROR(DXL, "Unable to send TX packet on serial link: '%s'", serialGetCurrentDevice().c_str());
+            commLock = 0;
+            break;
+        }
+
+        serial->setTimeOut(pingTimeout);
+
+        do {
+            dxl_rx_packet();
+        }
+        while (commStatus == COMM_RXWAITING);
+
+        if (commStatus == COMM_RXSUCCESS)
+        {
+            // Emulate ping response from protocol v2
+            PingResponse pingstats;
+            pingstats.model_number = dxl_read_word(id, 0);
+            pingstats.firmware_version = dxl_read_byte(id, 2);
+
+            ids.push_back(id);
+            responses.push_back(pingstats);
+        }
+    }
+
+    return static_cast<int>(ids.size());
+}
@@ -27,18 +27,67 @@
 #include "SerialPortLinux.h"
 #include "SerialPortWindows.h"
 #include "SerialPortMacOS.h"
+#include "SerialPortVirtual.h"
+#include "SerialPortReactor.h"
 
 #include "Utils.h"
 #include "ControlTables.h"
 #include "DynamixelTools.h"
+#include "TimingHistogram.h"
 
 #include <string>
 #include <vector>
 
+/*!
+ * \brief Maximum number of bytes that can be read from one servo with a 'Sync Read' or 'Bulk Read' instruction.
+ *
+ * Each status packet must fit into the RX buffer (MAX_PACKET_LENGTH_dxlv1).
+ */
+#define MAX_BULK_READ_SIZE    (128)
+
+/*!
+ * \brief Quiet period ending a broadcast 'Ping' scan, expressed in number of ping status packets.
+ *
+ * The serial port latency time is added on top of it, like for any other timeout.
+ */
+#define BROADCAST_PING_QUIET_PACKETS    (4)
+
+/*!
+ * \brief Time slot (in millisecond) used by each ID to answer a broadcast 'Ping'.
+ *
+ * Protocol v2 devices answer in ID order, a device waiting for the slots of
+ * every lower ID, even missing ones. The reference SDK allows up to 3 ms per ID.
+ * A scan of the IDs up to 'stop' can thus last up to (stop + 1) slots: about
+ * 65 ms up to ID 20, and 0.8 s for the whole [0;252] range at 1 Mbps.
+ */
+#define BROADCAST_PING_SLOT_TIME        (3.0)
+
+/*!
+ * \brief Maximum number of bytes queued by the TX batch mode before being sent.
+ */
+#define MAX_TX_BATCH_SIZE    (1024)
+
+/*!
+ * \brief One servo entry of a 'Sync Read' or 'Bulk Read' transaction.
+ *
+ * 'id', 'address' and 'size' describe the request, the other fields are filled
+ * with the content of the status packet returned by the servo (if any).
+ */
+struct BulkReadEntry
+{
+    int id = 0;                         //!< The servo ID.
+    int address = 0;                    //!< Address of the first register to read.
+    int size = 0;                       //!< Number of bytes to read, in ]0;MAX_BULK_READ_SIZE].
+
+    int commStatus = COMM_UNKNOWN;      //!< COMM_RXSUCCESS if a status packet has been received for this servo, the communication error otherwise.
+    int error = 0;                      //!< Error field of the status packet.
+    unsigned char data[MAX_BULK_READ_SIZE] = {0}; //!< Raw bytes read, starting at 'address'.
+};
+
 /*!
  * \brief The Dynamixel communication protocols implementation
  * \todo Rename to DynamixelProtocol
- * \todo Handle "sync" and "bulk" read/write operations.
+ * \todo Handle "bulk" write operations.
  *
  * This class provide the low level API to handle communication with servos.
  * It can generate instruction packets and send them over a serial link. This class
@@ -67,12 +116,58 @@ private:
      */
     int commLock = 0;
     int commStatus = COMM_RXSUCCESS;//!< Last communication status
+    bool rxMultiplePackets = false; //!< Set while receiving the status packets of a 'Sync Read' or 'Bulk Read' instruction
+
+    bool txBatching = false;        //!< Set while the TX batch mode is enabled
+    std::vector <unsigned char> txBatch; //!< Packets without status queued by the TX batch mode
+
+    //! Send every packet queued by the TX batch mode with a single write. Must be called with 'commLock' held.
+    //! Return false, with commStatus set to COMM_TXFAIL, if they could not be sent.
+    bool dxl_tx_batch_write();
 
     // Serial communication methods, using one of the SerialPort[Linux/Mac/Windows] implementations.
-    void dxl_tx_packet();
+    void dxl_tx_packet(const bool batch = false);
     void dxl_rx_packet();
     void dxl_txrx_packet(int ack);
 
+    /*!
+     * \brief Send the 'Sync Read' or 'Bulk Read' instruction packet currently in the TX buffer, then receive one status packet per entry.
+     * \param entries: The entries addressed by the instruction packet, in the order the servos will answer.
+     * \param count: The number of entries.
+     * \return The number of status packets successfully received.
+     *
+     * A servo that doesn't answer doesn't prevent the following ones from being
+     * received: each status packet gets its own timeout, and a status packet
+     * coming from a servo further in the list marks the skipped entries as timed out.
+     */
+    int dxl_txrx_multiple_packets(BulkReadEntry *entries, const int count);
+
+    /*!
+     * \brief Match the status packet in the RX buffer with its 'Sync Read' or 'Bulk Read' entry.
+     * \param entries: The entries addressed by the instruction packet, in the order the servos will answer.
+     * \param count: The number of entries.
+     * \param index: The entry expected to answer. Moved to the entry the status packet belongs to.
+     * \return true if the entry has been filled with the status packet data.
+     *
+     * Entries skipped because their servo did not answer are marked as timed out.
+     */
+    bool dxl_rx_multiple_entry(BulkReadEntry *entries, const int count, int &index);
+
+    /*!
+     * \brief Send one 'Ping' instruction to the broadcast ID, then collect every status packet until the bus stays quiet.
+     * \param start: First ID to be reported.
+     * \param stop: Last ID to be reported.
+     * \param ids: The IDs of the servos that answered.
+     * \param responses: The ping responses of the servos that answered (in the same order as 'ids').
+     * \return The number of servos found.
+     *
+     * While IDs up to 'stop' can still answer, the scan waits for the slots
+     * (BROADCAST_PING_SLOT_TIME) of every one of them, so a gap of missing IDs
+     * doesn't end it early.
+     * Only available with protocol v2.
+     */
+    int dxl_broadcast_ping(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &responses);
+
 protected:
     Dynamixel();
     virtual ~Dynamixel() = 0;
@@ -84,6 +179,8 @@ protected:
     int maxId = 252;                        //!< Store in the maximum value for servo IDs.
     int ackPolicy = ACK_REPLY_ALL;          //!< Set the status/ack packet return policy using '::AckPolicy_e' (0: No return; 1: Return for READ commands; 2: Return for all commands).
 
+    TimingHistogram transactionTimes;       //!< Round-trip time (in microseconds) of the transactions expecting status packet(s).
+
     // Handle serial link
     ////////////////////////////////////////////////////////////////////////////
 
@@ -100,6 +197,12 @@ protected:
      */
     void serialTerminate();
 
+    /*!
+     * \brief Get the serial port in use, to drive it from a SerialPortReactor.
+     * \return The serial port instance, or nullptr if the serial link is not initialized.
+     */
+    SerialPort *serialGetPort();
+
     // Low level API
     ////////////////////////////////////////////////////////////////////////////
 
@@ -110,9 +213,41 @@ protected:
     void dxl_set_txpacket_instruction(int instruction);
     void dxl_set_txpacket_parameter(int index, int value);
 
+    /*!
+     * \brief Build a 'Read' instruction packet into the TX buffer.
+     * \return The number of bytes requested, less than 'length' if they don't fit into one status packet.
+     */
+    int dxl_set_read_packet(const int id, const int address, const int length);
+
+    /*!
+     * \brief Build a 'Write' instruction packet into the TX buffer.
+     * \return The number of bytes packed, less than 'length' if they don't fit into one instruction packet.
+     */
+    int dxl_set_write_packet(const int id, const int address, const int length, const unsigned char *data);
+
+    /*!
+     * \brief Build a 'Sync Write' instruction packet into the TX buffer, starting with the tuple at index 'first'.
+     * \return The number of (id, value) tuples packed.
+     */
+    int dxl_set_sync_write_packet(const std::vector <int> &ids, const std::vector <int> &values, const int first, const int address, const int size);
+
+    /*!
+     * \brief Build a 'Bulk Read' instruction packet into the TX buffer.
+     * \return The number of entries packed, less than 'count' if they don't fit into one instruction packet.
+     */
+    int dxl_set_bulk_read_packet(const BulkReadEntry *entries, const int count);
+
     void dxl_checksum_packet();    //!< Generate and write a checksum of tx packet payload
-    unsigned char dxl1_checksum_packet(unsigned char *packetData, const int packetLengthField);
-    unsigned short dxl2_checksum_packet(unsigned char *packetData, const int packetSize);
+    unsigned char dxl1_checksum_packet(const unsigned char *packetData, const int packetLengthField);
+    unsigned short dxl2_checksum_packet(const unsigned char *packetData, const int packetSize);
+
+    /*!
+     * \brief Find the beginning of a packet header into a buffer.
+     * \param packetData: The buffer to search, usually the RX buffer.
+     * \param packetSize: The number of valid bytes in the buffer.
+     * \return The offset of the header. A partial header at the end of the buffer counts as a header. 'packetSize' if no header was found.
+     */
+    int dxl_find_header(const unsigned char *packetData, const int packetSize);
 
     // TX packet analysis
     int dxl_get_txpacket_size();
@@ -127,6 +262,64 @@ protected:
     int dxl_get_rxpacket_length_field();
     int dxl_get_rxpacket_parameter(int index);
 
+    /*!
+     * \brief Copy the data carried by the status packet in the RX buffer.
+     * \param buffer: The buffer where the data will be copied. Must be at least 'length' bytes long.
+     * \param length: The number of bytes expected.
+     * \return 'length', or COMM_RXCORRUPT if the status packet doesn't carry that many bytes.
+     */
+    int dxl_get_rxpacket_data(unsigned char *buffer, const int length);
+
+    // Asynchronous transactions, see SerialPortReactor
+    ////////////////////////////////////////////////////////////////////////////
+
+    /*!
+     * \brief Check if an instruction packet will be answered with status packet(s).
+     * \param ack: Ack policy in effect.
+     * \param instruction: The instruction.
+     * \param id: The ID the instruction packet is sent to.
+     * \return true if at least one status packet is expected.
+     */
+    bool dxl_status_expected(int ack, const int instruction, const int id);
+
+    /*!
+     * \brief Turn the instruction packet in the TX buffer into a transaction.
+     * \param transaction: Filled with the packet, and the size and framing of the status packet(s) expected.
+     * \param ack: Ack policy in effect.
+     * \return false if the instruction packet is invalid.
+     */
+    bool dxl_get_transaction(SerialTransaction &transaction, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Find 'count' consecutive status packets in a buffer, and check their checksums.
+     * \param data: The bytes received.
+     * \param size: The number of bytes received.
+     * \param count: The number of status packets expected.
+     * \return The size of the status packets (bytes before the first header included), 0 if more bytes are needed, or -1 if a status packet is invalid.
+     */
+    int dxl_frame_status(const unsigned char *data, const int size, const int count);
+
+    /*!
+     * \brief Load the outcome of a transaction, like dxl_txrx_packet() would have left it.
+     * \param transaction: The transaction, with its instruction packet.
+     * \param status: The transaction status.
+     * \param response: The status packet received, framed by dxl_frame_status().
+     * \return The communication status (also available from dxl_get_com_status()).
+     *
+     * The RX buffer then holds the status packet, for the usual accessors.
+     */
+    int dxl_rx_status(const SerialTransaction &transaction, const int status, const std::vector <unsigned char> &response);
+
+    /*!
+     * \brief Dispatch the status packets of a 'Sync Read' or 'Bulk Read' transaction to their entries.
+     * \param status: The transaction status.
+     * \param response: The status packets received.
+     * \param entries: The entries addressed by the instruction packet.
+     * \param count: The number of entries.
+     * \return The number of status packets successfully received.
+     */
+    int dxl_rx_multiple_status(const int status, const std::vector <unsigned char> &response, BulkReadEntry *entries, const int count);
+
     // Debug methods
     int dxl_get_last_packet_id();
     int dxl_get_com_status();       //!< Get communication status (commStatus) of the latest TX/RX instruction
@@ -157,20 +350,111 @@ protected:
     void dxl_write_byte(const int id, const int address, const int value, const int ack = ACK_DEFAULT);
     int dxl_read_word(const int id, const int address, const int ack = ACK_DEFAULT);
     void dxl_write_word(const int id, const int address, const int value, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Read a contiguous range of registers.
+     * \param id: The servo to read from.
+     * \param address: The address of the first register to read.
+     * \param length: The number of bytes to read.
+     * \param buffer: The buffer where the raw bytes read will be copied. Must be at least 'length' bytes long.
+     * \param ack: Ack policy in effect.
+     * \return The number of bytes read, or the communication error code (< 0) if one of the reads failed.
+     *
+     * Ranges that don't fit into one status packet are read using several consecutive 'Read' instructions.
+     */
+    int dxl_read_block(const int id, const int address, const int length, unsigned char *buffer, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Write a contiguous range of registers.
+     * \param id: The servo to write to.
+     * \param address: The address of the first register to write.
+     * \param length: The number of bytes to write.
+     * \param buffer: The raw bytes to write. Must be at least 'length' bytes long.
+     * \param ack: Ack policy in effect.
+     *
+     * Ranges that don't fit into one instruction packet are written using several consecutive 'Write' instructions.
+     */
+    void dxl_write_block(const int id, const int address, const int length, const unsigned char *buffer, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Write the same register on several servos, using one 'Sync Write' instruction.
+     * \param ids: The servos to write to.
+     * \param address: The address of the register to write (same for every servo).
+     * \param values: The value to write for each servo, in the same order as 'ids'.
+     * \param size: The size of the register in bytes. Can be 1, 2 or 4.
+     *
+     * Sync write packets are sent to the broadcast address, so no status packet
+     * will ever be returned. If the tuples do not fit into one packet, several
+     * consecutive 'Sync Write' instructions are sent.
+     */
+    void dxl_sync_write(const std::vector <int> &ids, const int address, const std::vector <int> &values, const int size);
+    void dxl_sync_write_byte(const std::vector <int> &ids, const int address, const std::vector <int> &values);
+    void dxl_sync_write_word(const std::vector <int> &ids, const int address, const std::vector <int> &values);
+
+    /*!
+     * \brief Read the same registers on several servos, using one 'Sync Read' instruction.
+     * \param ids: The servos to read from.
+     * \param address: The address of the first register to read (same for every servo).
+     * \param size: The number of bytes to read on each servo.
+     * \param results: One entry per servo (in the same order as 'ids') holding the bytes read and the communication status.
+     * \return The number of servos that successfully answered.
+     *
+     * 'Sync Read' is only available with protocol v2. With protocol v1, a 'Bulk Read'
+     * instruction (MX series and newer firmwares only) is used instead.
+     */
+    int dxl_sync_read(const std::vector <int> &ids, const int address, const int size, std::vector <BulkReadEntry> &results);
+
+    /*!
+     * \brief Read different registers on several servos, using one 'Bulk Read' instruction.
+     * \param entries: The 'id', 'address' and 'size' fields describe what to read on each servo. Results will be written into the other fields.
+     * \return The number of servos that successfully answered.
+     *
+     * Each servo must appear only once in a 'Bulk Read' instruction.
+     * With protocol v1, 'Bulk Read' is only supported by MX series (and newer firmwares).
+     */
+    int dxl_bulk_read(std::vector <BulkReadEntry> &entries);
+
+    /*!
+     * \brief Scan a range of IDs for devices, using the fastest method available with the current protocol.
+     * \param start: First ID to be scanned.
+     * \param stop: Last ID to be scanned.
+     * \param ids: The IDs of the servos found.
+     * \param responses: The ping responses of the servos found (in the same order as 'ids').
+     * \return The number of servos found.
+     *
+     * With protocol v2, a single broadcast 'Ping' is sent and every servo answers
+     * in its own ID slot. The scan waits for the slots of the IDs up to 'stop',
+     * not for one timeout per missing ID: a full [0;252] scan lasts about 0.8 s
+     * (instead of several seconds), a scan up to ID 20 a few tens of milliseconds.
+     * See BROADCAST_PING_SLOT_TIME.
+     * With protocol v1, IDs are pinged one by one, but each ping only waits for
+     * the duration of one status packet (plus return delay and serial latency)
+     * instead of the regular timeout.
+     */
+    int dxl_scan(const int start, const int stop, std::vector <int> &ids, std::vector <PingResponse> &responses);
+
+    /*!
+     * \brief Enable TX batch mode.
+     *
+     * While enabled, instruction packets that will not get a status packet (because
+     * of the ack policy, or sent to the broadcast ID) are queued into one buffer
+     * instead of being written one by one. The queue is sent with a single write
+     * by dxl_tx_batch_end(), or before any packet expecting a status packet.
+     */
+    void dxl_tx_batch_begin();
+
+    /*!
+     * \brief Send the queued packets and disable TX batch mode.
+     *
+     * commStatus is set to COMM_TXFAIL if the queued packets could not be sent.
+     */
+    void dxl_tx_batch_end();
 /*
     // TODO // Reg write
     void dxl_reg_write(const int id, ???)
 
-    // TODO // Sync read/write register instructions
-    std::vector <int> dxl_sync_read_byte(std::vector <int> ids, int address);
-    void dxl_sync_write_byte(std::vector <int> ids, int address, int value);
-    std::vector <int> dxl_sync_read_word(std::vector <int> ids, int address);
-    void dxl_sync_write_word(std::vector <int> ids, int address, int value);
-
-    // TODO // Bulk read/write register instructions
-    std::vector <int> dxl_bulk_read_byte(std::vector <int> ids, int address);
+    // TODO // Bulk write register instructions
     void dxl_bulk_write_byte(std::vector <int> ids, int address, int value);
-    std::vector <int> dxl_bulk_read_word(std::vector <int> ids, int address);
     void dxl_bulk_write_word(std::vector <int> ids, int address, int value);
 */
 public:
@@ -192,6 +476,30 @@ public:
      */
     void serialSetLatency(int latency);
 
+    /*!
+     * \brief serialGetLatency
+     * \return The latency value currently used to compute timeouts, in milliseconds.
+     */
+    int serialGetLatency();
+
+    /*!
+     * \brief Get the estimated time needed to transfer one byte on the serial link.
+     * \return The byte transfert time in milliseconds, or 0 if the serial link is not open.
+     */
+    double serialGetByteTransfertTime();
+
+    /*!
+     * \brief Switch the serial port into low latency mode (ASYNC_LOW_LATENCY and 1 ms USB latency timer).
+     * \return True if every low latency setting has been applied.
+     */
+    bool serialSwitchHighSpeed();
+
+    /*!
+     * \brief Configure RS-485 direction control on the serial port (see SerialPort::setRS485()).
+     * \return True if the configuration has been applied.
+     */
+    bool serialSetRS485(const bool enable, const int delayBeforeSend = 0, const int delayAfterSend = 0, const bool rtsOnSend = true);
+
     /*!
      * \brief setAckPolicy
      * \param ack: Ack policy value, using '::AckPolicy_e' enum.
@@ -24,18 +24,47 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
 #include <chrono>
 #include <cmath>
 #include <thread>
 #include <mutex>
+#include <memory>
 
-// Enable latency timer
-//#define LATENCY_TIMER
+/*!
+ * \brief Update the registers of a servo from the raw bytes of a block read.
+ * \param s: The servo.
+ * \param reg_names: The registers to update. Registers outside of the block are ignored.
+ * \param addr: Address of the first byte of the block.
+ * \param size: Size of the block, in byte.
+ * \param data: Raw bytes of the block.
+ */
+static void updateRegisters(Servo *s, const std::vector <int> &reg_names, const int addr, const int size, const unsigned char *data)
+{
+    for (auto reg_name: reg_names)
+    {
+        int reg_addr = s->gaddr(reg_name);
+        int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+
+        if (reg_addr >= addr && reg_size > 0 && reg_addr + reg_size <= addr + size)
+        {
+            s->updateValue(reg_name, make_value(&data[reg_addr - addr], reg_size));
+        }
+    }
+}
 
 DynamixelController::DynamixelController(int ctrlFrequency, int servoSerie):
     ControllerAPI(ctrlFrequency)
 {
     this->servoSerie = servoSerie;
+
+    // Default polling plan
+    pollingPlan.setCycles(REG_CURRENT_POSITION, 1, 2);
+    pollingPlan.setCycles(REG_CURRENT_SPEED, 4, 1);
+    pollingPlan.setCycles(REG_CURRENT_LOAD, 4, 1);
+    pollingPlan.setCycles(REG_MOVING, 4, 1);
+    pollingPlan.setRate(REG_CURRENT_VOLTAGE, 1.0);
+    pollingPlan.setRate(REG_CURRENT_TEMPERATURE, 1.0);
 }
 
 DynamixelController::~DynamixelController()
@@ -156,6 +185,16 @@ void DynamixelController::disconnect()
     serialTerminate();
 }
 
+SerialPort *DynamixelController::serialGetPort_wrapper()
+{
+    return serialGetPort();
+}
+
+TimingHistogram &DynamixelController::syncloopTransactionTimes()
+{
+    return transactionTimes;
+}
+
 std::string DynamixelController::serialGetCurrentDevice_wrapper()
 {
     return serialGetCurrentDevice();
@@ -185,12 +224,14 @@ void DynamixelController::autodetect_internal(int start, int stop)
     if (stop < 1 || stop > maxId || stop < start)
         stop = maxId;
 
+    // Bring RX packet timeout down to scan faster (unless it's already lower)
+    int latency = serialGetLatency();
 #if defined(_WIN32) || defined(_WIN64)
-    // Bring RX packet timeout down to scan faster
-    serialSetLatency(12);
+    if (latency > 12)
+        serialSetLatency(12);
 #else
-    // Bring RX packet timeout down to scan way faster
-    serialSetLatency(8);
+    if (latency > 8)
+        serialSetLatency(8);
 #endif
 
     TRACE_INFO(CAPI, "DXL ctrl_device_autodetect(port: '%s' / tid: '%i')",
@@ -199,570 +240,985 @@ void DynamixelController::autodetect_internal(int start, int stop)
     TRACE_INFO(CAPI, "> THREADED Scanning for DXL devices on '%s', protocol v%i, range is [%i,%i[",
                serialGetCurrentDevice().c_str(), protocolVersion, start, stop);
 
-    for (int id = start; id <= stop; id++)
+    std::vector <int> ids;
+    std::vector <PingResponse> responses;
+
+    // Broadcast ping with protocol v2, short timeouts sweep with protocol v1
+    dxl_scan(start, stop, ids, responses);
+
+    for (size_t i = 0; i < ids.size(); i++)
     {
-        PingResponse pingstats;
+        int id = ids.at(i);
+        const PingResponse &pingstats = responses.at(i);
 
-        // If the ping gets a response, then we have found a servo
-        if (dxl_ping(id, &pingstats) == true)
-        {
-            //setLed(id, 1, LED_GREEN);
+        //setLed(id, 1, LED_GREEN);
 
-            int serie, model;
-            dxl_get_model_infos(pingstats.model_number, serie, model);
-            ServoDynamixel *servo = nullptr;
+        int serie, model;
+        dxl_get_model_infos(pingstats.model_number, serie, model);
+        ServoDynamixel *servo = nullptr;
 
-            TRACE_INFO(DXL, "[#%i] %s servo found!", id, dxl_get_model_name(pingstats.model_number).c_str());
+        TRACE_INFO(DXL, "[#%i] %s servo found!", id, dxl_get_model_name(pingstats.model_number).c_str());
 
-            // Instanciate the device found
-            switch (serie)
+        // Instanciate the device found
+        switch (serie)
+        {
+        case SERVO_AX:
+        case SERVO_DX:
+        case SERVO_RX:
+            servo = new ServoAX(id, pingstats.model_number);
+            break;
+
+        case SERVO_EX:
+            servo = new ServoEX(id, pingstats.model_number);
+            break;
+
+        case SERVO_MX:
+            servo = new ServoMX(id, pingstats.model_number);
+            break;
+
+        case SERVO_XL:
+            servo = new ServoXL(id, pingstats.model_number);
+            break;
+
+        case SERVO_X:
+            servo = new ServoX(id, pingstats.model_number);
+            break;
+
+        default:
+            break;
+        }
+
+        if (servo != nullptr)
+        {
+            servoListLock.lock();
+
+            // Add the servo to the controller, and mark it for an "initial read" and synchronization
+            if (servoRegistry.add(servo) == false)
             {
-            case SERVO_AX:
-            case SERVO_DX:
-            case SERVO_RX:
-                servo = new ServoAX(id, pingstats.model_number);
-                break;
+                delete servo;
+            }
 
-            case SERVO_EX:
-                servo = new ServoEX(id, pingstats.model_number);
-                break;
+            servoListLock.unlock();
+        }
 
-            case SERVO_MX:
-                servo = new ServoMX(id, pingstats.model_number);
-                break;
+        //setLed(id, 0);
+    }
 
-            case SERVO_XL:
-                servo = new ServoXL(id, pingstats.model_number);
-                break;
+    // Restore RX packet timeout
+    serialSetLatency(latency);
 
-            case SERVO_X:
-                servo = new ServoX(id, pingstats.model_number);
-                break;
+    if (getState() >= state_started)
+    {
+        setState(state_scanned);
+    }
+}
 
-            default:
-                break;
+double DynamixelController::estimateCycleDuration()
+{
+    // Packets overhead: header, ID, length, instruction (or error) and checksum
+    const int instOverhead = (protocolVersion == PROTOCOL_DXLv2) ? 10 : 6;
+    const int statusOverhead = (protocolVersion == PROTOCOL_DXLv2) ? 11 : 6;
+    const int readParams = (protocolVersion == PROTOCOL_DXLv2) ? 4 : 2;
+
+    double bytes = 0.0;
+    double delays = 0.0;
+    int syncWriteData = 0;
+    double bulkReadParams = 0.0;
+
+    std::vector < std::vector <int> > regLists;
+    std::vector <double> shares;
+    std::vector <RegisterBlock> blocks;
+
+    for (auto s_raw: servoRegistry.getSyncServos())
+    {
+        ServoDynamixel *s = static_cast<ServoDynamixel *>(s_raw);
+
+        // Assume a new goal position every cycle, sent with a 'Sync Write' instruction
+        syncWriteData += 1 + getRegisterSize(s->getControlTable(), REG_GOAL_POSITION);
+
+        if (s->getStatusReturnLevel() == ACK_NO_REPLY)
+        {
+            continue;
+        }
+
+        const double returnDelay = s->getReturnDelay() * 0.002;
+
+        // Every distinct list of registers read by the polling schedule, weighted by its share of the cycles
+        pollingSchedule.getReadLists(s->getId(), regLists, shares);
+
+        for (size_t i = 0; i < regLists.size(); i++)
+        {
+            const std::vector <int> &regs = regLists[i];
+
+            if (protocolVersion == PROTOCOL_DXLv2 || s->getDeviceSerie() == SERVO_MX)
+            {
+                int end = getRegisterBlocks(s->getControlTable(), &regs[0], regs.size(), REGISTER_AUTO, blocks, MAX_BULK_READ_SIZE);
+
+                if (blocks.size() == 1 && end - blocks[0].block_addr <= MAX_BULK_READ_SIZE)
+                {
+                    // One 'Bulk Read' entry and one status packet
+                    bulkReadParams += shares[i] * ((protocolVersion == PROTOCOL_DXLv2) ? 5 : 3);
+                    bytes += shares[i] * (statusOverhead + blocks[0].block_size);
+                    delays += shares[i] * returnDelay;
+                    continue;
+                }
             }
 
-            if (servo != nullptr)
+            // One read instruction per block of registers
+            getRegisterBlocks(s->getControlTable(), &regs[0], regs.size(), REGISTER_AUTO, blocks);
+
+            for (const auto &b: blocks)
             {
-                servoListLock.lock();
+                bytes += shares[i] * (instOverhead + readParams + statusOverhead + b.block_size);
+                delays += shares[i] * returnDelay;
+            }
+        }
+    }
+
+    if (bulkReadParams > 0.0)
+    {
+        bytes += instOverhead + ((protocolVersion == PROTOCOL_DXLv2) ? 0 : 1) + bulkReadParams;
+    }
+    if (syncWriteData > 0)
+    {
+        // 'Sync Write' parameters: start address and data length (same size as for a read), then the data
+        bytes += instOverhead + readParams + syncWriteData;
+    }
+
+    return bytes * serialGetByteTransfertTime() + delays;
+}
 
-                // Add the servo to the controller
-                servoList.push_back(servo);
+bool DynamixelController::readRegisterSnapshot(Servo *s)
+{
+    int id = s->getId();
+    int ack = s->getStatusReturnLevel();
 
-                // Mark it for an "initial read" and synchronization
-                updateList.push_back(servo->getId());
-                syncList.push_back(servo->getId());
+    std::vector <RegisterBlock> blocks, romBlocks, ramBlocks;
+    int imageSize = getRegisterBlocks(s->getControlTable(), REGISTER_AUTO, blocks);
+    int romSize = getRegisterBlocks(s->getControlTable(), REGISTER_ROM, romBlocks);
+    getRegisterBlocks(s->getControlTable(), REGISTER_RAM, ramBlocks);
 
-                servoListLock.unlock();
+    if (imageSize <= 0)
+    {
+        return false;
+    }
+
+    // Raw image of the control table, indexed by register address
+    std::vector <unsigned char> image(imageSize, 0);
+    int model = -1, firmware = -1;
+    bool romCached = false;
+
+    if (registerCache.isEnabled() && romSize > 0)
+    {
+        // Verify the cached EEPROM image (if any) with one small read
+        int verifySize = RegisterCache::getVerificationSize(s->getControlTable());
+        std::vector <unsigned char> cached;
+
+        if (verifySize > 0)
+        {
+            int status = dxl_read_block(id, 0, verifySize, &image[0], ack);
+            s->setError(dxl_get_rxpacket_error());
+            updateErrorCount(dxl_get_com_error_count());
+            dxl_print_error();
+
+            if (status != verifySize)
+            {
+                return false;
             }
 
-            //setLed(id, 0);
+            RegisterCache::getModelAndFirmware(s->getControlTable(), &image[0], model, firmware);
+
+            if (registerCache.getImage(serialGetCurrentDevice(), id, model, firmware, cached) &&
+                static_cast<int>(cached.size()) == romSize &&
+                std::equal(image.begin(), image.begin() + verifySize, cached.begin()))
+            {
+                TRACE_1(DXL, "[#%i] Using cached EEPROM image", id);
+                std::copy(cached.begin(), cached.end(), image.begin());
+                romCached = true;
+            }
         }
-        else
+    }
+
+    for (const auto &b: (romCached ? ramBlocks : blocks))
+    {
+        TRACE_1(DXL, "Reading block addr: '%i' size: '%i'", b.block_addr, b.block_size);
+
+        int status = dxl_read_block(id, b.block_addr, b.block_size, &image[b.block_addr], ack);
+        s->setError(dxl_get_rxpacket_error());
+        updateErrorCount(dxl_get_com_error_count());
+        dxl_print_error();
+
+        if (status != b.block_size)
         {
-            printf(".");
+            return false;
         }
     }
 
-    printf("\n");
+    // Decode register values
+    for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
+    {
+        int reg_name = getRegisterName(s->getControlTable(), ctid);
+        int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
+        int reg_size = getRegisterSize(s->getControlTable(), reg_name);
 
-    // Restore RX packet timeout
-    serialSetLatency(LATENCY_TIME_DEFAULT);
+        if (reg_addr >= 0 && reg_addr + reg_size <= imageSize)
+        {
+            s->updateValue(reg_name, make_value(&image[reg_addr], reg_size));
+        }
+    }
 
-    if (getState() >= state_started)
+    // Save the EEPROM image for the next time
+    if (registerCache.isEnabled() && romSize > 0 && romCached == false)
     {
-        setState(state_scanned);
+        RegisterCache::getModelAndFirmware(s->getControlTable(), &image[0], model, firmware);
+        registerCache.setImage(serialGetCurrentDevice(), id, model, firmware,
+                               std::vector <unsigned char>(image.begin(), image.begin() + romSize));
     }
+
+    return true;
 }
 
-void DynamixelController::run()
+bool DynamixelController::syncloopMaintenance()
 {
-    TRACE_INFO(CAPI, "DynamixelController::run(port: '%s' / tid: '%i')",
-               serialGetCurrentDevice().c_str(), std::this_thread::get_id());
+    // MESSAGE PARSING
+    ////////////////////////////////////////////////////////////////////////////
+
+    miniMessages m;
+    while (receiveMessage(m))
+    {
+        switch (m.msg)
+        {
+        case ctrl_device_autodetect:
+            autodetect_internal(m.p1, m.p2);
+            break;
+
+        case ctrl_device_register:
+            // handle registering servo by "id"?
+            registerServo_internal(static_cast<Servo *>(m.p));
+            break;
+        case ctrl_device_unregister:
+            unregisterServo_internal(static_cast<Servo *>(m.p));
+            break;
+        case ctrl_device_unregister_all:
+            unregisterServos_internal();
+            break;
+
+        case ctrl_device_delayed_add:
+            delayedAddServos_internal(m.p1, m.p2);
+            break;
+
+        case ctrl_state_pause:
+            TRACE_INFO(CAPI, ">> THREAD (tid: '%i') paused by message", std::this_thread::get_id());
+            return false;
+            break;
+        case ctrl_state_stop:
+            TRACE_INFO(CAPI, ">> THREAD (tid: '%i') termination by 'stop message'", std::this_thread::get_id());
+            return false;
+            break;
+
+        default:
+            TRACE_WARNING(DXL, "Unknown message type: '%i'", m.msg);
+            break;
+        }
+    }
+
+    syncloopPhaseEnd(phase_messages);
 
-    std::chrono::time_point<std::chrono::system_clock> start, end;
+    // ACTION LOOP
+    ////////////////////////////////////////////////////////////////////////////
 
-    while (getState() >= state_started)
+    servoListLock.lock();
+    for (auto s: servoRegistry.getServos())
     {
-        // Loop timer
-        start = std::chrono::system_clock::now();
+        int id = s->getId();
+        int ack = s->getStatusReturnLevel();
 
-        // MESSAGE PARSING
-        ////////////////////////////////////////////////////////////////////////
+        int actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed;
+        s->getActions(actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed);
 
-        unsigned ignoreMsg = 0;
+        if (refreshProgrammed == 1)
+        {
+            // Every servo register value will be updated
+            servoRegistry.setUpdate(id, true);
+            TRACE_INFO(DXL, "Refresh servo #%i registers", id);
+        }
 
-        m_mutex.lock();
-        while (m_queue.empty() == false && m_queue.size() != ignoreMsg)
+        if (actionProgrammed == 1)
         {
-            miniMessages m = m_queue.front();
-            m_mutex.unlock();
+            dxl_action(id, ack);
+            TRACE_INFO(DXL, "Action for servo #%i", id);
+        }
 
-            switch (m.msg)
-            {
-            case ctrl_device_autodetect:
-                autodetect_internal(m.p1, m.p2);
-                break;
+        if (rebootProgrammed == 1)
+        {
+            // Remove servo from sync/update lists; Need to be added again after reboot!
+            servoRegistry.setUpdate(id, false);
+            servoRegistry.setSync(id, false);
 
-            case ctrl_device_register:
-                // handle registering servo by "id"?
-                registerServo_internal(static_cast<Servo *>(m.p));
-                break;
-            case ctrl_device_unregister:
-                unregisterServo_internal(static_cast<Servo *>(m.p));
-                break;
-            case ctrl_device_unregister_all:
-                unregisterServos_internal();
-                break;
+            // Reboot
+            dxl_reboot(id, ack);
+            TRACE_INFO(DXL, "Rebooting servo #%i...", id);
+
+            miniMessages m {ctrl_device_delayed_add, std::chrono::steady_clock::now() + std::chrono::seconds(2), nullptr, id, 0};
+            sendMessage(&m);
+        }
+
+        if (resetProgrammed > 0)
+        {
+            // Remove servo from sync/update lists; Need to be added again after reset!
+            servoRegistry.setUpdate(id, false);
+            servoRegistry.setSync(id, false);
+
+            // Reset
+            dxl_reset(id, resetProgrammed, ack);
+            registerCache.invalidate(serialGetCurrentDevice(), id);
+            TRACE_INFO(DXL, "Resetting servo #%i (setting: %i)...", id, resetProgrammed);
+
+            miniMessages m {ctrl_device_delayed_add, std::chrono::steady_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
+            sendMessage(&m);
+        }
+    }
+    servoListLock.unlock();
+
+    syncloopPhaseEnd(phase_actions);
+
+    // INITIAL READ LOOP
+    ////////////////////////////////////////////////////////////////////////////
+
+    servoListLock.lock();
+    if (servoRegistry.getUpdateServos().empty() == false)
+    {
+        setState(state_reading);
+
+        // Copy the list, servos are removed from it once read
+        const std::vector <Servo *> updateServos(servoRegistry.getUpdateServos());
+        for (auto s: updateServos)
+        {
+            // Read the whole control table with a few block reads,
+            // or fall back to one read instruction per register
+            if (readRegisterSnapshot(s) == false)
+            {
+                int id = s->getId();
+                int ack = s->getStatusReturnLevel();
 
-            case ctrl_device_delayed_add:
-                if (delayedAddServos_internal(m.delay, m.p1, m.p2) == 1)
+                for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
                 {
-                    ignoreMsg++;
-                    sendMessage(&m);
-                }
-                break;
+                    int reg_name = getRegisterName(s->getControlTable(), ctid);
+                    int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
+                    int reg_size = getRegisterSize(s->getControlTable(), reg_name);
 
-            case ctrl_state_pause:
-                TRACE_INFO(CAPI, ">> THREAD (tid: '%i') paused by message", std::this_thread::get_id());
-                m_mutex.lock();
-                m_queue.pop_front();
-                m_mutex.unlock();
-                return;
-                break;
-            case ctrl_state_stop:
-                TRACE_INFO(CAPI, ">> THREAD (tid: '%i') termination by 'stop message'", std::this_thread::get_id());
-                m_mutex.lock();
-                m_queue.pop_front();
-                m_mutex.unlock();
-                return;
-                break;
+                    TRACE_1(DXL, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
 
-            default:
-                TRACE_WARNING(DXL, "Unknown message type: '%i'", m.msg);
-                break;
+                    if (reg_size == 1)
+                    {
+                        s->updateValue(reg_name, dxl_read_byte(id, reg_addr, ack));
+                    }
+                    else //if (regsize == 2)
+                    {
+                        s->updateValue(reg_name, dxl_read_word(id, reg_addr, ack));
+                    }
+                    s->setError(dxl_get_rxpacket_error());
+                    updateErrorCount(dxl_get_com_error_count());
+                    dxl_print_error();
+                }
             }
 
-            m_mutex.lock();
-            m_queue.pop_front();
+            // Once all registers are read, remove the servo from the "updateList"
+            servoRegistry.setUpdate(s->getId(), false);
         }
-        m_mutex.unlock();
 
-        // ACTION LOOP
-        ////////////////////////////////////////////////////////////////////////
+        setState(state_ready);
+    }
+    servoListLock.unlock();
+
+    syncloopPhaseEnd(phase_initial_read);
+
+    return true;
+}
+
+void DynamixelController::syncCollect(SyncCycle &cycle)
+{
+    // Servos to synchronize during this cycle
+    servoListLock.lock();
+    for (auto s_raw: servoRegistry.getSyncServos())
+    {
+        cycle.servos.push_back(static_cast<ServoDynamixel*>(s_raw));
+    }
+    servoListLock.unlock();
+
+    for (std::vector <ServoDynamixel *>::iterator it = cycle.servos.begin(); it != cycle.servos.end();)
+    {
+        // Unregister device if it reach an error count too high
+        // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
+        if ((*it)->getErrorCount() > 16)
+        {
+            TRACE_ERROR(DXL, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...", (*it)->getId(), serialGetCurrentDevice().c_str());
+            unregisterServo(*it);
+            it = cycle.servos.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
 
-        servoListLock.lock();
-        for (auto s: servoList)
+    // Register modifications
+    // Goal registers are gathered and sent with one 'Sync Write' per register
+    for (auto s: cycle.servos)
+    {
+        // Only visit the registers with a pending commit
+        uint64_t dirty = s->getDirtyRegisters();
+        if (dirty == 0)
         {
-            int id = s->getId();
-            int ack = s->getStatusReturnLevel();
+            continue;
+        }
 
-            int actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed;
-            s->getActions(actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed);
+        int id = s->getId();
+        std::vector <RegisterWrite> writes;
 
-            if (refreshProgrammed == 1)
+        for (int ctid = 0; ctid < s->getRegisterCount(); ctid++)
+        {
+            if ((dirty & (1ULL << ctid)) == 0)
             {
-                // Every servo register value will be updated
-                updateList.push_back(id);
-                TRACE_INFO(DXL, "Refresh servo #%i registers", id);
+                continue;
             }
 
-            if (actionProgrammed == 1)
-            {
-                dxl_action(id, ack);
-                TRACE_INFO(DXL, "Action for servo #%i", id);
-            }
+            int reg_name = getRegisterName(s->getControlTable(), ctid);
 
-            if (rebootProgrammed == 1)
+            if (s->getValueCommit(reg_name) == 1)
             {
-                // Remove servo from sync/update lists; Need to be added again after reboot!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
+                int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
+                int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+
+                if ((s->getSpeedMode() == SPEED_AUTO && (reg_name != REG_GOAL_POSITION && reg_name != REG_GOAL_SPEED)) == false)
                 {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
+                    TRACE_1(DXL, "Writing value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
+                            s->getValue(reg_name), ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
+
+                    if (reg_name == REG_GOAL_POSITION ||
+                        reg_name == REG_GOAL_SPEED ||
+                        reg_name == REG_GOAL_VELOCITY ||
+                        reg_name == REG_GOAL_TORQUE ||
+                        reg_name == REG_GOAL_ACCELERATION ||
+                        reg_name == REG_GOAL_PWM ||
+                        reg_name == REG_GOAL_CURRENT)
+                    {
+                        SyncWriteGroup *group = nullptr;
+                        for (auto &g: cycle.syncWrites)
+                        {
+                            if (g.reg_addr == reg_addr && g.reg_size == reg_size)
+                            {
+                                group = &g;
+                                break;
+                            }
+                        }
+                        if (group == nullptr)
+                        {
+                            cycle.syncWrites.push_back(SyncWriteGroup{reg_addr, reg_size, {}, {}});
+                            group = &cycle.syncWrites.back();
+                        }
+
+                        group->ids.push_back(id);
+                        group->values.push_back(s->getValue(reg_name));
+                        s->commitValue(reg_name, 0);
+                        continue;
+                    }
+
+                    writes.push_back(RegisterWrite{reg_name, reg_addr, reg_size, s->getValue(reg_name)});
                 }
+            }
+        }
+
+        // Registers at contiguous addresses are merged into one block write
+        // (ID changes are always written alone, as the device answers with its new ID)
+        std::sort(writes.begin(), writes.end(),
+                  [](const RegisterWrite &a, const RegisterWrite &b) { return a.reg_addr < b.reg_addr; });
 
-                // Reboot
-                dxl_reboot(id, ack);
-                TRACE_INFO(DXL, "Rebooting servo #%i...", id);
+        for (size_t first = 0; first < writes.size();)
+        {
+            size_t last = first + 1;
+            int block_size = writes[first].reg_size;
 
-                miniMessages m {ctrl_device_delayed_add, std::chrono::system_clock::now() + std::chrono::seconds(2), nullptr, id, 0};
-                sendMessage(&m);
+            while (last < writes.size() &&
+                   writes[first].reg_name != REG_ID && writes[last].reg_name != REG_ID &&
+                   writes[last].reg_addr == writes[first].reg_addr + block_size &&
+                   block_size + writes[last].reg_size <= MAX_PACKET_LENGTH_dxlv1)
+            {
+                block_size += writes[last].reg_size;
+                last++;
             }
 
-            if (resetProgrammed > 0)
+            BlockWrite w;
+            w.servo = s;
+            w.addr = writes[first].reg_addr;
+            w.regs.assign(writes.begin() + first, writes.begin() + last);
+
+            for (size_t i = first; i < last; i++)
             {
-                // Remove servo from sync/update lists; Need to be added again after reset!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
+                for (int b = 0; b < writes[i].reg_size; b++)
                 {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
+                    w.data.push_back(static_cast<unsigned char>((writes[i].value >> (8 * b)) & 0xFF));
                 }
-
-                // Reset
-                dxl_reset(id, resetProgrammed, ack);
-                TRACE_INFO(DXL, "Resetting servo #%i (setting: %i)...", id, resetProgrammed);
-
-                miniMessages m {ctrl_device_delayed_add, std::chrono::system_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
-                sendMessage(&m);
             }
+
+            cycle.writes.push_back(w);
+            first = last;
         }
-        servoListLock.unlock();
+    }
 
-        // INITIAL READ LOOP
-        ////////////////////////////////////////////////////////////////////////
+    // Feedback registers, following the polling schedule
+    // Servos supporting the 'Bulk Read' instruction are read with a single
+    // transaction, the others fall back to one read instruction per block
+    // of contiguous registers
+    std::vector <int> regs;
+    std::vector <RegisterBlock> blocks;
 
-        servoListLock.lock();
-        if (updateList.empty() == false)
-        {
-            std::vector <int>::iterator itr;
-            for (itr = updateList.begin(); itr != updateList.end();)
-            {
-                setState(state_reading);
+    for (auto s: cycle.servos)
+    {
+        int id = s->getId();
 
-                for (auto s: servoList)
-                {
-                    if (s->getId() == (*itr))
-                    {
-                        int id = s->getId();
-                        int ack = s->getStatusReturnLevel();
+        if (s->getStatusReturnLevel() == ACK_NO_REPLY)
+        {
+            continue;
+        }
 
-                        for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
-                        {
-                            int reg_name = getRegisterName(s->getControlTable(), ctid);
-                            int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
-                            int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+        pollingSchedule.getDueRegisters(id, syncloopCounter, regs);
 
-                            TRACE_1(DXL, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
+        if (regs.empty())
+        {
+            continue;
+        }
 
-                            if (reg_size == 1)
-                            {
-                                s->updateValue(reg_name, dxl_read_byte(id, reg_addr, ack));
-                            }
-                            else //if (regsize == 2)
-                            {
-                                s->updateValue(reg_name, dxl_read_word(id, reg_addr, ack));
-                            }
-                            s->setError(dxl_get_rxpacket_error());
-                            updateErrorCount(dxl_get_com_error_count());
-                            dxl_print_error();
-                        }
+        if (protocolVersion == PROTOCOL_DXLv2 || s->getDeviceSerie() == SERVO_MX)
+        {
+            // Read the smallest register range containing every register we need
+            int end = getRegisterBlocks(s->getControlTable(), &regs[0], regs.size(), REGISTER_AUTO, blocks, MAX_BULK_READ_SIZE);
 
-                        // Once all registers are read, remove the servo from the "updateList"
-                        itr = updateList.erase(itr);
-                    }
-                }
+            if (blocks.size() == 1 && end - blocks[0].block_addr <= MAX_BULK_READ_SIZE)
+            {
+                BulkReadEntry e;
+                e.id = id;
+                e.address = blocks[0].block_addr;
+                e.size = blocks[0].block_size;
+                cycle.bulkEntries.push_back(e);
+                cycle.bulkServos.push_back(s);
+                cycle.bulkRegisters.push_back(regs);
+                continue;
             }
+        }
 
-            setState(state_ready);
+        getRegisterBlocks(s->getControlTable(), &regs[0], regs.size(), REGISTER_AUTO, blocks);
+
+        for (const auto &b: blocks)
+        {
+            BlockRead r;
+            r.servo = s;
+            r.regs = regs;
+            r.addr = b.block_addr;
+            r.data.resize(b.block_size);
+            cycle.reads.push_back(r);
         }
-        servoListLock.unlock();
+    }
+}
 
-        // SYNCHRONIZATION LOOP
-        ////////////////////////////////////////////////////////////////////////
+void DynamixelController::syncWriteDone(BlockWrite &w)
+{
+    ServoDynamixel *s = w.servo;
+    int id = s->getId();
 
-        int cumulid = 0;
+    s->setError(dxl_get_rxpacket_error());
+    updateErrorCount(dxl_get_com_error_count());
+    dxl_print_error();
 
-        servoListLock.lock();
-        for (auto id: syncList)
+    for (const auto &r: w.regs)
+    {
+        // The cached EEPROM image of this device is now outdated
+        if (getRegisterAddr(s->getControlTable(), r.reg_name, REGISTER_ROM) >= 0)
         {
-            cumulid++;
-            cumulid %= syncloopFrequency;
+            registerCache.invalidate(serialGetCurrentDevice(), id);
+        }
+
+        s->commitValue(r.reg_name, 0);
 
-            for (auto s_raw: servoList)
+        if (r.reg_name == REG_ID)
+        {
+            if (s->changeInternalId(r.value) == 1)
             {
+                servoListLock.lock();
+                servoRegistry.changeId(id);
                 servoListLock.unlock();
 
-                ServoDynamixel *s = static_cast<ServoDynamixel*>(s_raw);
+                s->reboot();
+            }
+        }
+    }
+}
 
-                if (s->getId() == id)
-                {
-                    int ack = s->getStatusReturnLevel();
+void DynamixelController::syncReadDone(BlockRead &r, const bool success)
+{
+    r.servo->setError(dxl_get_rxpacket_error());
+    updateErrorCount(dxl_get_com_error_count());
+    dxl_print_error();
 
-                    // Unregister device if it reach an error count too high
-                    // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
-                    if (s->getErrorCount() > 16)
-                    {
-                        TRACE_ERROR(DXL, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...", id, serialGetCurrentDevice().c_str());
-                        unregisterServo(s);
-                        continue;
-                    }
+    if (success)
+    {
+        updateRegisters(r.servo, r.regs, r.addr, static_cast<int>(r.data.size()), &r.data[0]);
+    }
+}
 
-                    // Commit register modifications
-                    for (int ctid = 0; ctid < s->getRegisterCount(); ctid++)
-                    {
-                        int reg_name = getRegisterName(s->getControlTable(), ctid);
+void DynamixelController::syncBulkDone(SyncCycle &cycle)
+{
+    for (size_t i = 0; i < cycle.bulkEntries.size(); i++)
+    {
+        const BulkReadEntry &e = cycle.bulkEntries[i];
+        ServoDynamixel *s = cycle.bulkServos[i];
 
-                        if (s->getValueCommit(reg_name) == 1)
-                        {
-                            int reg_addr = getRegisterAddr(s->getControlTable(), reg_name);
-                            int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+        if (e.commStatus == COMM_RXSUCCESS)
+        {
+            updateRegisters(s, cycle.bulkRegisters[i], e.address, e.size, e.data);
+            s->setError(e.error);
+            updateErrorCount(0);
+        }
+        else
+        {
+            TRACE_ERROR(DXL, "[#%i] Bulk read failed with error code '%i'", e.id, e.commStatus);
+            updateErrorCount(1);
+        }
+    }
+}
 
-                            if ((s->getSpeedMode() == SPEED_AUTO && (reg_name != REG_GOAL_POSITION && reg_name != REG_GOAL_SPEED)) == false)
-                            {
-                                TRACE_1(DXL, "Writing value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                        s->getValue(reg_name), ctid, getRegisterNameTxt(reg_name).c_str(), reg_addr, reg_size);
-
-                                if (reg_size == 1)
-                                {
-                                    dxl_write_byte(id, reg_addr, s->getValue(reg_name), ack);
-                                }
-                                else //if (regsize == 2)
-                                {
-                                    dxl_write_word(id, reg_addr, s->getValue(reg_name), ack);
-                                }
-
-                                s->commitValue(reg_name, 0);
-                                s->setError(dxl_get_rxpacket_error());
-                                updateErrorCount(dxl_get_com_error_count());
-                                dxl_print_error();
-
-                                if (reg_name == REG_ID)
-                                {
-                                    if (s->changeInternalId(s->getValue(reg_name)) == 1)
-                                    {
-                                        s->reboot();
-                                    }
-                                }
-                            }
-                        }
-                    }
+void DynamixelController::syncloopSynchronize()
+{
+    SyncCycle cycle;
+    syncCollect(cycle);
+
+    std::vector <ServoDynamixel *> &syncServos = cycle.servos;
+
+    // Commit register modifications
+    // Writes without status packets are batched and sent together
+    dxl_tx_batch_begin();
+
+    for (auto &w: cycle.writes)
+    {
+        dxl_write_block(w.servo->getId(), w.addr, static_cast<int>(w.data.size()), &w.data[0], w.servo->getStatusReturnLevel());
+        syncWriteDone(w);
+    }
+
+    for (const auto &g: cycle.syncWrites)
+    {
+        dxl_sync_write(g.ids, g.reg_addr, g.values, g.reg_size);
+        updateErrorCount(dxl_get_com_error_count());
+        dxl_print_error();
+    }
+
+    dxl_tx_batch_end();
+    updateErrorCount(dxl_get_com_error_count());
+
+    // Read feedback registers
+    for (auto &r: cycle.reads)
+    {
+        int size = static_cast<int>(r.data.size());
+        int status = dxl_read_block(r.servo->getId(), r.addr, size, &r.data[0], r.servo->getStatusReturnLevel());
+        syncReadDone(r, status == size);
+    }
+
+    if (cycle.bulkEntries.empty() == false)
+    {
+        dxl_bulk_read(cycle.bulkEntries);
+        syncBulkDone(cycle);
+    }
+
+    // Goal position
+    dxl_tx_batch_begin();
+    for (auto s: syncServos)
+    {
+        int id = s->getId();
+        int ack = s->getStatusReturnLevel();
+        int cpos = s->getCurrentPosition();
+
+        // Goal pos
+        if (s->getValueCommit(REG_GOAL_POSITION) == 1)
+        {
+            int gpos = s->getGoalPosition();
+            int movingSpeed = 50; //s->getMovingSpeed();
 
-                    // 1 Hz "low priority" update loop
-                    if (((syncloopCounter - cumulid) == 0) &&
-                        (ack != ACK_NO_REPLY))
+            // Control modes:
+            if (s->getSpeedMode() == SPEED_AUTO)
+            {
+                double k = 1.0; // acceleration factor
+                double mot = 3.0; // margin of tolerance
+
+                if (s->getCwAngleLimit() != 0 || s->getCcwAngleLimit() != 0) // JOINT MODE
+                {
+                    double step = static_cast<double>(s->getRunningDegrees()) / s->getSteps();
+                    double angle = static_cast<double>(gpos - cpos) * step;
+                    double angle_abs = std::fabs(angle);
+                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
+
+                    if (angle_abs > mot)
                     {
-                        // Read voltage
-                        s->updateValue(REG_CURRENT_VOLTAGE, dxl_read_byte(id, s->gaddr(REG_CURRENT_VOLTAGE), ack));
-                        s->setError(dxl_get_rxpacket_error());
+                        // SPEED
+                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
                         updateErrorCount(dxl_get_com_error_count());
                         dxl_print_error();
-
-                        // Read temp
-                        s->updateValue(REG_CURRENT_TEMPERATURE, dxl_read_byte(id, s->gaddr(REG_CURRENT_TEMPERATURE), ack));
                         s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
-                    }
 
-                    // x/4 Hz "feedback" update loop
-                    if (((syncloopCounter - cumulid) % 4 == 0) &&
-                        (ack != ACK_NO_REPLY))
+                        // POS
+                        if (angle >= 0)
+                        {
+                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getSteps() - 1, ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
+                        else
+                        {
+                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), 0, ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
+
+                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
+                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
+                    }
+                    else // STOP
                     {
-                        s->updateValue(REG_CURRENT_SPEED, dxl_read_word(id, s->gaddr(REG_CURRENT_SPEED), ack));
+                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), movingSpeed, ack);
                         s->setError(dxl_get_rxpacket_error());
                         updateErrorCount(dxl_get_com_error_count());
                         dxl_print_error();
 
-                        s->updateValue(REG_CURRENT_LOAD, dxl_read_word(id, s->gaddr(REG_CURRENT_LOAD), ack));
+                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
                         s->setError(dxl_get_rxpacket_error());
                         updateErrorCount(dxl_get_com_error_count());
                         dxl_print_error();
 
-                        // Read moving
-                        s->updateValue(REG_MOVING, dxl_read_byte(id, s->gaddr(REG_MOVING), ack));
-                        s->setError(dxl_get_rxpacket_error());
-                        updateErrorCount(dxl_get_com_error_count());
-                        dxl_print_error();
+                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
+                                cpos, speed, gpos, angle);
+                        s->commitValue(REG_GOAL_POSITION, 0);
                     }
+                }
+                else // if (s->getCwAngleLimit() == 0 && s->getCcwAngleLimit() == 0) // WHEEL MODE
+                {
+                    double step = 360.0 / s->getSteps();
+                    double angle = static_cast<double>(gpos - cpos) * step;
+
+                    if (angle > 180) angle -= 360;
+                    else if (angle < -180) angle += 360;
+                    double angle_abs = std::fabs(angle);
+
+                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
+
+                    if (angle_abs > mot)
+                    {
+                        if (angle >= 0)
+                        {
+                            // SPEED (counter clockwise)
+                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
+                        else
+                        {
+                            // SPEED (clockwise)
+                            speed +=  1024;
+                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
 
-                    // x Hz "full speed" update loop
+                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
+                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
+                    }
+                    else // STOP
                     {
-                        // Get "current" values from devices, and write them into corresponding objects
-                        int cpos = dxl_read_word(id, s->gaddr(REG_CURRENT_POSITION), ack);
-                        s->updateValue(REG_CURRENT_POSITION, cpos);
+                        if (dxl_read_word(id, s->gaddr(REG_GOAL_SPEED), ack) >= 1024)
+                        {
+                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), ack, 1024);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
+                        else
+                        {
+                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), 0, ack);
+                            s->setError(dxl_get_rxpacket_error());
+                            updateErrorCount(dxl_get_com_error_count());
+                            dxl_print_error();
+                        }
+
+                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
                         s->setError(dxl_get_rxpacket_error());
                         updateErrorCount(dxl_get_com_error_count());
                         dxl_print_error();
 
-                        // Goal pos
-                        if (s->getValueCommit(REG_GOAL_POSITION) == 1)
-                        {
-                            int gpos = s->getGoalPosition();
-                            int movingSpeed = 50; //s->getMovingSpeed();
-
-                            // Control modes:
-                            if (s->getSpeedMode() == SPEED_AUTO)
-                            {
-                                double k = 1.0; // acceleration factor
-                                double mot = 3.0; // margin of tolerance
-
-                                if (s->getCwAngleLimit() != 0 || s->getCcwAngleLimit() != 0) // JOINT MODE
-                                {
-                                    double step = static_cast<double>(s->getRunningDegrees()) / s->getSteps();
-                                    double angle = static_cast<double>(gpos - cpos) * step;
-                                    double angle_abs = std::fabs(angle);
-                                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
-
-                                    if (angle_abs > mot)
-                                    {
-                                        // SPEED
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-                                        s->setError(dxl_get_rxpacket_error());
-
-                                        // POS
-                                        if (angle >= 0)
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getSteps() - 1, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), 0, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
-                                    }
-                                    else // STOP
-                                    {
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), movingSpeed, ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, gpos, angle);
-                                        s->commitValue(REG_GOAL_POSITION, 0);
-                                    }
-                                }
-                                else // if (s->getCwAngleLimit() == 0 && s->getCcwAngleLimit() == 0) // WHEEL MODE
-                                {
-                                    double step = 360.0 / s->getSteps();
-                                    double angle = static_cast<double>(gpos - cpos) * step;
-
-                                    if (angle > 180) angle -= 360;
-                                    else if (angle < -180) angle += 360;
-                                    double angle_abs = std::fabs(angle);
-
-                                    int speed = (movingSpeed + static_cast<int>(k * angle_abs));
-
-                                    if (angle_abs > mot)
-                                    {
-                                        if (angle >= 0)
-                                        {
-                                            // SPEED (counter clockwise)
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            // SPEED (clockwise)
-                                            speed +=  1024;
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), speed, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        TRACE_2(DXL, "pos: '%i' Movingspeed: '%i' CurrentSpeed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, s->getCurrentSpeed(), gpos, angle);
-                                    }
-                                    else // STOP
-                                    {
-                                        if (dxl_read_word(id, s->gaddr(REG_GOAL_SPEED), ack) >= 1024)
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), ack, 1024);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-                                        else
-                                        {
-                                            dxl_write_word(id, s->gaddr(REG_GOAL_SPEED), 0, ack);
-                                            s->setError(dxl_get_rxpacket_error());
-                                            updateErrorCount(dxl_get_com_error_count());
-                                            dxl_print_error();
-                                        }
-
-                                        dxl_write_word(id, s->gaddr(REG_GOAL_POSITION), s->getGoalPosition(), ack);
-                                        s->setError(dxl_get_rxpacket_error());
-                                        updateErrorCount(dxl_get_com_error_count());
-                                        dxl_print_error();
-
-                                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
-                                                cpos, speed, gpos, angle);
-                                        s->commitValue(REG_GOAL_POSITION, 0);
-                                    }
-                                }
-                            }
-                            else if (s->getSpeedMode() == SPEED_MANUAL)
-                            {
-                                if (s->getCwAngleLimit() == 0 || s->getCcwAngleLimit() == 0) // WHEEL MODE
-                                {
-                                    // WIP // Do we want to handle this on the framework side ?
-                                }
-                            }
-                        }
+                        TRACE_2(DXL, "[STOP] pos: '%i' speed: '%i'   |   (> %i) (angle: %i)",
+                                cpos, speed, gpos, angle);
+                        s->commitValue(REG_GOAL_POSITION, 0);
                     }
                 }
-
-                servoListLock.lock();
             }
+            else if (s->getSpeedMode() == SPEED_MANUAL)
+            {
+                if (s->getCwAngleLimit() == 0 || s->getCcwAngleLimit() == 0) // WHEEL MODE
+                {
+                    // WIP // Do we want to handle this on the framework side ?
+                }
+            }
+        }
+    }
+    dxl_tx_batch_end();
+    updateErrorCount(dxl_get_com_error_count());
+}
+
+bool DynamixelController::syncloopSubmit(std::function <void ()> done)
+{
+    // The automatic speed mode reads and writes goal registers depending on
+    // the current position, one blocking transaction after the other
+    servoListLock.lock();
+    for (auto s_raw: servoRegistry.getSyncServos())
+    {
+        ServoDynamixel *s = static_cast<ServoDynamixel*>(s_raw);
+        if (s->getSpeedMode() == SPEED_AUTO && s->getValueCommit(REG_GOAL_POSITION) == 1)
+        {
+            servoListLock.unlock();
+            return false;
         }
+    }
+    servoListLock.unlock();
 
-        // Make sure we unlock servoList
-        servoListLock.unlock();
+    std::shared_ptr <SyncCycle> cycle = std::make_shared <SyncCycle>();
+    syncCollect(*cycle);
 
-        // Loop control
-        syncloopCounter++;
-        syncloopCounter %= syncloopFrequency;
+    std::vector <SerialTransaction> transactions;
+    SerialTransaction t;
 
-        // Loop timer
-        end = std::chrono::system_clock::now();
-        double loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
-        double waitd = (syncloopDuration * 1000.0) - loopd;
+    // Register modifications
+    for (size_t i = 0; i < cycle->writes.size(); i++)
+    {
+        const BlockWrite &w = cycle->writes[i];
+        const int size = static_cast<int>(w.data.size());
 
-#ifdef LATENCY_TIMER
-        if ((loopd / 1000.0) > syncloopDuration)
+        for (int written = 0; written < size;)
         {
-            TRACE_WARNING(DXL, "Sync loop duration: %fms of the %fms budget.", (loopd / 1000.0), syncloopDuration);
+            written += dxl_set_write_packet(w.servo->getId(), w.addr + written, size - written, &w.data[written]);
+            if (dxl_get_transaction(t, w.servo->getStatusReturnLevel()) == false)
+            {
+                break;
+            }
+
+            const bool last = (written >= size);
+            SerialTransaction request = t;
+
+            t.callback = [this, cycle, i, last, request](int status, const std::vector <unsigned char> &response) {
+                BlockWrite &w = cycle->writes[i];
+                if (w.failed)
+                {
+                    return;
+                }
+
+                // The remaining chunks of a failed block write are ignored, like dxl_write_block() does
+                dxl_rx_status(request, status, response);
+                w.failed = (dxl_get_com_error_count() > 0);
+
+                if (last || w.failed)
+                {
+                    syncWriteDone(w);
+                }
+            };
+            transactions.push_back(t);
         }
-        else
+    }
+
+    for (const auto &g: cycle->syncWrites)
+    {
+        for (int first = 0; first < static_cast<int>(g.ids.size());)
         {
-            TRACE_INFO(DXL, "Sync loop duration: %fms of the %fms budget.", (loopd / 1000.0), syncloopDuration);
+            first += dxl_set_sync_write_packet(g.ids, g.values, first, g.reg_addr, g.reg_size);
+            if (dxl_get_transaction(t, ACK_NO_REPLY) == false)
+            {
+                break;
+            }
+
+            SerialTransaction request = t;
+            t.callback = [this, request](int status, const std::vector <unsigned char> &response) {
+                dxl_rx_status(request, status, response);
+                updateErrorCount(dxl_get_com_error_count());
+                dxl_print_error();
+            };
+            transactions.push_back(t);
         }
-#endif
+    }
+
+    // Feedback registers
+    for (size_t i = 0; i < cycle->reads.size(); i++)
+    {
+        const BlockRead &r = cycle->reads[i];
+        const int size = static_cast<int>(r.data.size());
+
+        for (int offset = 0; offset < size;)
+        {
+            int chunkSize = dxl_set_read_packet(r.servo->getId(), r.addr + offset, size - offset);
+            if (dxl_get_transaction(t, r.servo->getStatusReturnLevel()) == false)
+            {
+                break;
+            }
+
+            const bool last = (offset + chunkSize >= size);
+            SerialTransaction request = t;
+
+            t.callback = [this, cycle, i, offset, chunkSize, last, request](int status, const std::vector <unsigned char> &response) {
+                BlockRead &r = cycle->reads[i];
+                if (r.failed)
+                {
+                    return;
+                }
+
+                bool success = (dxl_rx_status(request, status, response) == COMM_RXSUCCESS &&
+                                dxl_get_rxpacket_data(&r.data[offset], chunkSize) == chunkSize);
+                r.failed = (success == false);
+
+                if (last || r.failed)
+                {
+                    syncReadDone(r, success);
+                }
+            };
+            transactions.push_back(t);
+
+            offset += chunkSize;
+        }
+    }
+
+    const int bulkCount = static_cast<int>(cycle->bulkEntries.size());
 
-        if (waitd > 0.0)
+    for (int first = 0; first < bulkCount;)
+    {
+        int count = dxl_set_bulk_read_packet(&cycle->bulkEntries[first], bulkCount - first);
+        if (dxl_get_transaction(t) == false)
         {
-            std::chrono::microseconds waittime(static_cast<int>(waitd));
-            std::this_thread::sleep_for(waittime);
+            break;
         }
+
+        SerialTransaction request = t;
+        t.callback = [this, cycle, first, count, request](int status, const std::vector <unsigned char> &response) {
+            dxl_rx_status(request, status, std::vector <unsigned char>());
+            dxl_rx_multiple_status(status, response, &cycle->bulkEntries[first], count);
+        };
+        transactions.push_back(t);
+
+        first += count;
     }
 
-    TRACE_INFO(DXL, ">> THREAD (tid: '%i') termination by 'loop exit'", std::this_thread::get_id());
+    syncloopSubmitTransactions(transactions, [this, cycle, done]() {
+        if (cycle->bulkEntries.empty() == false)
+        {
+            syncBulkDone(*cycle);
+        }
+        done();
+    });
+
+    return true;
 }
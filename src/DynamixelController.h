@@ -52,17 +52,106 @@
  */
 class DynamixelController: public Dynamixel, public ControllerAPI
 {
+    /*!
+     * \brief Registers of several servos, to be written with one 'Sync Write' instruction.
+     */
+    struct SyncWriteGroup
+    {
+        int reg_addr;
+        int reg_size;
+        std::vector <int> ids;
+        std::vector <int> values;
+    };
+
+    /*!
+     * \brief A register modification to write to one servo during a synchronization cycle.
+     */
+    struct RegisterWrite
+    {
+        int reg_name;
+        int reg_addr;
+        int reg_size;
+        int value;
+    };
+
+    /*!
+     * \brief Registers at contiguous addresses of one servo, written with one block write.
+     */
+    struct BlockWrite
+    {
+        ServoDynamixel *servo = nullptr;
+        int addr = 0;
+        std::vector <unsigned char> data;   //!< Raw bytes to write, starting at 'addr'.
+        std::vector <RegisterWrite> regs;   //!< The register modifications committed by this write.
+        bool failed = false;
+    };
+
+    /*!
+     * \brief Feedback registers of one servo, read with one block read.
+     */
+    struct BlockRead
+    {
+        ServoDynamixel *servo = nullptr;
+        std::vector <int> regs;             //!< The registers due during this cycle.
+        int addr = 0;
+        std::vector <unsigned char> data;   //!< Raw bytes read, starting at 'addr'. Sized for the block.
+        bool failed = false;
+    };
+
+    /*!
+     * \brief The register writes and feedback reads of one synchronization cycle.
+     */
+    struct SyncCycle
+    {
+        std::vector <ServoDynamixel *> servos;
+        std::vector <BlockWrite> writes;
+        std::vector <SyncWriteGroup> syncWrites;
+        std::vector <BlockRead> reads;
+        std::vector <BulkReadEntry> bulkEntries;
+        std::vector <ServoDynamixel *> bulkServos;
+        std::vector < std::vector <int> > bulkRegisters;
+    };
+
     //! Compute some internal settings (ackPolicy, maxId, protocolVersion) depending on current servo serie and serial device.
     void updateInternalSettings();
 
-    //! Read/write synchronization loop, running inside its own background thread
-    void run();
+    bool syncloopMaintenance();
+    void syncloopSynchronize();
+    bool syncloopSubmit(std::function <void ()> done);
+    TimingHistogram &syncloopTransactionTimes();
+
+    /*!
+     * \brief Gather the register writes and feedback reads of a synchronization cycle.
+     * \param cycle: Filled with the servos to synchronize, and what to write and read.
+     *
+     * Servos with too many errors are unregistered, and registers gathered into
+     * 'Sync Write' groups are marked as committed.
+     */
+    void syncCollect(SyncCycle &cycle);
+
+    //! Report the outcome of a block write, and commit its registers.
+    void syncWriteDone(BlockWrite &w);
+
+    //! Report the outcome of a block read, and update the servo registers if it succeeded.
+    void syncReadDone(BlockRead &r, const bool success);
+
+    //! Update the servos registers from the 'Bulk Read' entries of a cycle.
+    void syncBulkDone(SyncCycle &cycle);
+
+    /*!
+     * \brief Read every register of a servo using a few block reads, and update the servo object.
+     * \param s: The servo to read.
+     * \return true if every register has been read, false otherwise.
+     */
+    bool readRegisterSnapshot(Servo *s);
+
+    double estimateCycleDuration();
 
 public:
     /*!
      * \brief DynamixelController constructor.
      * \param servoSerie: The servo serie to use with this controller. Only used to choose the right communication protocol.
-     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;120], default is 30.
+     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;1000], default is 30.
      */
     DynamixelController(int ctrlFrequency = 30, int servoSerie = SERVO_MX);
 
@@ -101,7 +190,8 @@ public:
      * This scanning function will ping every Dynamixel ID (from 'start' to 'stop',
      * default [0;253]) on a serial link, and use the status response to detect
      * the presence of a device.
-     * When a device is being scanned, its LED is briefly switched on.
+     * With protocol v2, a single broadcast ping is used to scan the whole range.
+     * Its duration grows with 'stop' (about 3 ms per ID), so keep the range tight.
      * Every servo found will be automatically registered to this controller.
      *
      * The current value 'protocolVersion' will be used. You can change it with
@@ -110,6 +200,7 @@ public:
     void autodetect_internal(int start = 0, int stop = 253);
 
     // Wrappers
+    SerialPort *serialGetPort_wrapper();
     std::string serialGetCurrentDevice_wrapper();
     std::vector <std::string> serialGetAvailableDevices_wrapper();
     void serialSetLatency_wrapper(int latency);
@@ -168,39 +168,32 @@ std::vector <int> DynamixelSimpleAPI::servoScan(int start, int stop)
 
     // A vector of Dynamixel IDs found during the scan
     std::vector <int> ids;
+    std::vector <PingResponse> responses;
 
-    for (int id = start; id <= stop; id++)
-    {
-        PingResponse pingstats;
+    // Broadcast ping with protocol v2, short timeouts sweep with protocol v1
+    dxl_scan(start, stop, ids, responses);
 
-        // If the ping gets a response, then we have found a servo
-        if (dxl_ping(id, &pingstats) == true)
-        {
-            setLed(id, 1, LED_GREEN);
+    for (size_t i = 0; i < ids.size(); i++)
+    {
+        int id = ids.at(i);
 
-            ids.push_back(id);
+        setLed(id, 1, LED_GREEN);
 
-            TRACE_INFO(DAPI, "[#%i] Dynamixel servo found!", id);
-            TRACE_INFO(DAPI, "[#%i] model: '%i' (%s)", id, pingstats.model_number,
-                       dxl_get_model_name(pingstats.model_number).c_str());
+        TRACE_INFO(DAPI, "[#%i] Dynamixel servo found!", id);
+        TRACE_INFO(DAPI, "[#%i] model: '%i' (%s)", id, responses.at(i).model_number,
+                   dxl_get_model_name(responses.at(i).model_number).c_str());
 
-            // Other informations, not printed by default:
-            TRACE_1(DAPI, "[#%i] firmware: '%i' ", id, pingstats.firmware_version);
-            TRACE_1(DAPI, "[#%i] position: '%i' ", id, readCurrentPosition(id));
-            TRACE_1(DAPI, "[#%i] speed: '%i' ", id, readCurrentSpeed(id));
-            TRACE_1(DAPI, "[#%i] torque: '%i' ", id, getTorqueEnabled(id));
-            TRACE_1(DAPI, "[#%i] load: '%i' ", id, readCurrentLoad(id));
-            TRACE_1(DAPI, "[#%i] baudrate: '%i' ", id, getSetting(id, REG_BAUD_RATE));
+        // Other informations, not printed by default:
+        TRACE_1(DAPI, "[#%i] firmware: '%i' ", id, responses.at(i).firmware_version);
+        TRACE_1(DAPI, "[#%i] position: '%i' ", id, readCurrentPosition(id));
+        TRACE_1(DAPI, "[#%i] speed: '%i' ", id, readCurrentSpeed(id));
+        TRACE_1(DAPI, "[#%i] torque: '%i' ", id, getTorqueEnabled(id));
+        TRACE_1(DAPI, "[#%i] load: '%i' ", id, readCurrentLoad(id));
+        TRACE_1(DAPI, "[#%i] baudrate: '%i' ", id, getSetting(id, REG_BAUD_RATE));
 
-            setLed(id, 0);
-        }
-        else
-        {
-            printf(".");
-        }
+        setLed(id, 0);
     }
 
-    printf("\n");
     return ids;
 }
 
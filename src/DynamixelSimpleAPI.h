@@ -103,7 +103,9 @@ public:
      * This scanning function will ping every Dynamixel ID (from 'start' to 'stop',
      * default [0;253]) on a serial link, and use the status response to detect
      * the presence of a device.
-     * When a device is being scanned, its LED is briefly switched on.
+     * With protocol v2, a single broadcast ping is used to scan the whole range.
+     * Its duration grows with 'stop' (about 3 ms per ID), so keep the range tight.
+     * When a device is found, its LED is briefly switched on.
      */
     std::vector <int> servoScan(int start = 0, int stop = 253);
 
@@ -24,6 +24,8 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -101,20 +103,28 @@ int HerkuleX::serialInitialize(std::string &devicePath, const int baud)
         serialTerminate();
     }
 
-    // Instanciate a different serial subclass, depending on the current OS
+    // Instanciate a different serial subclass, depending on the current OS,
+    // or connect to an emulated bus
+    if (devicePath.compare(0, strlen(VIRTUAL_PORT_PREFIX), VIRTUAL_PORT_PREFIX) == 0)
+    {
+        serial = new SerialPortVirtual(devicePath, baud, serialDevice, servoSerie);
+    }
+    else
+    {
 #if defined(FEATURE_QTSERIAL)
-    serial = new SerialPortQt(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortQt(devicePath, baud, serialDevice, servoSerie);
 #else
 #if defined(__linux__) || defined(__gnu_linux)
-    serial = new SerialPortLinux(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortLinux(devicePath, baud, serialDevice, servoSerie);
 #elif defined(_WIN32) || defined(_WIN64)
-    serial = new SerialPortWindows(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortWindows(devicePath, baud, serialDevice, servoSerie);
 #elif defined(__APPLE__) || defined(__MACH__)
-    serial = new SerialPortMacOS(devicePath, baud, serialDevice, servoSerie);
+        serial = new SerialPortMacOS(devicePath, baud, serialDevice, servoSerie);
 #else
     #error "No compatible operating system detected!"
 #endif
 #endif
+    }
 
     // Initialize the serial link
     if (serial != nullptr)
@@ -149,6 +159,11 @@ void HerkuleX::serialTerminate()
     }
 }
 
+SerialPort *HerkuleX::serialGetPort()
+{
+    return serial;
+}
+
 std::string HerkuleX::serialGetCurrentDevice()
 {
     std::string serialName;
@@ -186,6 +201,31 @@ void HerkuleX::serialSetLatency(int latency)
     serial->setLatency(latency);
 }
 
+int HerkuleX::serialGetLatency()
+{
+    return serial->getLatency();
+}
+
+double HerkuleX::serialGetByteTransfertTime()
+{
+    if (serial == nullptr)
+    {
+        return 0.0;
+    }
+
+    return serial->getByteTransfertTime();
+}
+
+bool HerkuleX::serialSwitchHighSpeed()
+{
+    return serial->switchHighSpeed();
+}
+
+bool HerkuleX::serialSetRS485(const bool enable, const int delayBeforeSend, const int delayAfterSend, const bool rtsOnSend)
+{
+    return serial->setRS485(enable, delayBeforeSend, delayAfterSend, rtsOnSend);
+}
+
 void HerkuleX::setAckPolicy(int ack)
 {
     if (ackPolicy >= ACK_NO_REPLY && ack <= ACK_REPLY_ALL)
@@ -403,6 +443,9 @@ void HerkuleX::hkx_rx_packet()
 
 void HerkuleX::hkx_txrx_packet(int ack)
 {
+    // Round-trip timer, for the transactions expecting a status packet
+    std::chrono::time_point<std::chrono::steady_clock> rttStart = std::chrono::steady_clock::now();
+
 #ifdef LATENCY_TIMER
     // Latency timer for a complete transaction (instruction sent and status received)
     std::chrono::time_point<std::chrono::high_resolution_clock> start, end;
@@ -423,23 +466,14 @@ void HerkuleX::hkx_txrx_packet(int ack)
         ack = ackPolicy;
     }
 
-    if (ack != ACK_NO_REPLY)
+    if (hkx_status_expected(ack, txPacket[PKT_CMD], txPacket[PKT_ID]))
     {
-        int cmd = txPacket[PKT_CMD];
-
-        if ((ack == ACK_REPLY_ALL) ||
-            (ack == ACK_REPLY_READ && (cmd == CMD_STAT || cmd == CMD_EEP_READ || cmd == CMD_RAM_READ)))
-        {
-            do {
-                hkx_rx_packet();
-            }
-            while (commStatus == COMM_RXWAITING);
-        }
-        else
-        {
-            commStatus = COMM_RXSUCCESS;
-            commLock = 0;
+        do {
+            hkx_rx_packet();
         }
+        while (commStatus == COMM_RXWAITING);
+
+        transactionTimes.add(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - rttStart).count());
     }
     else
     {
@@ -459,6 +493,132 @@ void HerkuleX::hkx_txrx_packet(int ack)
 #endif
 }
 
+bool HerkuleX::hkx_status_expected(int ack, const int cmd, const int id)
+{
+    if (ack == ACK_DEFAULT)
+    {
+        ack = ackPolicy;
+    }
+
+    // Packet sent to a broadcast address: no ACK packet
+    if (ack == ACK_NO_REPLY || id == BROADCAST_ID)
+    {
+        return false;
+    }
+
+    return (ack == ACK_REPLY_ALL) ||
+           (ack == ACK_REPLY_READ && (cmd == CMD_STAT || cmd == CMD_EEP_READ || cmd == CMD_RAM_READ));
+}
+
+bool HerkuleX::hkx_get_transaction(SerialTransaction &transaction, const int ack)
+{
+    if (hkx_validate_packet() == 0)
+    {
+        return false;
+    }
+
+    int txPacketSize = hkx_get_txpacket_size();
+    unsigned short crc = hkx_checksum_packet(txPacket, txPacketSize);
+    txPacket[PKT_CHECKSUM1] = get_lowbyte(crc);
+    txPacket[PKT_CHECKSUM2] = get_highbyte(crc);
+
+    transaction.request.assign(txPacket, txPacket + txPacketSize);
+    transaction.responseLength = 0;
+    transaction.frame = nullptr;
+
+    if (hkx_status_expected(ack, txPacket[PKT_CMD], txPacket[PKT_ID]))
+    {
+        // Min size of an ACK packet is 9, read ACK packets also carry the address, length and data
+        int length = 9;
+        if (txPacket[PKT_CMD] == CMD_EEP_READ || txPacket[PKT_CMD] == CMD_RAM_READ)
+        {
+            length = 11 + txPacket[PKT_DATA+1];
+        }
+
+        // Leave some room for garbage bytes before the header
+        transaction.responseLength = length + 9;
+        transaction.frame = [this](const unsigned char *data, const int size) {
+            return hkx_frame_status(data, size);
+        };
+    }
+
+    return true;
+}
+
+int HerkuleX::hkx_frame_status(const unsigned char *data, const int size)
+{
+    // Find packet header
+    int offset = 0;
+    while (offset < size - 1 && (data[offset] != 0xFF || data[offset+1] != 0xFF))
+    {
+        offset++;
+    }
+
+    if (size - offset < 9)
+    {
+        return 0;
+    }
+
+    const unsigned char *packet = data + offset;
+    int packetSize = packet[PKT_LENGTH];
+
+    if (packetSize < 9 || packetSize > MAX_PACKET_LENGTH_hkx)
+    {
+        return -1;
+    }
+
+    if (size - offset < packetSize)
+    {
+        return 0;
+    }
+
+    unsigned short checksum = hkx_checksum_packet(packet, packetSize);
+
+    if (packet[PKT_CHECKSUM1] != get_lowbyte(checksum) ||
+        packet[PKT_CHECKSUM2] != get_highbyte(checksum))
+    {
+        return -1;
+    }
+
+    return offset + packetSize;
+}
+
+int HerkuleX::hkx_rx_status(const SerialTransaction &transaction, const int status, const std::vector <unsigned char> &response)
+{
+    // Put the command packet back, for the error reporting functions
+    size_t txSize = (transaction.request.size() < sizeof(txPacket)) ? transaction.request.size() : sizeof(txPacket);
+    std::copy(transaction.request.begin(), transaction.request.begin() + txSize, txPacket);
+
+    commStatus = status;
+
+    if (status == COMM_RXSUCCESS && response.empty() == false)
+    {
+        // The response has been framed by hkx_frame_status(), skip the bytes before the header
+        size_t offset = 0;
+        while (offset + 1 < response.size() && (response[offset] != 0xFF || response[offset+1] != 0xFF))
+        {
+            offset++;
+        }
+
+        int size = static_cast<int>(response.size() - offset);
+        if (size > static_cast<int>(sizeof(rxPacket)))
+        {
+            size = sizeof(rxPacket);
+        }
+
+        std::copy(response.begin() + offset, response.begin() + offset + size, rxPacket);
+        rxPacketSize = size;
+
+        // Check ID pairing
+        if (txPacket[PKT_ID] != rxPacket[PKT_ID])
+        {
+            commStatus = COMM_RXCORRUPT;
+        }
+    }
+
+    return commStatus;
+}
+
 // Low level API
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -488,7 +648,82 @@ void HerkuleX::hkx_set_txpacket_parameter(int index, int value)
         txPacket[PKT_DATA+index] = get_lowbyte(value);
 }
 
-unsigned short HerkuleX::hkx_checksum_packet(unsigned char *packetData, const int packetSize)
+int HerkuleX::hkx_set_read_packet(const int id, const int address, const int length, const int register_type)
+{
+    // ACK packet overhead is 11 bytes (header, size, id, cmd, checksums, address, length, status error and detail)
+    const int chunkMaxSize = MAX_PACKET_LENGTH_hkx - 11;
+    const int chunkSize = (length > chunkMaxSize) ? chunkMaxSize : length;
+
+    txPacket[PKT_LENGTH] = 7 + 2;
+    txPacket[PKT_ID] = get_lowbyte(id);
+    if (register_type == REGISTER_RAM)
+        txPacket[PKT_CMD] = CMD_RAM_READ;
+    else
+        txPacket[PKT_CMD] = CMD_EEP_READ;
+
+    txPacket[PKT_DATA] = get_lowbyte(address);
+    txPacket[PKT_DATA+1] = get_lowbyte(chunkSize);
+
+    return chunkSize;
+}
+
+int HerkuleX::hkx_set_write_packet(const int id, const int address, const int length, const unsigned char *data, const int register_type)
+{
+    // Command packet overhead is 9 bytes (header, size, id, cmd, checksums, address, length)
+    const int chunkMaxSize = MAX_PACKET_LENGTH_hkx - 9;
+    const int chunkSize = (length > chunkMaxSize) ? chunkMaxSize : length;
+
+    txPacket[PKT_LENGTH] = get_lowbyte(7 + 2 + chunkSize);
+    txPacket[PKT_ID] = get_lowbyte(id);
+    if (register_type == REGISTER_RAM)
+        txPacket[PKT_CMD] = CMD_RAM_WRITE;
+    else
+        txPacket[PKT_CMD] = CMD_EEP_WRITE;
+
+    txPacket[PKT_DATA] = get_lowbyte(address);
+    txPacket[PKT_DATA+1] = get_lowbyte(chunkSize);
+    memcpy(&txPacket[PKT_DATA+2], data, chunkSize);
+
+    return chunkSize;
+}
+
+void HerkuleX::hkx_set_i_jog_packet(const int id, const int mode, const int value)
+{
+    int JOG = 0;
+    int SET = 0;
+
+    txPacket[PKT_LENGTH] = 7 + 5;
+    txPacket[PKT_ID] = get_lowbyte(id);
+    txPacket[PKT_CMD] = CMD_I_JOG;
+
+    if (mode == 0) // Position control
+    {
+        JOG = value; // goal position
+        SET = 0x04; // position control with green led
+    }
+    else // if (mode == 1) // Continuous rotation
+    {
+        if (value >= 0)
+        {
+            JOG = value; // speed
+        }
+        else
+        {
+            JOG = std::abs(value); // speed
+            JOG += 0x4000; // direction
+        }
+        SET = 0x0A; // continuous rotation with blue led
+    }
+
+    // I_JOG(0)
+    txPacket[PKT_DATA]   = get_lowbyte(JOG);
+    txPacket[PKT_DATA+1] = get_highbyte(JOG);
+    txPacket[PKT_DATA+2] = get_lowbyte(SET);
+    txPacket[PKT_DATA+3] = get_lowbyte(id); // id
+    txPacket[PKT_DATA+4] = 0x3c; // playtime
+}
+
+unsigned short HerkuleX::hkx_checksum_packet(const unsigned char *packetData, const int packetSize)
 {
     // Generate checksum
     unsigned short checksum = 0;
@@ -588,6 +823,22 @@ int HerkuleX::hkx_get_rxpacket_parameter(int index)
     return static_cast<int>(rxPacket[PKT_DATA + index]);
 }
 
+int HerkuleX::hkx_get_rxpacket_data(unsigned char *buffer, const int length)
+{
+    // An ACK packet carrying an error can come without the data asked
+    int dataSize = rxPacket[PKT_DATA+1];
+    if (dataSize != length || rxPacket[PKT_LENGTH] < 11 + length)
+    {
+        TRACE_ERROR(HKX, "[#%i] %i byte(s) received instead of %i", hkx_get_last_packet_id(), dataSize, length);
+        commStatus = COMM_RXCORRUPT;
+        return commStatus;
+    }
+
+    memcpy(buffer, &rxPacket[PKT_DATA+2], length);
+
+    return length;
+}
+
 int HerkuleX::hkx_get_last_packet_id()
 {
     // We want to use the ID of the last status packet received through the serial link
@@ -979,41 +1230,77 @@ void HerkuleX::hkx_write_word(const int id, const int address, const int value,
     hkx_txrx_packet(ack);
 }
 
-void HerkuleX::hkx_i_jog(const int id, const int mode, const int value, const int ack)
+int HerkuleX::hkx_read_block(const int id, const int address, const int length, unsigned char *buffer, const int register_type, const int ack)
 {
-    int JOG = 0;
-    int SET = 0;
-    while(commLock);
+    int retcode = -1;
 
-    txPacket[PKT_LENGTH] = 7 + 5;
-    txPacket[PKT_ID] = get_lowbyte(id);
-    txPacket[PKT_CMD] = CMD_I_JOG;
-
-    if (mode == 0) // Position control
+    if (id == 254)
     {
-        JOG = value; // goal position
-        SET = 0x04; // position control with green led
+        TRACE_ERROR(HKX, "Cannot send 'Read' instruction to broadcast address!");
     }
-    else // if (mode == 1) // Continuous rotation
+    else if (ack == ACK_NO_REPLY || (ack == ACK_DEFAULT && ackPolicy == ACK_NO_REPLY))
     {
-        if (value >= 0)
+        TRACE_ERROR(HKX, "Cannot send 'Read' instruction if ACK_NO_REPLY is set!");
+    }
+    else if (length < 1 || buffer == nullptr)
+    {
+        TRACE_ERROR(HKX, "Cannot send 'Read' instruction: invalid block length '%i'!", length);
+    }
+    else
+    {
+        retcode = 0;
+
+        while (retcode < length)
         {
-            JOG = value; // speed
+            while(commLock);
+
+            int chunkSize = hkx_set_read_packet(id, address + retcode, length - retcode, register_type);
+
+            hkx_txrx_packet(ack);
+
+            if (commStatus != COMM_RXSUCCESS ||
+                hkx_get_rxpacket_data(&buffer[retcode], chunkSize) != chunkSize)
+            {
+                retcode = commStatus;
+                break;
+            }
+
+            retcode += chunkSize;
         }
-        else
+    }
+
+    return retcode;
+}
+
+void HerkuleX::hkx_write_block(const int id, const int address, const int length, const unsigned char *buffer, const int register_type, const int ack)
+{
+    if (length < 1 || buffer == nullptr)
+    {
+        TRACE_ERROR(HKX, "Cannot send 'Write' instruction: invalid block length '%i'!", length);
+        return;
+    }
+
+    for (int written = 0; written < length;)
+    {
+        while(commLock);
+
+        int chunkSize = hkx_set_write_packet(id, address + written, length - written, &buffer[written], register_type);
+
+        hkx_txrx_packet(ack);
+
+        if (commStatus < 0)
         {
-            JOG = std::abs(value); // speed
-            JOG += 0x4000; // direction
+            break;
         }
-        SET = 0x0A; // continuous rotation with blue led
+        written += chunkSize;
     }
+}
 
-    // I_JOG(0)
-    txPacket[PKT_DATA]   = get_lowbyte(JOG);
-    txPacket[PKT_DATA+1] = get_highbyte(JOG);
-    txPacket[PKT_DATA+2] = get_lowbyte(SET);
-    txPacket[PKT_DATA+3] = get_lowbyte(id); // id
-    txPacket[PKT_DATA+4] = 0x3c; // playtime
+void HerkuleX::hkx_i_jog(const int id, const int mode, const int value, const int ack)
+{
+    while(commLock);
+
+    hkx_set_i_jog_packet(id, mode, value);
 
     hkx_txrx_packet(ack);
 }
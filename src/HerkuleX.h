@@ -27,10 +27,13 @@
 #include "SerialPortLinux.h"
 #include "SerialPortWindows.h"
 #include "SerialPortMacOS.h"
+#include "SerialPortVirtual.h"
+#include "SerialPortReactor.h"
 
 #include "Utils.h"
 #include "ControlTables.h"
 #include "HerkuleXTools.h"
+#include "TimingHistogram.h"
 
 #include <string>
 #include <vector>
@@ -85,6 +88,8 @@ protected:
     int maxId = 253;                    //!< Store in the maximum value for servo IDs.
     int ackPolicy = ACK_REPLY_READ;     //!< Set the status/ack packet return policy using '::AckPolicy_e' (0: No return; 1: Return for READ commands; 2: Return for all commands).
 
+    TimingHistogram transactionTimes;   //!< Round-trip time (in microseconds) of the transactions expecting a status packet.
+
     // Handle serial link
     ////////////////////////////////////////////////////////////////////////////
 
@@ -101,6 +106,12 @@ protected:
      */
     void serialTerminate();
 
+    /*!
+     * \brief Get the serial port in use, to drive it from a SerialPortReactor.
+     * \return The serial port instance, or nullptr if the serial link is not initialized.
+     */
+    SerialPort *serialGetPort();
+
     // Low level API
     ////////////////////////////////////////////////////////////////////////////
 
@@ -111,8 +122,25 @@ protected:
     void hkx_set_txpacket_instruction(int instruction);
     void hkx_set_txpacket_parameter(int index, int value);
 
+    /*!
+     * \brief Build an 'EEP_READ' or 'RAM_READ' command packet into the TX buffer.
+     * \return The number of bytes requested, less than 'length' if they don't fit into one ACK packet.
+     */
+    int hkx_set_read_packet(const int id, const int address, const int length, const int register_type);
+
+    /*!
+     * \brief Build an 'EEP_WRITE' or 'RAM_WRITE' command packet into the TX buffer.
+     * \return The number of bytes packed, less than 'length' if they don't fit into one command packet.
+     */
+    int hkx_set_write_packet(const int id, const int address, const int length, const unsigned char *data, const int register_type);
+
+    /*!
+     * \brief Build an 'I_JOG' command packet into the TX buffer.
+     */
+    void hkx_set_i_jog_packet(const int id, const int mode, const int value);
+
     //!< Generate a checksum of a packet payload
-    unsigned short hkx_checksum_packet(unsigned char *packetData, const int packetSize);
+    unsigned short hkx_checksum_packet(const unsigned char *packetData, const int packetSize);
 
     // TX packet analysis
     int hkx_get_txpacket_size();
@@ -126,6 +154,53 @@ protected:
     int hkx_get_rxpacket_length_field();
     int hkx_get_rxpacket_parameter(int index);
 
+    /*!
+     * \brief Copy the data carried by the read ACK packet in the RX buffer.
+     * \param buffer: The buffer where the data will be copied. Must be at least 'length' bytes long.
+     * \param length: The number of bytes expected.
+     * \return 'length', or COMM_RXCORRUPT if the ACK packet doesn't carry that many bytes.
+     */
+    int hkx_get_rxpacket_data(unsigned char *buffer, const int length);
+
+    // Asynchronous transactions, see SerialPortReactor
+    ////////////////////////////////////////////////////////////////////////////
+
+    /*!
+     * \brief Check if a command packet will be answered with an ACK packet.
+     * \param ack: Ack policy in effect.
+     * \param cmd: The command.
+     * \param id: The ID the command packet is sent to.
+     * \return true if an ACK packet is expected.
+     */
+    bool hkx_status_expected(int ack, const int cmd, const int id);
+
+    /*!
+     * \brief Turn the command packet in the TX buffer into a transaction.
+     * \param transaction: Filled with the packet, and the size and framing of the ACK packet expected.
+     * \param ack: Ack policy in effect.
+     * \return false if the command packet is invalid.
+     */
+    bool hkx_get_transaction(SerialTransaction &transaction, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Find an ACK packet in a buffer, and check its checksums.
+     * \param data: The bytes received.
+     * \param size: The number of bytes received.
+     * \return The size of the ACK packet (bytes before its header included), 0 if more bytes are needed, or -1 if the ACK packet is invalid.
+     */
+    int hkx_frame_status(const unsigned char *data, const int size);
+
+    /*!
+     * \brief Load the outcome of a transaction, like hkx_txrx_packet() would have left it.
+     * \param transaction: The transaction, with its command packet.
+     * \param status: The transaction status.
+     * \param response: The ACK packet received, framed by hkx_frame_status().
+     * \return The communication status (also available from hkx_get_com_status()).
+     *
+     * The RX buffer then holds the ACK packet, for the usual accessors.
+     */
+    int hkx_rx_status(const SerialTransaction &transaction, const int status, const std::vector <unsigned char> &response);
+
     // Debug methods
     int hkx_get_last_packet_id();
     int hkx_get_com_status();       //!< Get communication status (commStatus) of the latest TX/RX instruction
@@ -146,6 +221,31 @@ protected:
     void hkx_write_byte(const int id, const int address, const int value, const int register_type, const int ack = ACK_DEFAULT);
     int hkx_read_word(const int id, const int address, const int register_type, const int ack = ACK_DEFAULT);
     void hkx_write_word(const int id, const int address, const int value, const int register_type, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Read a contiguous range of registers.
+     * \param id: The servo to read from.
+     * \param address: The address of the first register to read.
+     * \param length: The number of bytes to read.
+     * \param buffer: The buffer where the raw bytes read will be copied. Must be at least 'length' bytes long.
+     * \param register_type: Read from the EEPROM (REGISTER_ROM) or the RAM (REGISTER_RAM).
+     * \param ack: Ack policy in effect.
+     * \return The number of bytes read, or the communication error code (< 0) if one of the reads failed.
+     *
+     * Ranges that don't fit into one ACK packet are read using several consecutive 'Read' commands.
+     */
+    int hkx_read_block(const int id, const int address, const int length, unsigned char *buffer, const int register_type, const int ack = ACK_DEFAULT);
+
+    /*!
+     * \brief Write a contiguous range of registers.
+     * \param id: The servo to write to.
+     * \param address: The address of the first register to write.
+     * \param length: The number of bytes to write.
+     * \param buffer: The raw bytes to write. Must be at least 'length' bytes long.
+     * \param register_type: Write to the EEPROM (REGISTER_ROM) or the RAM (REGISTER_RAM).
+     * \param ack: Ack policy in effect.
+     */
+    void hkx_write_block(const int id, const int address, const int length, const unsigned char *buffer, const int register_type, const int ack = ACK_DEFAULT);
     void hkx_i_jog(const int id, const int mode, const int value, const int ack = ACK_DEFAULT);
     void hkx_s_jog(const int id, const int mode, const int value, const int ack = ACK_DEFAULT);
 
@@ -168,6 +268,30 @@ public:
      */
     void serialSetLatency(int latency);
 
+    /*!
+     * \brief serialGetLatency
+     * \return The latency value currently used to compute timeouts, in milliseconds.
+     */
+    int serialGetLatency();
+
+    /*!
+     * \brief Get the estimated time needed to transfer one byte on the serial link.
+     * \return The byte transfert time in milliseconds, or 0 if the serial link is not open.
+     */
+    double serialGetByteTransfertTime();
+
+    /*!
+     * \brief Switch the serial port into low latency mode (ASYNC_LOW_LATENCY and 1 ms USB latency timer).
+     * \return True if every low latency setting has been applied.
+     */
+    bool serialSwitchHighSpeed();
+
+    /*!
+     * \brief Configure RS-485 direction control on the serial port (see SerialPort::setRS485()).
+     * \return True if the configuration has been applied.
+     */
+    bool serialSetRS485(const bool enable, const int delayBeforeSend = 0, const int delayAfterSend = 0, const bool rtsOnSend = true);
+
     /*!
      * \brief setAckPolicy
      * \param ack: Ack policy value, using '::AckPolicy_e' enum.
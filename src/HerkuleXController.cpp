@@ -24,17 +24,46 @@
 #include "minitraces.h"
 
 // C++ standard libraries
+#include <algorithm>
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <memory>
 
-// Enable latency timer
-//#define LATENCY_TIMER
+/*!
+ * \brief Update the RAM registers of a servo from the raw bytes of a block read.
+ * \param s: The servo.
+ * \param reg_names: The registers to update. Registers outside of the block are ignored.
+ * \param addr: RAM address of the first byte of the block.
+ * \param size: Size of the block, in byte.
+ * \param data: Raw bytes of the block.
+ */
+static void updateRegisters(Servo *s, const std::vector <int> &reg_names, const int addr, const int size, const unsigned char *data)
+{
+    for (auto reg_name: reg_names)
+    {
+        int reg_addr = getRegisterAddr(s->getControlTable(), reg_name, REGISTER_RAM);
+        int reg_size = getRegisterSize(s->getControlTable(), reg_name);
+
+        if (reg_addr >= addr && reg_size > 0 && reg_addr + reg_size <= addr + size)
+        {
+            s->updateValue(reg_name, make_value(&data[reg_addr - addr], reg_size), REGISTER_RAM);
+        }
+    }
+}
 
 HerkuleXController::HerkuleXController(int ctrlFrequency, int servoSerie):
     ControllerAPI(ctrlFrequency)
 {
     this->servoSerie = servoSerie;
+
+    // Default polling plan
+    pollingPlan.setCycles(REG_ABSOLUTE_POSITION, 1, 2);
+    pollingPlan.setCycles(REG_ABSOLUTE_GOAL_POSITION, 1, 2);
+    pollingPlan.setCycles(REG_STATUS_ERROR, 4, 1);
+    pollingPlan.setCycles(REG_STATUS_DETAIL, 4, 1);
+    pollingPlan.setRate(REG_CURRENT_VOLTAGE, 1.0);
+    pollingPlan.setRate(REG_CURRENT_TEMPERATURE, 1.0);
 }
 
 HerkuleXController::~HerkuleXController()
@@ -124,6 +153,16 @@ void HerkuleXController::disconnect()
     serialTerminate();
 }
 
+SerialPort *HerkuleXController::serialGetPort_wrapper()
+{
+    return serialGetPort();
+}
+
+TimingHistogram &HerkuleXController::syncloopTransactionTimes()
+{
+    return transactionTimes;
+}
+
 std::string HerkuleXController::serialGetCurrentDevice_wrapper()
 {
     return serialGetCurrentDevice();
@@ -153,12 +192,14 @@ void HerkuleXController::autodetect_internal(int start, int stop)
     if (stop < 1 || stop > maxId || stop < start)
         stop = maxId;
 
+    // Bring RX packet timeout down to scan faster (unless it's already lower)
+    int latency = serialGetLatency();
 #if defined(_WIN32) || defined(_WIN64)
-    // Bring RX packet timeout down to scan faster
-    serialSetLatency(12);
+    if (latency > 12)
+        serialSetLatency(12);
 #else
-    // Bring RX packet timeout down to scan way faster
-    serialSetLatency(8);
+    if (latency > 8)
+        serialSetLatency(8);
 #endif
 
     TRACE_INFO(CAPI, "HKX ctrl_device_autodetect(port: '%s' / tid: '%i')",
@@ -197,12 +238,11 @@ void HerkuleXController::autodetect_internal(int start, int stop)
             {
                 servoListLock.lock();
 
-                // Add the servo to the controller
-                servoList.push_back(servo);
-
-                // Mark it for an "initial read" and synchronization
-                updateList.push_back(servo->getId());
-                syncList.push_back(servo->getId());
+                // Add the servo to the controller, and mark it for an "initial read" and synchronization
+                if (servoRegistry.add(servo) == false)
+                {
+                    delete servo;
+                }
 
                 servoListLock.unlock();
             }
@@ -218,451 +258,613 @@ void HerkuleXController::autodetect_internal(int start, int stop)
     printf("\n");
 
     // Restore RX packet timeout
-    serialSetLatency(LATENCY_TIME_DEFAULT);
+    serialSetLatency(latency);
 
     setState(state_scanned);
 }
 
-void HerkuleXController::run()
+double HerkuleXController::estimateCycleDuration()
 {
-    TRACE_INFO(CAPI, "HerkuleXController::run(port: '%s' / tid: '%i')",
-               serialGetCurrentDevice().c_str(), std::this_thread::get_id());
+    // Packets overhead: header, packet size, ID, command and checksums
+    const int overhead = 7;
+    const int readRequest = overhead + 2;   // address and length
+    const int readAck = overhead + 2 + 2;   // address, length, and status error / detail
+    const int jogRequest = overhead + 5;
 
-    std::chrono::time_point<std::chrono::system_clock> start, end;
+    double bytes = 0.0;
 
-    while (getState() >= state_started)
+    std::vector < std::vector <int> > regLists;
+    std::vector <double> shares;
+    std::vector <RegisterBlock> blocks;
+
+    for (auto s: servoRegistry.getSyncServos())
     {
-        // Loop timer
-        start = std::chrono::system_clock::now();
+        // Assume a new goal position every cycle, sent with one 'I_JOG' instruction per servo
+        bytes += jogRequest;
 
-        // MESSAGE PARSING
-        ////////////////////////////////////////////////////////////////////////
+        if (s->getStatusReturnLevel() == ACK_NO_REPLY)
+        {
+            continue;
+        }
 
-        unsigned ignoreMsg = 0;
+        // One 'RAM Read' per block of registers, for every distinct list of
+        // registers read by the polling schedule, weighted by its share of the cycles
+        pollingSchedule.getReadLists(s->getId(), regLists, shares);
 
-        m_mutex.lock();
-        while (m_queue.empty() == false && m_queue.size() != ignoreMsg)
+        for (size_t i = 0; i < regLists.size(); i++)
         {
-            miniMessages m = m_queue.front();
-            m_mutex.unlock();
+            getRegisterBlocks(s->getControlTable(), &regLists[i][0], regLists[i].size(), REGISTER_RAM, blocks);
 
-            switch (m.msg)
+            for (const auto &b: blocks)
             {
-            case ctrl_device_autodetect:
-                autodetect_internal(m.p1, m.p2);
-                break;
-
-            case ctrl_device_register:
-                // handle registering servo by "id"?
-                registerServo_internal(static_cast<Servo *>(m.p));
-                break;
-            case ctrl_device_unregister:
-                unregisterServo_internal(static_cast<Servo *>(m.p));
-                break;
-            case ctrl_device_unregister_all:
-                unregisterServos_internal();
-                break;
+                bytes += shares[i] * (readRequest + readAck + b.block_size);
+            }
+        }
+    }
 
-            case ctrl_device_delayed_add:
-                if (delayedAddServos_internal(m.delay, m.p1, m.p2) == 1)
-                {
-                    ignoreMsg++;
-                    sendMessage(&m);
-                }
-                break;
+    return bytes * serialGetByteTransfertTime();
+}
 
-            case ctrl_state_pause:
-                TRACE_INFO(CAPI, ">> THREAD (tid: '%i') paused by message", std::this_thread::get_id());
-                m_mutex.lock();
-                m_queue.pop_front();
-                m_mutex.unlock();
-                return;
-                break;
-            case ctrl_state_stop:
-                TRACE_INFO(CAPI, ">> THREAD (tid: '%i') termination by 'stop message'", std::this_thread::get_id());
-                m_mutex.lock();
-                m_queue.pop_front();
-                m_mutex.unlock();
-                return;
-                break;
+bool HerkuleXController::readRegisterSnapshot(Servo *s)
+{
+    int id = s->getId();
+    int ack = s->getStatusReturnLevel();
 
-            default:
-                TRACE_WARNING(HKX, "Unknown message type: '%i'", m.msg);
-                break;
-            }
+    // Raw images of the EEPROM and RAM areas, indexed by register address
+    std::vector <unsigned char> images[2];
+    const int types[2] = {REGISTER_ROM, REGISTER_RAM};
+    int model = -1, firmware = -1;
+    bool romCached = false;
 
-            m_mutex.lock();
-            m_queue.pop_front();
-        }
-        m_mutex.unlock();
+    for (int t = 0; t < 2; t++)
+    {
+        std::vector <RegisterBlock> blocks;
+        int imageSize = getRegisterBlocks(s->getControlTable(), types[t], blocks);
 
-        // ACTION LOOP
-        ////////////////////////////////////////////////////////////////////////
+        images[t].resize(imageSize, 0);
 
-        servoListLock.lock();
-        for (auto s: servoList)
+        if (types[t] == REGISTER_ROM && imageSize > 0 && registerCache.isEnabled())
         {
-            int id = s->getId();
-            int ack = s->getStatusReturnLevel();
-
-            int actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed;
-            s->getActions(actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed);
+            // Verify the cached EEPROM image (if any) with one small read
+            int verifySize = RegisterCache::getVerificationSize(s->getControlTable());
+            std::vector <unsigned char> cached;
 
-            if (refreshProgrammed == 1)
+            if (verifySize > 0)
             {
-                // Every servo register value will be updated
-                updateList.push_back(id);
-                TRACE_INFO(HKX, "Refresh servo #%i registers", id);
-            }
+                int status = hkx_read_block(id, 0, verifySize, &images[t][0], REGISTER_ROM, ack);
+                s->setError(hkx_get_rxpacket_error());
+                s->setStatus(hkx_get_rxpacket_status_detail());
+                updateErrorCount(hkx_get_com_error_count());
+                hkx_print_error();
 
-            if (rebootProgrammed == 1)
-            {
-                // Remove servo from sync/update lists; Need to be added again after reboot!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
+                if (status != verifySize)
                 {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
+                    return false;
                 }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
+
+                RegisterCache::getModelAndFirmware(s->getControlTable(), &images[t][0], model, firmware);
+
+                if (registerCache.getImage(serialGetCurrentDevice(), id, model, firmware, cached) &&
+                    static_cast<int>(cached.size()) == imageSize &&
+                    std::equal(images[t].begin(), images[t].begin() + verifySize, cached.begin()))
                 {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
+                    TRACE_1(HKX, "[#%i] Using cached EEPROM image", id);
+                    images[t] = cached;
+                    romCached = true;
+                    continue;
                 }
+            }
+        }
 
-                // Reboot
-                hkx_reboot(id, ack);
-                TRACE_INFO(HKX, "Rebooting servo #%i...", id);
+        for (const auto &b: blocks)
+        {
+            TRACE_1(HKX, "Reading %s block addr: '%i' size: '%i'", (types[t] == REGISTER_ROM) ? "ROM" : "RAM", b.block_addr, b.block_size);
 
-                miniMessages m {ctrl_device_delayed_add, std::chrono::system_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
-                sendMessage(&m);
-            }
+            int status = hkx_read_block(id, b.block_addr, b.block_size, &images[t][b.block_addr], types[t], ack);
+            s->setError(hkx_get_rxpacket_error());
+            s->setStatus(hkx_get_rxpacket_status_detail());
+            updateErrorCount(hkx_get_com_error_count());
+            hkx_print_error();
 
-            if (resetProgrammed > 0)
+            if (status != b.block_size)
             {
-                // Remove servo from sync/update lists; Need to be added again after reset!
-                for (std::vector <int>::iterator it = updateList.begin(); it != updateList.end();)
-                {
-                    if (*it == id)
-                    { updateList.erase(it); }
-                    else
-                    { ++it; }
-                }
-                for (std::vector <int>::iterator it = syncList.begin(); it != syncList.end();)
-                {
-                    if (*it == id)
-                    { syncList.erase(it); }
-                    else
-                    { ++it; }
-                }
+                return false;
+            }
+        }
+    }
 
-                // Reset
-                hkx_reset(id, resetProgrammed, ack);
-                TRACE_INFO(HKX, "Resetting servo #%i (setting: %i)...", id, resetProgrammed);
+    // Decode register values
+    for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
+    {
+        struct RegisterInfos reg;
+        int reg_name = getRegisterName(s->getControlTable(), ctid);
+        getRegisterInfos(s->getControlTable(), reg_name, reg);
 
-                miniMessages m {ctrl_device_delayed_add, std::chrono::system_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
-                sendMessage(&m);
-            }
+        if (reg.reg_addr_rom >= 0 && reg.reg_addr_rom + reg.reg_size <= static_cast<int>(images[0].size()))
+        {
+            s->updateValue(reg_name, make_value(&images[0][reg.reg_addr_rom], reg.reg_size), REGISTER_ROM);
+        }
+        if (reg.reg_addr_ram >= 0 && reg.reg_addr_ram + reg.reg_size <= static_cast<int>(images[1].size()))
+        {
+            s->updateValue(reg_name, make_value(&images[1][reg.reg_addr_ram], reg.reg_size), REGISTER_RAM);
+        }
+    }
+
+    // Save the EEPROM image for the next time
+    if (registerCache.isEnabled() && images[0].empty() == false && romCached == false)
+    {
+        RegisterCache::getModelAndFirmware(s->getControlTable(), &images[0][0], model, firmware);
+        registerCache.setImage(serialGetCurrentDevice(), id, model, firmware, images[0]);
+    }
+
+    return true;
+}
+
+bool HerkuleXController::syncloopMaintenance()
+{
+    // MESSAGE PARSING
+    ////////////////////////////////////////////////////////////////////////////
+
+    miniMessages m;
+    while (receiveMessage(m))
+    {
+        switch (m.msg)
+        {
+        case ctrl_device_autodetect:
+            autodetect_internal(m.p1, m.p2);
+            break;
+
+        case ctrl_device_register:
+            // handle registering servo by "id"?
+            registerServo_internal(static_cast<Servo *>(m.p));
+            break;
+        case ctrl_device_unregister:
+            unregisterServo_internal(static_cast<Servo *>(m.p));
+            break;
+        case ctrl_device_unregister_all:
+            unregisterServos_internal();
+            break;
+
+        case ctrl_device_delayed_add:
+            delayedAddServos_internal(m.p1, m.p2);
+            break;
+
+        case ctrl_state_pause:
+            TRACE_INFO(CAPI, ">> THREAD (tid: '%i') paused by message", std::this_thread::get_id());
+            return false;
+            break;
+        case ctrl_state_stop:
+            TRACE_INFO(CAPI, ">> THREAD (tid: '%i') termination by 'stop message'", std::this_thread::get_id());
+            return false;
+            break;
+
+        default:
+            TRACE_WARNING(HKX, "Unknown message type: '%i'", m.msg);
+            break;
         }
-        servoListLock.unlock();
+    }
+
+    syncloopPhaseEnd(phase_messages);
+
+    // ACTION LOOP
+    ////////////////////////////////////////////////////////////////////////////
+
+    servoListLock.lock();
+    for (auto s: servoRegistry.getServos())
+    {
+        int id = s->getId();
+        int ack = s->getStatusReturnLevel();
 
-        // INITIAL READ LOOP
-        ////////////////////////////////////////////////////////////////////////
+        int actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed;
+        s->getActions(actionProgrammed, rebootProgrammed, refreshProgrammed, resetProgrammed);
 
-        servoListLock.lock();
-        if (updateList.empty() == false)
+        if (refreshProgrammed == 1)
         {
-            std::vector <int>::iterator itr;
-            for (itr = updateList.begin(); itr != updateList.end();)
+            // Every servo register value will be updated
+            servoRegistry.setUpdate(id, true);
+            TRACE_INFO(HKX, "Refresh servo #%i registers", id);
+        }
+
+        if (rebootProgrammed == 1)
+        {
+            // Remove servo from sync/update lists; Need to be added again after reboot!
+            servoRegistry.setUpdate(id, false);
+            servoRegistry.setSync(id, false);
+
+            // Reboot
+            hkx_reboot(id, ack);
+            TRACE_INFO(HKX, "Rebooting servo #%i...", id);
+
+            miniMessages m {ctrl_device_delayed_add, std::chrono::steady_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
+            sendMessage(&m);
+        }
+
+        if (resetProgrammed > 0)
+        {
+            // Remove servo from sync/update lists; Need to be added again after reset!
+            servoRegistry.setUpdate(id, false);
+            servoRegistry.setSync(id, false);
+
+            // Reset
+            hkx_reset(id, resetProgrammed, ack);
+            registerCache.invalidate(serialGetCurrentDevice(), id);
+            TRACE_INFO(HKX, "Resetting servo #%i (setting: %i)...", id, resetProgrammed);
+
+            miniMessages m {ctrl_device_delayed_add, std::chrono::steady_clock::now() + std::chrono::seconds(2), nullptr, id, 1};
+            sendMessage(&m);
+        }
+    }
+    servoListLock.unlock();
+
+    syncloopPhaseEnd(phase_actions);
+
+    // INITIAL READ LOOP
+    ////////////////////////////////////////////////////////////////////////////
+
+    servoListLock.lock();
+    if (servoRegistry.getUpdateServos().empty() == false)
+    {
+        setState(state_reading);
+
+        // Copy the list, servos are removed from it once read
+        const std::vector <Servo *> updateServos(servoRegistry.getUpdateServos());
+        for (auto s: updateServos)
+        {
+            // Read the whole EEPROM and RAM areas with a few block reads,
+            // or fall back to one read instruction per register
+            if (readRegisterSnapshot(s) == false)
             {
-                setState(state_reading);
+                int id = s->getId();
+                int ack = s->getStatusReturnLevel();
 
-                for (auto s: servoList)
+                for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
                 {
-                    if (s->getId() == (*itr))
-                    {
-                        int id = s->getId();
-                        int ack = s->getStatusReturnLevel();
+                    struct RegisterInfos reg;
+                    int reg_name = getRegisterName(s->getControlTable(), ctid);
+                    getRegisterInfos(s->getControlTable(), reg_name, reg);
 
-                        for (int ctid = 1; ctid < s->getRegisterCount(); ctid++)
+                    TRACE_1(HKX, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg.reg_addr, reg.reg_size);
+
+                    int reg_type = REGISTER_AUTO;
+                    if (reg.reg_addr_rom >= 0 && reg.reg_addr_ram >= 0)
+                        reg_type = REGISTER_BOTH;
+                    else if (reg.reg_addr_rom >= 0)
+                        reg_type = REGISTER_ROM;
+                    else if (reg.reg_addr_ram >= 0)
+                        reg_type = REGISTER_RAM;
+
+                    if (reg.reg_size == 1)
+                    {
+                        if (reg_type == REGISTER_BOTH)
                         {
-                            struct RegisterInfos reg;
-                            int reg_name = getRegisterName(s->getControlTable(), ctid);
-                            getRegisterInfos(s->getControlTable(), reg_name, reg);
-
-                            TRACE_1(HKX, "Reading value for reg [%i] name: '%s' addr: '%i' size: '%i'", ctid, getRegisterNameTxt(reg_name).c_str(), reg.reg_addr, reg.reg_size);
-
-                            int reg_type = REGISTER_AUTO;
-                            if (reg.reg_addr_rom >= 0 && reg.reg_addr_ram >= 0)
-                                reg_type = REGISTER_BOTH;
-                            else if (reg.reg_addr_rom >= 0)
-                                reg_type = REGISTER_ROM;
-                            else if (reg.reg_addr_ram >= 0)
-                                reg_type = REGISTER_RAM;
-
-                            if (reg.reg_size == 1)
-                            {
-                                if (reg_type == REGISTER_BOTH)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                                else if (reg_type == REGISTER_ROM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                }
-                                else if (reg_type == REGISTER_RAM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                            }
-                            else //if (reg.reg_size == 2)
-                            {
-                                if (reg_type == REGISTER_BOTH)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                                else if (reg_type == REGISTER_ROM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
-                                }
-                                else if (reg_type == REGISTER_RAM)
-                                {
-                                    s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
-                                }
-                            }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
+                            s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                            s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
+                        }
+                        else if (reg_type == REGISTER_ROM)
+                        {
+                            s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                        }
+                        else if (reg_type == REGISTER_RAM)
+                        {
+                            s->updateValue(reg_name, hkx_read_byte(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
+                        }
+                    }
+                    else //if (reg.reg_size == 2)
+                    {
+                        if (reg_type == REGISTER_BOTH)
+                        {
+                            s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                            s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
+                        }
+                        else if (reg_type == REGISTER_ROM)
+                        {
+                            s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_rom, REGISTER_ROM, ack), REGISTER_ROM);
+                        }
+                        else if (reg_type == REGISTER_RAM)
+                        {
+                            s->updateValue(reg_name, hkx_read_word(id, reg.reg_addr_ram, REGISTER_RAM, ack), REGISTER_RAM);
                         }
-
-                        // Once all registers are read, remove the servo from the "updateList"
-                        itr = updateList.erase(itr);
                     }
+
+                    s->setError(hkx_get_rxpacket_error());
+                    s->setStatus(hkx_get_rxpacket_status_detail());
+                    updateErrorCount(hkx_get_com_error_count());
+                    hkx_print_error();
                 }
             }
-            setState(state_ready);
+
+            // Once all registers are read, remove the servo from the "updateList"
+            servoRegistry.setUpdate(s->getId(), false);
         }
-        servoListLock.unlock();
 
-        // SYNCHRONIZATION LOOP
-        ////////////////////////////////////////////////////////////////////////
+        setState(state_ready);
+    }
+    servoListLock.unlock();
+
+    syncloopPhaseEnd(phase_initial_read);
+
+    return true;
+}
 
-        int cumulid = 0;
+void HerkuleXController::syncCollect(std::vector <SyncOperation> &ops)
+{
+    // Servos to synchronize during this cycle
+    std::vector <ServoHerkuleX *> syncServos;
 
-        servoListLock.lock();
-        for (auto id: syncList)
+    servoListLock.lock();
+    for (auto s_raw: servoRegistry.getSyncServos())
+    {
+        syncServos.push_back(static_cast<ServoHerkuleX*>(s_raw));
+    }
+    servoListLock.unlock();
+
+    std::vector <int> regs;
+    std::vector <RegisterBlock> blocks;
+
+    for (auto s: syncServos)
+    {
+        int id = s->getId();
+
+        // Unregister device if it reach an error count too high
+        // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
+        if (s->getErrorCount() > 16)
         {
-            cumulid++;
-            cumulid %= syncloopFrequency;
+            TRACE_ERROR(HKX, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...", id, serialGetCurrentDevice().c_str());
+            unregisterServo(s);
+            continue;
+        }
 
-            for (auto s_raw: servoList)
+        // Commit register modifications (only visit the registers with a pending commit)
+        uint64_t dirty = s->getDirtyRegisters();
+        for (int ctid = 0; dirty != 0 && ctid < s->getRegisterCount(); ctid++)
+        {
+            if ((dirty & (1ULL << ctid)) == 0)
             {
-                servoListLock.unlock();
+                continue;
+            }
 
-                ServoHerkuleX *s = static_cast<ServoHerkuleX*>(s_raw);
+            int regname = getRegisterName(s->getControlTable(), ctid);
+            int regsize = getRegisterSize(s->getControlTable(), regname);
 
-                if (s->getId() == id)
+            for (int regtype: {REGISTER_ROM, REGISTER_RAM})
+            {
+                if (s->getValueCommit(regname, regtype) == 1)
                 {
-                    int ack = s->getStatusReturnLevel();
+                    SyncOperation op;
+                    op.type = op_write;
+                    op.servo = s;
+                    op.reg_name = regname;
+                    op.reg_type = regtype;
+                    op.addr = getRegisterAddr(s->getControlTable(), regname, regtype);
+                    op.value = s->getValue(regname, regtype);
+                    op.data.resize(regsize);
+
+                    TRACE_1(HKX, "Writing %s value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
+                            (regtype == REGISTER_ROM) ? "ROM" : "RAM", op.value, ctid, getRegisterNameTxt(regname).c_str(), op.addr, regsize);
+
+                    ops.push_back(op);
+                }
+            }
+        }
 
-                    // Unregister device if it reach an error count too high
-                    // Count must be high enough to avoid "false positive": device producing a lot of errors but still present on the serial link
-                    if (s->getErrorCount() > 16)
-                    {
-                        TRACE_ERROR(HKX, "Device #%i has an error count too high and is going to be unregistered from its controller on '%s'...", id, serialGetCurrentDevice().c_str());
-                        unregisterServo(s);
-                        continue;
-                    }
+        // Goal position, sent before the reads so they reflect it
+        if (s->getGoalPositionCommited() == 1)
+        {
+            SyncOperation op;
+            op.type = op_jog;
+            op.servo = s;
+            op.value = s->getGoalPosition();
+            ops.push_back(op);
+        }
 
-                    // Commit register modifications
-                    for (int ctid = 0; ctid < s->getRegisterCount(); ctid++)
-                    {
-                        int regname = getRegisterName(s->getControlTable(), ctid);
-                        int regsize = getRegisterSize(s->getControlTable(), regname);
+        // Read the registers due during this cycle, following the polling
+        // schedule, with one 'RAM Read' per block of contiguous registers
+        if (s->getStatusReturnLevel() != ACK_NO_REPLY)
+        {
+            pollingSchedule.getDueRegisters(id, syncloopCounter, regs);
 
-                        if (s->getValueCommit(regname, REGISTER_ROM) == 1)
-                        {
-                            int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_ROM);
-
-                            TRACE_1(HKX, "Writing ROM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                    s->getValue(regname, REGISTER_ROM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
-
-                            if (regsize == 1)
-                            {
-                                hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
-                            }
-                            else //if (regsize == 2)
-                            {
-                                hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_ROM), REGISTER_ROM, ack);
-                            }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            s->commitValue(regname, 0, REGISTER_ROM);
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
-
-                            if (regname == REG_ID)
-                            {
-                                if (s->changeInternalId(s->getValue(regname)) == 1)
-                                {
-                                    s->reboot();
-                                }
-                            }
-                        }
+            if (regs.empty() == false)
+            {
+                getRegisterBlocks(s->getControlTable(), &regs[0], regs.size(), REGISTER_RAM, blocks);
+            }
+            else
+            {
+                blocks.clear();
+            }
 
-                        if (s->getValueCommit(regname, REGISTER_RAM) == 1)
-                        {
-                            int regaddr = getRegisterAddr(s->getControlTable(), regname, REGISTER_RAM);
-
-                            TRACE_1(HKX, "Writing RAM value '%i' for reg [%i] name: '%s' addr: '%i' size: '%i'",
-                                    s->getValue(regname, REGISTER_RAM), ctid, getRegisterNameTxt(regname).c_str(), regaddr, regsize);
-
-                            if (regsize == 1)
-                            {
-                                hkx_write_byte(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
-                            }
-                            else //if (regsize == 2)
-                            {
-                                hkx_write_word(id, regaddr, s->getValue(regname, REGISTER_RAM), REGISTER_RAM, ack);
-                            }
-
-                            s->setError(hkx_get_rxpacket_error());
-                            s->setStatus(hkx_get_rxpacket_status_detail());
-                            s->commitValue(regname, 0, REGISTER_RAM);
-                            updateErrorCount(hkx_get_com_error_count());
-                            hkx_print_error();
-
-                            // FIXME: probably doesn't work...
-                            if (regname == REG_ID)
-                            {
-                                unregisterServo(s);
-                                if (s->changeInternalId(s->getValue(regname)) == 1)
-                                {
-                                    registerServo(s);
-                                }
-                            }
-                        }
-                    }
+            for (const auto &b: blocks)
+            {
+                SyncOperation op;
+                op.type = op_read;
+                op.servo = s;
+                op.regs = regs;
+                op.reg_type = REGISTER_RAM;
+                op.addr = b.block_addr;
+                op.data.resize(b.block_size);
+                ops.push_back(op);
+            }
+        }
+    }
+}
 
-                    // 1 Hz "low priority" update loop
-                    if (((syncloopCounter - cumulid) == 0) &&
-                        (ack != ACK_NO_REPLY))
-                    {
-                        // Read voltage
-                        s->updateValue(REG_CURRENT_VOLTAGE, hkx_read_byte(id, s->gaddr(REG_CURRENT_VOLTAGE), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-
-                        // Read temp
-                        s->updateValue(REG_CURRENT_TEMPERATURE, hkx_read_byte(id, s->gaddr(REG_CURRENT_TEMPERATURE), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-                    }
+void HerkuleXController::syncOperationDone(SyncOperation &op, const bool success)
+{
+    ServoHerkuleX *s = op.servo;
+    int id = s->getId();
 
-                    // x/4 Hz "feedback" update loop
-                    if (((syncloopCounter - cumulid) % 4 == 0) &&
-                        (ack != ACK_NO_REPLY))
-                    {
-                        s->updateValue(REG_STATUS_ERROR, hkx_read_byte(id, s->gaddr(REG_STATUS_ERROR), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-
-                        s->updateValue(REG_STATUS_DETAIL, hkx_read_byte(id, s->gaddr(REG_STATUS_DETAIL), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-/*
-                        s->updateCurrentSpeed(hkx_read_word(id, s->gaddr(SERVO_CURRENT_SPEED), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-
-                        s->updateCurrentLoad(hkx_read_word(id, s->gaddr(SERVO_CURRENT_LOAD), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-*/
-                    }
+    if (op.type == op_jog)
+    {
+        if (hkx_print_error() == 0)
+        {
+            s->commitGoalPosition();
+        }
+        return;
+    }
 
-                    // x Hz "full speed" update loop
-                    {
-                        // Get "current" values from devices, and write them into corresponding objects
-                        int cpos = hkx_read_word(id, s->gaddr(REG_ABSOLUTE_POSITION), REGISTER_RAM, ack);
-                        s->updateValue(REG_ABSOLUTE_POSITION, cpos);
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-
-                        if (s->getGoalPositionCommited() == 1)
-                        {
-                            int gpos = s->getGoalPosition();
+    s->setError(hkx_get_rxpacket_error());
+    s->setStatus(hkx_get_rxpacket_status_detail());
 
-                            hkx_i_jog(id, 0, gpos, ack);
-                            if (hkx_print_error() == 0)
-                            {
-                                s->commitGoalPosition();
-                            }
-                        }
+    if (op.type == op_read)
+    {
+        updateErrorCount(hkx_get_com_error_count());
+        hkx_print_error();
 
-                        s->updateValue(REG_ABSOLUTE_GOAL_POSITION, hkx_read_word(id, s->gaddr(REG_ABSOLUTE_GOAL_POSITION), REGISTER_RAM, ack));
-                        s->setError(hkx_get_rxpacket_error());
-                        s->setStatus(hkx_get_rxpacket_status_detail());
-                        updateErrorCount(hkx_get_com_error_count());
-                        hkx_print_error();
-                    }
-                }
+        if (success)
+        {
+            updateRegisters(s, op.regs, op.addr, static_cast<int>(op.data.size()), &op.data[0]);
+        }
+        return;
+    }
 
+    if (op.reg_type == REGISTER_ROM)
+    {
+        // The cached EEPROM image of this device is now outdated
+        registerCache.invalidate(serialGetCurrentDevice(), id);
+    }
+
+    s->commitValue(op.reg_name, 0, op.reg_type);
+    updateErrorCount(hkx_get_com_error_count());
+    hkx_print_error();
+
+    if (op.reg_name == REG_ID)
+    {
+        if (op.reg_type == REGISTER_ROM)
+        {
+            if (s->changeInternalId(s->getValue(op.reg_name)) == 1)
+            {
                 servoListLock.lock();
+                servoRegistry.changeId(id);
+                servoListLock.unlock();
+
+                s->reboot();
             }
         }
+        else
+        {
+            // FIXME: probably doesn't work...
+            unregisterServo(s);
+            if (s->changeInternalId(s->getValue(op.reg_name)) == 1)
+            {
+                registerServo(s);
+            }
+        }
+    }
+}
 
-        // Make sure we unlock servoList
-        servoListLock.unlock();
-
-        // Loop control
-        syncloopCounter++;
-        syncloopCounter %= syncloopFrequency;
+void HerkuleXController::syncloopSynchronize()
+{
+    std::vector <SyncOperation> ops;
+    syncCollect(ops);
 
-        // Loop timer
-        end = std::chrono::system_clock::now();
-        double loopd = std::chrono::duration_cast<std::chrono::microseconds>(end-start).count();
-        double waitd = (syncloopDuration * 1000.0) - loopd;
+    for (auto &op: ops)
+    {
+        int id = op.servo->getId();
+        int ack = op.servo->getStatusReturnLevel();
 
-#ifdef LATENCY_TIMER
-        if ((loopd / 1000.0) > syncloopDuration)
+        if (op.type == op_write)
+        {
+            if (op.data.size() == 1)
+            {
+                hkx_write_byte(id, op.addr, op.value, op.reg_type, ack);
+            }
+            else //if (op.data.size() == 2)
+            {
+                hkx_write_word(id, op.addr, op.value, op.reg_type, ack);
+            }
+            syncOperationDone(op, true);
+        }
+        else if (op.type == op_jog)
         {
-            TRACE_WARNING(HKX, "Sync loop duration: %fms of the %fms budget.", (loopd / 1000.0), syncloopDuration);
+            hkx_i_jog(id, 0, op.value, ack);
+            syncOperationDone(op, true);
         }
         else
         {
-            TRACE_INFO(HKX, "Sync loop duration: %fms of the %fms budget.", (loopd / 1000.0), syncloopDuration);
+            int size = static_cast<int>(op.data.size());
+            int status = hkx_read_block(id, op.addr, size, &op.data[0], op.reg_type, ack);
+            syncOperationDone(op, status == size);
+        }
+    }
+}
+
+bool HerkuleXController::syncloopSubmit(std::function <void ()> done)
+{
+    std::shared_ptr < std::vector <SyncOperation> > ops = std::make_shared < std::vector <SyncOperation> >();
+    syncCollect(*ops);
+
+    std::vector <SerialTransaction> transactions;
+    SerialTransaction t;
+
+    for (size_t i = 0; i < ops->size(); i++)
+    {
+        SyncOperation &op = (*ops)[i];
+        int id = op.servo->getId();
+        int ack = op.servo->getStatusReturnLevel();
+        int size = static_cast<int>(op.data.size());
+
+        if (op.type == op_write)
+        {
+            for (int b = 0; b < size; b++)
+            {
+                op.data[b] = static_cast<unsigned char>((op.value >> (8 * b)) & 0xFF);
+            }
+            hkx_set_write_packet(id, op.addr, size, &op.data[0], op.reg_type);
+        }
+        else if (op.type == op_jog)
+        {
+            hkx_set_i_jog_packet(id, 0, op.value);
         }
-#endif // LATENCY_TIMER
 
-        if (waitd > 0.0)
+        if (op.type != op_read)
         {
-            std::chrono::microseconds waittime(static_cast<int>(waitd));
-            std::this_thread::sleep_for(waittime);
+            if (hkx_get_transaction(t, ack) == false)
+            {
+                continue;
+            }
+
+            SerialTransaction request = t;
+            t.callback = [this, ops, i, request](int status, const std::vector <unsigned char> &response) {
+                hkx_rx_status(request, status, response);
+                syncOperationDone((*ops)[i], true);
+            };
+            transactions.push_back(t);
+            continue;
+        }
+
+        for (int offset = 0; offset < size;)
+        {
+            int chunkSize = hkx_set_read_packet(id, op.addr + offset, size - offset, op.reg_type);
+            if (hkx_get_transaction(t, ack) == false)
+            {
+                break;
+            }
+
+            const bool last = (offset + chunkSize >= size);
+            SerialTransaction request = t;
+
+            t.callback = [this, ops, i, offset, chunkSize, last, request](int status, const std::vector <unsigned char> &response) {
+                SyncOperation &op = (*ops)[i];
+                if (op.failed)
+                {
+                    return;
+                }
+
+                bool success = (hkx_rx_status(request, status, response) == COMM_RXSUCCESS &&
+                                hkx_get_rxpacket_data(&op.data[offset], chunkSize) == chunkSize);
+                op.failed = (success == false);
+
+                if (last || op.failed)
+                {
+                    syncOperationDone(op, success);
+                }
+            };
+            transactions.push_back(t);
+
+            offset += chunkSize;
         }
     }
 
-    TRACE_INFO(HKX, ">> THREAD (tid: '%i') termination by 'loop exit'", std::this_thread::get_id());
+    syncloopSubmitTransactions(transactions, [ops, done]() { done(); });
+
+    return true;
 }
@@ -42,17 +42,62 @@
  */
 class HerkuleXController: public HerkuleX, public ControllerAPI
 {
+    enum SyncOperationType
+    {
+        op_write = 0,
+        op_jog,
+        op_read
+    };
+
+    /*!
+     * \brief One instruction sent to one servo during a synchronization cycle.
+     */
+    struct SyncOperation
+    {
+        SyncOperationType type = op_read;
+        ServoHerkuleX *servo = nullptr;
+        int reg_name = 0;                   //!< Register written (op_write only).
+        int reg_type = REGISTER_RAM;        //!< Memory area written or read.
+        int addr = 0;
+        int value = 0;                      //!< Register value (op_write) or goal position (op_jog).
+        std::vector <int> regs;             //!< The registers due during this cycle (op_read only).
+        std::vector <unsigned char> data;   //!< Raw bytes written or read, starting at 'addr'.
+        bool failed = false;
+    };
+
     //! Compute some internal settings (ackPolicy, maxId, protocolVersion) depending on current servo serie and serial device.
     void updateInternalSettings();
 
-    //! Read/write synchronization loop, running inside its own background thread
-    void run();
+    bool syncloopMaintenance();
+    void syncloopSynchronize();
+    bool syncloopSubmit(std::function <void ()> done);
+    TimingHistogram &syncloopTransactionTimes();
+
+    /*!
+     * \brief Gather the register writes, goal positions and feedback reads of a synchronization cycle.
+     * \param ops: Filled with the instructions to send, in order.
+     *
+     * Servos with too many errors are unregistered.
+     */
+    void syncCollect(std::vector <SyncOperation> &ops);
+
+    //! Report the outcome of an instruction, and commit or update the servo registers.
+    void syncOperationDone(SyncOperation &op, const bool success);
+
+    /*!
+     * \brief Read the EEPROM and RAM areas of a servo using a few block reads, and update the servo object.
+     * \param s: The servo to read.
+     * \return true if every register has been read, false otherwise.
+     */
+    bool readRegisterSnapshot(Servo *s);
+
+    double estimateCycleDuration();
 
 public:
     /*!
      * \brief HerkuleXController constructor.
      * \param servoSerie: The servo serie to use with this controller. Only used to choose the right communication protocol.
-     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;120], default is 30.
+     * \param ctrlFrequency: This is the synchronization frequency between the controller and the servos devices. Range is [1;1000], default is 30.
      */
     HerkuleXController(int ctrlFrequency = 30, int servoSerie = SERVO_DRS);
 
@@ -91,6 +136,7 @@ public:
     void autodetect_internal(int start = 0, int stop = 253);
 
     // Wrappers
+    SerialPort *serialGetPort_wrapper();
     std::string serialGetCurrentDevice_wrapper();
     std::vector <std::string> serialGetAvailableDevices_wrapper();
     void serialSetLatency_wrapper(int latency);
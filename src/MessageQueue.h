@@ -0,0 +1,158 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file MessageQueue.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef MESSAGE_QUEUE_H
+#define MESSAGE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+/*!
+ * \brief The MessageQueue class, a bounded lock-free multiple producers / single consumer queue.
+ * \param T: Message type, copied in and out of the queue.
+ * \param N: Capacity of the queue. Must be a power of two.
+ *
+ * Each cell carries a sequence number telling if it is free for the producer
+ * holding a given position, or ready for the consumer. Producers reserve a
+ * position with a compare-and-swap, so they never wait on each other nor on
+ * the consumer: push() fails immediately if the queue is full.
+ *
+ * pop() must only be called by one thread at a time (the controller's thread).
+ */
+template <typename T, size_t N>
+class MessageQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MessageQueue capacity must be a power of two");
+
+    struct Cell
+    {
+        std::atomic <size_t> sequence;
+        T data;
+    };
+
+    Cell cells[N];
+
+    // Keep producers and consumer positions on separate cache lines
+    // (padding rather than alignas: controllers are allocated with a plain 'new')
+    char pad0[64];
+    std::atomic <size_t> enqueuePos;    //!< Next position to be reserved by a producer.
+    char pad1[64 - sizeof(std::atomic <size_t>)];
+    std::atomic <size_t> dequeuePos;    //!< Next position to be read by the consumer.
+
+public:
+    MessageQueue()
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+
+    /*!
+     * \brief Push a message into the back of the queue. Can be called from any thread.
+     * \param data: The message to copy.
+     * \return false if the queue is full.
+     */
+    bool push(const T &data)
+    {
+        Cell *cell;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            cell = &cells[pos & (N - 1)];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            ptrdiff_t diff = static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos);
+
+            if (diff == 0)
+            {
+                // The cell is free, try to reserve it
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                // The cell still holds a message from the previous lap: the queue is full
+                return false;
+            }
+            else
+            {
+                // Another producer reserved this position first
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = data;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    /*!
+     * \brief Pop a message from the front of the queue. Only one consumer thread allowed.
+     * \param[out] data: The message.
+     * \return false if the queue is empty.
+     */
+    bool pop(T &data)
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell = &cells[pos & (N - 1)];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+
+        if (static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1) < 0)
+        {
+            // Empty, or the producer holding this position has not finished its copy yet
+            return false;
+        }
+
+        data = cell->data;
+        cell->sequence.store(pos + N, std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+
+        return true;
+    }
+
+    /*!
+     * \brief Check if there is a message to pop. Only called by the consumer thread.
+     * \return true if the queue is empty, or if the oldest message is still being pushed.
+     */
+    bool empty() const
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        size_t seq = cells[pos & (N - 1)].sequence.load(std::memory_order_acquire);
+
+        return (static_cast<ptrdiff_t>(seq) - static_cast<ptrdiff_t>(pos + 1) < 0);
+    }
+};
+
+/** @}*/
+
+#endif // MESSAGE_QUEUE_H
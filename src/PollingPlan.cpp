@@ -0,0 +1,329 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file PollingPlan.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#include "PollingPlan.h"
+#include "Servo.h"
+#include "ControlTables.h"
+#include "Utils.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+/* ************************************************************************** */
+
+void PollingPlan::setCycles(const int reg_name, const int cycles, const int priority)
+{
+    remove(reg_name);
+    entries.push_back(PollingEntry{reg_name, (cycles > 1) ? cycles : 1, 0.0, priority});
+}
+
+void PollingPlan::setRate(const int reg_name, const double rate, const int priority)
+{
+    if (rate <= 0.0)
+    {
+        TRACE_ERROR(CAPI, "Invalid polling rate (%f Hz) for register '%s'", rate, getRegisterNameTxt(reg_name).c_str());
+        return;
+    }
+
+    remove(reg_name);
+    entries.push_back(PollingEntry{reg_name, 1, rate, priority});
+}
+
+void PollingPlan::remove(const int reg_name)
+{
+    entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                 [reg_name](const PollingEntry &e) { return e.reg_name == reg_name; }),
+                  entries.end());
+}
+
+void PollingPlan::clear()
+{
+    entries.clear();
+}
+
+bool PollingPlan::empty() const
+{
+    return entries.empty();
+}
+
+const std::vector <PollingEntry> &PollingPlan::getEntries() const
+{
+    return entries;
+}
+
+int PollingPlan::getDivider(const PollingEntry &entry, const int frequency)
+{
+    double divider = entry.cycles;
+
+    if (entry.rate > 0.0)
+    {
+        divider = std::round(static_cast<double>(frequency) / entry.rate);
+    }
+
+    if (divider < 1.0)
+    {
+        return 1;
+    }
+    if (divider > POLLING_DIVIDER_MAX)
+    {
+        return POLLING_DIVIDER_MAX;
+    }
+
+    return static_cast<int>(divider);
+}
+
+/* ************************************************************************** */
+
+void PollingSchedule::clear()
+{
+    for (int i = 0; i < SERVO_REGISTRY_SLOTS; i++)
+    {
+        slots[i].clear();
+    }
+}
+
+void PollingSchedule::add(Servo *servo, const PollingPlan &plan, const int frequency)
+{
+    if (servo == nullptr)
+    {
+        return;
+    }
+
+    int id = servo->getId();
+
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS)
+    {
+        return;
+    }
+
+    slots[id].clear();
+
+    for (const auto &e: plan.getEntries())
+    {
+        int reg_size = getRegisterSize(servo->getControlTable(), e.reg_name);
+
+        if (reg_size > 0)
+        {
+            slots[id].push_back(PollingSlot{e.reg_name, reg_size, PollingPlan::getDivider(e, frequency), 0, e.priority});
+        }
+    }
+
+    std::stable_sort(slots[id].begin(), slots[id].end(),
+                     [](const PollingSlot &a, const PollingSlot &b) { return a.priority > b.priority; });
+}
+
+void PollingSchedule::balance()
+{
+    // Registers of a device sharing a rate and a priority are placed together
+    struct Group
+    {
+        int id;
+        int divider;
+        int priority;
+        int bytes;
+        std::vector <size_t> indexes;
+    };
+
+    std::vector <Group> groups;
+    int window = 1;
+
+    for (int id = 0; id < SERVO_REGISTRY_SLOTS; id++)
+    {
+        size_t first = groups.size();
+
+        for (size_t i = 0; i < slots[id].size(); i++)
+        {
+            const PollingSlot &slot = slots[id][i];
+            auto g = std::find_if(groups.begin() + first, groups.end(), [&](const Group &g) {
+                return g.id == id && g.divider == slot.divider && g.priority == slot.priority;
+            });
+
+            if (g == groups.end())
+            {
+                groups.push_back(Group{id, slot.divider, slot.priority, 0, {}});
+                g = groups.end() - 1;
+            }
+
+            g->bytes += slot.reg_size;
+            g->indexes.push_back(i);
+        }
+    }
+
+    // Higher priorities first, then the least flexible groups, then the largest ones
+    std::stable_sort(groups.begin(), groups.end(), [](const Group &a, const Group &b) {
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+        if (a.divider != b.divider)
+            return a.divider < b.divider;
+        return a.bytes > b.bytes;
+    });
+
+    for (const auto &g: groups)
+    {
+        window = std::max(window, g.divider);
+    }
+
+    // Bytes read during each cycle of the window
+    std::vector <double> load(window, 0.0);
+
+    for (const auto &g: groups)
+    {
+        int best = 0;
+        double bestCost = -1.0;
+
+        for (int offset = 0; offset < g.divider; offset++)
+        {
+            double cost = 0.0;
+            int count = 0;
+
+            for (int c = offset; c < window; c += g.divider)
+            {
+                cost += load[c];
+                count++;
+            }
+
+            cost /= count;
+
+            if (bestCost < 0.0 || cost < bestCost)
+            {
+                best = offset;
+                bestCost = cost;
+            }
+        }
+
+        for (int c = best; c < window; c += g.divider)
+        {
+            load[c] += g.bytes;
+        }
+
+        for (auto i: g.indexes)
+        {
+            slots[g.id][i].offset = best;
+        }
+    }
+}
+
+/* ************************************************************************** */
+
+void PollingSchedule::getDueRegisters(const int id, const uint64_t cycle, std::vector <int> &reg_names) const
+{
+    reg_names.clear();
+
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS)
+    {
+        return;
+    }
+
+    for (const auto &slot: slots[id])
+    {
+        if (cycle % static_cast<uint64_t>(slot.divider) == static_cast<uint64_t>(slot.offset))
+        {
+            reg_names.push_back(slot.reg_name);
+        }
+    }
+}
+
+void PollingSchedule::getReadLists(const int id, std::vector < std::vector <int> > &reg_lists, std::vector <double> &shares) const
+{
+    reg_lists.clear();
+    shares.clear();
+
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS || slots[id].empty())
+    {
+        return;
+    }
+
+    const std::vector <PollingSlot> &s = slots[id];
+
+    // The schedule of a device repeats itself every 'lcm(dividers)' cycles
+    uint64_t period = 1;
+    for (const auto &slot: s)
+    {
+        uint64_t a = period, b = static_cast<uint64_t>(slot.divider);
+        while (b != 0)
+        {
+            uint64_t t = a % b;
+            a = b;
+            b = t;
+        }
+
+        period = (period / a) * static_cast<uint64_t>(slot.divider);
+        if (period > POLLING_DIVIDER_MAX)
+        {
+            period = POLLING_DIVIDER_MAX;
+            break;
+        }
+    }
+
+    // Count the cycles reading each combination of registers
+    // (control tables have less than 64 registers)
+    std::map <uint64_t, uint64_t> combinations;
+
+    for (uint64_t cycle = 0; cycle < period; cycle++)
+    {
+        uint64_t mask = 0;
+
+        for (size_t i = 0; i < s.size() && i < 64; i++)
+        {
+            if (cycle % static_cast<uint64_t>(s[i].divider) == static_cast<uint64_t>(s[i].offset))
+            {
+                mask |= (1ULL << i);
+            }
+        }
+
+        if (mask != 0)
+        {
+            combinations[mask]++;
+        }
+    }
+
+    for (const auto &c: combinations)
+    {
+        std::vector <int> regs;
+
+        for (size_t i = 0; i < s.size() && i < 64; i++)
+        {
+            if (c.first & (1ULL << i))
+            {
+                regs.push_back(s[i].reg_name);
+            }
+        }
+
+        reg_lists.push_back(regs);
+        shares.push_back(static_cast<double>(c.second) / static_cast<double>(period));
+    }
+}
+
+const std::vector <PollingSlot> &PollingSchedule::getSlots(const int id) const
+{
+    static const std::vector <PollingSlot> none;
+
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS)
+    {
+        return none;
+    }
+
+    return slots[id];
+}
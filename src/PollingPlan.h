@@ -0,0 +1,178 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file PollingPlan.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef POLLING_PLAN_H
+#define POLLING_PLAN_H
+
+#include "ServoRegistry.h"
+
+#include <vector>
+#include <cstdint>
+
+class Servo;
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+//! Maximum number of cycles between two reads of the same register.
+#define POLLING_DIVIDER_MAX     65536
+
+/*!
+ * \brief A register to read periodically, see PollingPlan.
+ */
+struct PollingEntry
+{
+    int reg_name;       //!< The register to read.
+    int cycles;         //!< Read the register once every 'cycles' synchronization loop cycles. Only used if 'rate' is 0.
+    double rate;        //!< Read rate in Hz, converted into a number of cycles depending on the synchronization loop frequency.
+    int priority;       //!< Registers with a higher priority are the first to pick their cycles, and get the most even spread.
+};
+
+/*!
+ * \brief The PollingPlan class.
+ *
+ * Lists the registers a controller reads from its devices during the
+ * synchronization loop, and how often. A rate can be given in Hz (ex: the
+ * voltage once per second, whatever the loop frequency) or in number of cycles
+ * (ex: the position on every cycle).
+ *
+ * A plan can be set for every device of a controller, or for one device only.
+ * See ControllerAPI::setPollingPlan().
+ */
+class PollingPlan
+{
+    std::vector <PollingEntry> entries;
+
+public:
+    /*!
+     * \brief Read a register once every 'cycles' synchronization loop cycles.
+     * \param reg_name: The register to read. Replace the previous entry for this register, if any.
+     * \param cycles: Number of cycles between two reads, 1 to read the register on every cycle.
+     * \param priority: Registers with a higher priority get the most evenly spread cycles.
+     */
+    void setCycles(const int reg_name, const int cycles, const int priority = 0);
+
+    /*!
+     * \brief Read a register at a given rate.
+     * \param reg_name: The register to read. Replace the previous entry for this register, if any.
+     * \param rate: Read rate in Hz. Capped by the synchronization loop frequency.
+     * \param priority: Registers with a higher priority get the most evenly spread cycles.
+     */
+    void setRate(const int reg_name, const double rate, const int priority = 0);
+
+    /*!
+     * \brief Stop reading a register.
+     */
+    void remove(const int reg_name);
+
+    void clear();
+    bool empty() const;
+
+    const std::vector <PollingEntry> &getEntries() const;
+
+    /*!
+     * \brief Get the number of cycles between two reads of a register.
+     * \param entry: A register of a plan.
+     * \param frequency: The synchronization loop frequency, in Hz.
+     * \return A number of cycles, in range [1;POLLING_DIVIDER_MAX].
+     */
+    static int getDivider(const PollingEntry &entry, const int frequency);
+};
+
+/*!
+ * \brief A register of a device, scheduled by a PollingSchedule.
+ */
+struct PollingSlot
+{
+    int reg_name;       //!< The register to read.
+    int reg_size;       //!< Size of the register, in byte.
+    int divider;        //!< Read once every 'divider' cycles...
+    int offset;         //!< ...during the cycles where 'cycle % divider == offset'.
+    int priority;       //!< Priority of the register, from its PollingPlan.
+};
+
+/*!
+ * \brief The PollingSchedule class.
+ *
+ * The polling plans of the devices of a controller, turned into the list of
+ * registers to read during each synchronization loop cycle.
+ *
+ * Registers of a device sharing the same rate are scheduled together, so they
+ * can be read with as few transactions as possible. Registers not read on every
+ * cycle are spread across cycles so that each cycle reads about the same amount
+ * of data: the 1 Hz reads of a dozen devices don't all land on the same cycle.
+ *
+ * The schedule is not thread safe: it is built and used by the controller's thread.
+ */
+class PollingSchedule
+{
+    std::vector <PollingSlot> slots[SERVO_REGISTRY_SLOTS]; //!< Scheduled registers, indexed by device ID, sorted by priority.
+
+public:
+    /*!
+     * \brief Remove every device from the schedule.
+     */
+    void clear();
+
+    /*!
+     * \brief Add a device to the schedule.
+     * \param servo: The device. Registers of the plan missing from its control table are ignored.
+     * \param plan: The registers to read from this device.
+     * \param frequency: The synchronization loop frequency, in Hz.
+     *
+     * Call balance() once every device has been added.
+     */
+    void add(Servo *servo, const PollingPlan &plan, const int frequency);
+
+    /*!
+     * \brief Spread the registers not read on every cycle evenly across cycles.
+     *
+     * Groups of registers are placed by decreasing priority, each on the cycles
+     * carrying the smallest number of bytes so far.
+     */
+    void balance();
+
+    /*!
+     * \brief Get the registers of a device to read during a given cycle.
+     * \param id: The device ID.
+     * \param cycle: The synchronization loop cycle counter.
+     * \param[out] reg_names: The registers to read, by decreasing priority.
+     */
+    void getDueRegisters(const int id, const uint64_t cycle, std::vector <int> &reg_names) const;
+
+    /*!
+     * \brief Get the distinct lists of registers read from a device, and how often each one is read.
+     * \param id: The device ID.
+     * \param[out] reg_lists: The lists of registers. A cycle reading nothing from this device has no list.
+     * \param[out] shares: The share of cycles reading each list, in range ]0;1].
+     *
+     * Used to estimate the bus time of an average cycle.
+     */
+    void getReadLists(const int id, std::vector < std::vector <int> > &reg_lists, std::vector <double> &shares) const;
+
+    const std::vector <PollingSlot> &getSlots(const int id) const;
+};
+
+/** @}*/
+
+#endif // POLLING_PLAN_H
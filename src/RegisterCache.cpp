@@ -0,0 +1,218 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file RegisterCache.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#include "RegisterCache.h"
+#include "ControlTables.h"
+#include "Utils.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+/* ************************************************************************** */
+
+RegisterCache::RegisterCache()
+{
+    //
+}
+
+RegisterCache::~RegisterCache()
+{
+    //
+}
+
+void RegisterCache::setCacheFile(const std::string &path)
+{
+    std::lock_guard <std::mutex> lock(cacheLock);
+
+    cacheFilePath = path;
+    cacheEntries.clear();
+
+    if (cacheFilePath.empty() == false)
+    {
+        loadFile();
+    }
+}
+
+bool RegisterCache::isEnabled()
+{
+    std::lock_guard <std::mutex> lock(cacheLock);
+    return (cacheFilePath.empty() == false);
+}
+
+bool RegisterCache::getImage(const std::string &port, const int id, const int model, const int firmware, std::vector <unsigned char> &image)
+{
+    std::lock_guard <std::mutex> lock(cacheLock);
+
+    auto it = cacheEntries.find(port + ":" + std::to_string(id));
+    if (it != cacheEntries.end() &&
+        it->second.model == model &&
+        it->second.firmware == firmware)
+    {
+        image = it->second.image;
+        return true;
+    }
+
+    return false;
+}
+
+void RegisterCache::setImage(const std::string &port, const int id, const int model, const int firmware, const std::vector <unsigned char> &image)
+{
+    std::lock_guard <std::mutex> lock(cacheLock);
+
+    if (cacheFilePath.empty() == false)
+    {
+        CacheEntry &e = cacheEntries[port + ":" + std::to_string(id)];
+        e.model = model;
+        e.firmware = firmware;
+        e.image = image;
+
+        saveFile();
+    }
+}
+
+void RegisterCache::invalidate(const std::string &port, const int id)
+{
+    std::lock_guard <std::mutex> lock(cacheLock);
+
+    if (cacheEntries.erase(port + ":" + std::to_string(id)) > 0)
+    {
+        saveFile();
+    }
+}
+
+void RegisterCache::loadFile()
+{
+    std::ifstream cacheFile(cacheFilePath);
+
+    if (cacheFile.is_open() == false)
+    {
+        TRACE_INFO(CAPI, "No register cache found at '%s'", cacheFilePath.c_str());
+        return;
+    }
+
+    std::string line;
+    while (std::getline(cacheFile, line))
+    {
+        if (line.empty() || line[0] == '#')
+        {
+            continue;
+        }
+
+        std::istringstream fields(line);
+        std::string port, hex;
+        int id = -1, size = 0;
+        CacheEntry e;
+
+        fields >> port >> id >> e.model >> e.firmware >> size >> hex;
+
+        bool valid = (fields.fail() == false && id >= 0 && size > 0 && static_cast<int>(hex.size()) == size*2);
+
+        if (valid)
+        {
+            e.image.resize(size);
+            for (int i = 0; i < size && valid; i++)
+            {
+                if (isxdigit(static_cast<unsigned char>(hex[i*2])) && isxdigit(static_cast<unsigned char>(hex[i*2 + 1])))
+                {
+                    e.image[i] = static_cast<unsigned char>(strtol(hex.substr(i*2, 2).c_str(), nullptr, 16));
+                }
+                else
+                {
+                    valid = false;
+                }
+            }
+        }
+
+        if (valid == false)
+        {
+            TRACE_WARNING(CAPI, "Invalid line in register cache '%s', ignored", cacheFilePath.c_str());
+            continue;
+        }
+
+        cacheEntries[port + ":" + std::to_string(id)] = e;
+    }
+
+    TRACE_INFO(CAPI, "Register cache '%s' loaded (%i devices)", cacheFilePath.c_str(), static_cast<int>(cacheEntries.size()));
+}
+
+void RegisterCache::saveFile()
+{
+    std::ofstream cacheFile(cacheFilePath, std::ios::trunc);
+
+    if (cacheFile.is_open() == false)
+    {
+        TRACE_ERROR(CAPI, "Unable to write register cache to '%s'", cacheFilePath.c_str());
+        return;
+    }
+
+    cacheFile << "# SmartServoFramework register cache\n";
+
+    for (const auto &entry: cacheEntries)
+    {
+        const CacheEntry &e = entry.second;
+        std::string::size_type sep = entry.first.rfind(':');
+
+        cacheFile << entry.first.substr(0, sep) << " " << entry.first.substr(sep + 1) << " "
+                  << e.model << " " << e.firmware << " " << e.image.size() << " ";
+
+        char hex[3];
+        for (auto byte: e.image)
+        {
+            snprintf(hex, sizeof(hex), "%02X", byte);
+            cacheFile << hex;
+        }
+        cacheFile << "\n";
+    }
+}
+
+int RegisterCache::getVerificationSize(const int ct[][8])
+{
+    const int keyRegisters[5] = {REG_MODEL_NUMBER, REG_FIRMWARE_VERSION, REG_ID, REG_BAUD_RATE, REG_RETURN_DELAY_TIME};
+    int size = 0;
+
+    for (auto reg_name: keyRegisters)
+    {
+        int reg_addr = getRegisterAddr(ct, reg_name, REGISTER_ROM);
+        int reg_size = getRegisterSize(ct, reg_name);
+
+        if (reg_addr >= 0 && reg_size > 0 && (reg_addr + reg_size) > size)
+        {
+            size = reg_addr + reg_size;
+        }
+    }
+
+    return size;
+}
+
+void RegisterCache::getModelAndFirmware(const int ct[][8], const unsigned char *image, int &model, int &firmware)
+{
+    int addr = getRegisterAddr(ct, REG_MODEL_NUMBER, REGISTER_ROM);
+    model = (addr >= 0) ? make_value(&image[addr], getRegisterSize(ct, REG_MODEL_NUMBER)) : -1;
+
+    addr = getRegisterAddr(ct, REG_FIRMWARE_VERSION, REGISTER_ROM);
+    firmware = (addr >= 0) ? make_value(&image[addr], getRegisterSize(ct, REG_FIRMWARE_VERSION)) : -1;
+}
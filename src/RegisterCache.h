@@ -0,0 +1,121 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file RegisterCache.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef REGISTER_CACHE_H
+#define REGISTER_CACHE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+/*!
+ * \brief The RegisterCache class.
+ *
+ * Keep the last EEPROM image of every servo seen by a controller into a cache
+ * file, so the static EEPROM registers don't need to be read again on the next
+ * connection. Images are keyed by serial port, servo ID, model number and
+ * firmware version.
+ *
+ * The cache is only a hint: controllers must verify a cached image against a
+ * small read of the actual device (see getVerificationSize()) before using it.
+ *
+ * Cache file format is one line per servo:
+ * "<serial port> <id> <model number> <firmware version> <image size> <hex image>"
+ */
+class RegisterCache
+{
+    struct CacheEntry
+    {
+        int model = -1;
+        int firmware = -1;
+        std::vector <unsigned char> image;
+    };
+
+    std::string cacheFilePath;          //!< Path to the cache file. Empty if the cache is disabled.
+    std::map <std::string, CacheEntry> cacheEntries; //!< Cached images, keyed by "<serial port>:<id>".
+    std::mutex cacheLock;               //!< Lock for the cache entries.
+
+    void loadFile();
+    void saveFile();
+
+public:
+    RegisterCache();
+    ~RegisterCache();
+
+    /*!
+     * \brief Enable the cache and load existing images from a cache file.
+     * \param path: Path to the cache file. Use an empty path to disable the cache.
+     */
+    void setCacheFile(const std::string &path);
+
+    /*!
+     * \brief Check if the cache is in use.
+     * \return true if a cache file has been set.
+     */
+    bool isEnabled();
+
+    /*!
+     * \brief Get a cached EEPROM image.
+     * \param port: The serial port the servo is connected to.
+     * \param id: The servo ID.
+     * \param model: The servo model number.
+     * \param firmware: The servo firmware version.
+     * \param image: The cached EEPROM image, indexed by register address.
+     * \return true if an image matching the port, ID, model and firmware exists.
+     */
+    bool getImage(const std::string &port, const int id, const int model, const int firmware, std::vector <unsigned char> &image);
+
+    /*!
+     * \brief Store an EEPROM image into the cache (and write the cache file).
+     */
+    void setImage(const std::string &port, const int id, const int model, const int firmware, const std::vector <unsigned char> &image);
+
+    /*!
+     * \brief Remove a cached EEPROM image, for instance after an EEPROM register has been written.
+     */
+    void invalidate(const std::string &port, const int id);
+
+    /*!
+     * \brief Number of EEPROM bytes to read in order to verify a cached image.
+     * \param ct: The servo control table.
+     * \return The size of the EEPROM area covering model number, firmware version, ID, baud rate and return delay registers.
+     */
+    static int getVerificationSize(const int ct[][8]);
+
+    /*!
+     * \brief Decode model number and firmware version from the beginning of an EEPROM image.
+     * \param ct: The servo control table.
+     * \param image: An EEPROM image of at least getVerificationSize() bytes.
+     * \param model: The model number.
+     * \param firmware: The firmware version.
+     */
+    static void getModelAndFirmware(const int ct[][8], const unsigned char *image, int &model, int &firmware);
+};
+
+/** @}*/
+
+#endif // REGISTER_CACHE_H
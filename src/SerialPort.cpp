@@ -42,7 +42,8 @@ SerialPort::SerialPort(const int serialDevice, const int servoDevices):
     servoDevices(servoDevices),
     packetStartTime(0.0),
     packetWaitTime(0.0),
-    byteTransfertTime(0.0)
+    byteTransfertTime(0.0),
+    rxBlocking(true)
 {
     //
 }
@@ -151,32 +152,45 @@ int SerialPort::checkBaudRate(const int baud)
     }
 
     // Apply bandwith restriction depending on the adapter chip
-    if (serialDevice == SERIAL_USB2DYNAMIXEL || serialDevice == SERIAL_OTHER_FTDI)
+    int maxBaudRate = getMaxBaudRate();
+    if (maxBaudRate > 0 && baudRate > maxBaudRate)
     {
-        if (baudRate > 4500000)
-        {
-            baudRate = 4500000;
-            TRACE_ERROR(SERIAL, "Invalid baudrate ('%i' > 4500000): too high for SERIAL_USB2DYNAMIXEL or or FTDI based device, using default baudrate value of: '1000000'", baud);
-        }
+        TRACE_ERROR(SERIAL, "Invalid baudrate ('%i' > %i): too high for this serial adapter, using fallback baudrate value of: '%i'", baudRate, maxBaudRate, maxBaudRate);
+        baudRate = maxBaudRate;
+    }
+
+    return baudRate;
+}
+
+int SerialPort::getMaxBaudRate()
+{
+    int maxBaudRate = 0;
+
+    if (serialDevice == SERIAL_USB2DYNAMIXEL)
+    {
+        // FT232R
+        maxBaudRate = 3000000;
+    }
+    else if (serialDevice == SERIAL_OTHER_FTDI)
+    {
+        // FT232H (ex: U2D2), enough for the 4.5 Mbps of Dynamixel X devices
+        maxBaudRate = 4500000;
+    }
+    else if (serialDevice == SERIAL_OTHER_CP210x)
+    {
+        // CP2104 / CP2102N
+        maxBaudRate = 2000000;
     }
     else if (serialDevice == SERIAL_USB2AX)
     {
-        if (baudRate > 1000000)
-        {
-            baudRate = 1000000;
-            TRACE_ERROR(SERIAL, "Invalid baudrate ('%i' > 1000000): too high for USB2AX device, using default baudrate value of: '1000000'", baud);
-        }
+        maxBaudRate = 1000000;
     }
     else if (serialDevice == SERIAL_ZIG100)
     {
-        if (baudRate > 115200)
-        {
-            baudRate = 115200;
-            TRACE_ERROR(SERIAL, "Invalid baudrate ('%i' > 115200): too high for ZIG-100/110A device, using fallback baudrate value of: '115200'", baud);
-        }
+        maxBaudRate = 115200;
     }
 
-    return baudRate;
+    return maxBaudRate;
 }
 
 std::string SerialPort::autoselectSerialPort()
@@ -251,3 +265,30 @@ int SerialPort::getDeviceBaudRate()
 {
     return ttyDeviceBaudRate;
 }
+
+bool SerialPort::switchHighSpeed()
+{
+    TRACE_WARNING(SERIAL, "Low latency mode is not available with this serial port backend");
+    return false;
+}
+
+bool SerialPort::setRS485(const bool, const int, const int, const bool)
+{
+    TRACE_WARNING(SERIAL, "RS-485 mode is not available with this serial port backend");
+    return false;
+}
+
+void SerialPort::setBlockingRx(const bool blocking)
+{
+    rxBlocking = blocking;
+}
+
+int SerialPort::getLatency()
+{
+    return ttyDeviceLatencyTime;
+}
+
+double SerialPort::getByteTransfertTime()
+{
+    return byteTransfertTime;
+}
@@ -118,6 +118,7 @@ protected:
     double packetStartTime;        //!< Time (in millisecond) when the packet was sent.
     double packetWaitTime;         //!< Time (in millisecond) to wait for an answer.
     double byteTransfertTime;      //!< Estimation of the time (in millisecond) needed to read/write one byte on the serial link.
+    bool rxBlocking;               //!< If set, rx() sleeps until the requested data is available or the timeout is reached, instead of returning immediately.
 
     /*!
      * \brief Get the current time.
@@ -149,6 +150,14 @@ protected:
      */
     int checkBaudRate(const int baud);
 
+    /*!
+     * \brief Get the maximum baudrate supported by the serial adapter in use.
+     * \return The maximum baudrate in baud, or 0 if unknown.
+     *
+     * The value depends on the chip used by the 'serialDevice' adapter.
+     */
+    int getMaxBaudRate();
+
     /*!
      * \brief Check if the serial device has been locked by another instance or program.
      * \return True if a lock has been found for this serial device, false otherwise.
@@ -228,6 +237,10 @@ public:
      * \param[out] packet: Data packet received.
      * \param packetLength: Size in byte(s) of data packet received.
      * \return Size in byte(s) received from the serial link.
+     *
+     * In blocking mode (see setBlockingRx()), this function waits until 'packetLength'
+     * bytes have been received, or until the timeout set by setTimeOut() is reached.
+     * Otherwise it only returns what is already available.
      */
     virtual int rx(unsigned char *packet, int packetLength) = 0;
 
@@ -242,6 +255,35 @@ public:
      */
     virtual void setLatency(int latency);
 
+    /*!
+     * \brief Switch the serial port into low latency mode, if the OS and serial adapter allow it.
+     * \return True if every low latency setting has been applied.
+     *
+     * \note This functionnality is only implemented on the Linux backend.
+     */
+    virtual bool switchHighSpeed();
+
+    /*!
+     * \brief Configure RS-485 direction control, for UARTs wired to an RS-485 transceiver.
+     * \param enable: Enable or disable RS-485 mode.
+     * \param delayBeforeSend: Delay (in millisecond) between driver enable and the first transmitted bit.
+     * \param delayAfterSend: Delay (in millisecond) between the last transmitted bit and driver disable.
+     * \param rtsOnSend: RTS polarity. True if RTS (driver enable) is high while sending, false if it is low.
+     * \return True if the configuration has been applied.
+     *
+     * \note This functionnality is only implemented on the Linux backend.
+     */
+    virtual bool setRS485(const bool enable, const int delayBeforeSend = 0, const int delayAfterSend = 0, const bool rtsOnSend = true);
+
+    /*!
+     * \brief Enable or disable blocking receive mode.
+     * \param blocking: If true, rx() sleeps until data is available or the timeout is reached.
+     *
+     * Blocking mode avoids spinning on the CPU while waiting for a status packet.
+     * It is enabled by default, but only implemented by the Linux and macOS backends.
+     */
+    void setBlockingRx(const bool blocking);
+
     /*!
      * \brief Set the maximum duration to wait for an answer, computed from packetLength and latencyTime.
      * \param packetLength: Number of byte to received, will be used to compute the duration of the timeout.
@@ -277,6 +319,18 @@ public:
      * \return An integer containing the device baudrate.
      */
     int getDeviceBaudRate();
+
+    /*!
+     * \brief Get serial device latency time currently in use.
+     * \return The latency time in millisecond.
+     */
+    int getLatency();
+
+    /*!
+     * \brief Get the estimated time needed to transfer one byte on the serial link.
+     * \return The byte transfert time in millisecond.
+     */
+    double getByteTransfertTime();
 };
 
 #endif // SERIALPORT_H
@@ -27,11 +27,32 @@
 
 // Linux specifics
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <linux/serial.h>
 #include <sys/ioctl.h>
 #include <sys/time.h>
 
+// termios2 structure (from <asm-generic/termbits.h>), which cannot be included
+// alongside <termios.h>. Only available on architectures using the generic layout.
+#if defined(TCGETS2) && !defined(__powerpc__) && !defined(__mips__) && !defined(__alpha__) && !defined(__sparc__)
+#define SERIAL_TERMIOS2
+struct termios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#endif // TCGETS2
+
 // Device lock support
 //#define LOCK_FLOCK
 //#define LOCK_LOCKFILE
@@ -114,7 +135,11 @@ SerialPortLinux::SerialPortLinux(std::string &devicePath, const int baud, const
     ttyDeviceFileDescriptor(-1),
     ttyDeviceBaudRateFlag(B1000000),
     ttyCustomSpeed(false),
-    ttyLowLatency(false)
+    ttyLowLatency(false),
+    ttyRS485(false),
+    ttyRS485DelayBeforeSend(0),
+    ttyRS485DelayAfterSend(0),
+    ttyRS485RtsOnSend(true)
 {
     if (devicePath.empty() == 1 || devicePath == "auto")
     {
@@ -163,7 +188,8 @@ void SerialPortLinux::setBaudRate(const int baud)
     // Get valid baud rate
     ttyDeviceBaudRate = checkBaudRate(baud);
 
-    // Get <termios.h> baudrate flag
+    // Get <termios.h> baudrate flag (may set 'ttyCustomSpeed')
+    ttyCustomSpeed = false;
     ttyDeviceBaudRateFlag = convertBaudRateFlag(ttyDeviceBaudRate);
 
     // Compute the time needed to transfert one byte through the serial interface
@@ -223,7 +249,7 @@ int SerialPortLinux::convertBaudRateFlag(int baudrate)
             {
                 ttyCustomSpeed = true;
                 baudRateFlag = B38400;
-                TRACE_WARNING(SERIAL, "convertBaudRateFlag(%i) has been set to B38400 (custom speed will be used)", baudrate);
+                TRACE_WARNING(SERIAL, "convertBaudRateFlag(%i) has been set to B38400 (custom speed will be set with termios2 or a custom divisor)", baudrate);
             }
         }
     }
@@ -438,6 +464,7 @@ int SerialPortLinux::openLink()
 {
     struct termios tty;
     memset(&tty, 0, sizeof(tty));
+    bool customDivisor = false;
 
     // Make sure no tty connection is already running (in that case, openLink() will do a reconnection)
     closeLink();
@@ -487,8 +514,20 @@ int SerialPortLinux::openLink()
         goto OPEN_LINK_ERROR;
     }
 
+    // Set RS-485 direction control
+    if (ttyRS485 == true && applyRS485() == false)
+    {
+        goto OPEN_LINK_ERROR;
+    }
+
+    // Set custom speed with termios2 if possible, or with the (deprecated) custom divisor
+    if (ttyCustomSpeed == true)
+    {
+        customDivisor = (setCustomBaudRate() == false);
+    }
+
     // Set custom serial infos?
-    if (ttyCustomSpeed == true || ttyLowLatency == true)
+    if (customDivisor == true || ttyLowLatency == true)
     {
         struct serial_struct serinfo;
         memset(&serinfo, 0, sizeof(serinfo));
@@ -496,11 +535,18 @@ int SerialPortLinux::openLink()
         // Get current serial_struct values
         if (ioctl(ttyDeviceFileDescriptor, TIOCGSERIAL, &serinfo) < 0)
         {
+            // Low latency is only a hint, custom speed is mandatory
+            if (customDivisor == false)
+            {
+                TRACE_WARNING(SERIAL, "Cannot set low latency flag on serial port: '%s'", ttyDevicePath.c_str());
+                return 1;
+            }
+
             TRACE_ERROR(SERIAL, "Cannot get serial infos structure from serial port: '%s'", ttyDevicePath.c_str());
             goto OPEN_LINK_ERROR;
         }
 
-        if (ttyCustomSpeed == true)
+        if (customDivisor == true)
         {
             serinfo.flags &= ~ASYNC_SPD_MASK;
             serinfo.flags |= ASYNC_SPD_CUST;
@@ -519,7 +565,14 @@ int SerialPortLinux::openLink()
         // Set serial_struct
         if (ioctl(ttyDeviceFileDescriptor, TIOCSSERIAL, &serinfo) < 0)
         {
-            TRACE_ERROR(SERIAL, "Cannot set serial infos structure with custom baud divisor (%s) to serial port: '%s'", ttyDeviceBaudRate, ttyDevicePath.c_str());
+            // Low latency is only a hint, custom speed is mandatory
+            if (customDivisor == false)
+            {
+                TRACE_WARNING(SERIAL, "Cannot set low latency flag on serial port: '%s'", ttyDevicePath.c_str());
+                return 1;
+            }
+
+            TRACE_ERROR(SERIAL, "Cannot set serial infos structure with custom baud divisor (%i) to serial port: '%s'", ttyDeviceBaudRate, ttyDevicePath.c_str());
             goto OPEN_LINK_ERROR;
         }
     }
@@ -535,6 +588,118 @@ OPEN_LINK_LOCKED:
     return -1;
 }
 
+bool SerialPortLinux::setCustomBaudRate()
+{
+    bool status = false;
+
+#if defined(SERIAL_TERMIOS2)
+    struct termios2 tio;
+
+    if (ioctl(ttyDeviceFileDescriptor, TCGETS2, &tio) < 0)
+    {
+        TRACE_WARNING(SERIAL, "Cannot get termios2 structure from serial port: '%s'", ttyDevicePath.c_str());
+        return status;
+    }
+
+    tio.c_cflag &= ~CBAUD;
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = ttyDeviceBaudRate;
+    tio.c_ospeed = ttyDeviceBaudRate;
+
+    if (ioctl(ttyDeviceFileDescriptor, TCSETS2, &tio) < 0 ||
+        ioctl(ttyDeviceFileDescriptor, TCGETS2, &tio) < 0)
+    {
+        TRACE_WARNING(SERIAL, "Cannot set custom baudrate '%i' with termios2 on serial port: '%s'", ttyDeviceBaudRate, ttyDevicePath.c_str());
+        return status;
+    }
+
+    // The driver may round the rate to the closest one it can generate
+    int actualBaudRate = static_cast<int>(tio.c_ospeed);
+    if ((actualBaudRate < (static_cast<double>(ttyDeviceBaudRate) * 98.5 / 100.0)) ||
+        (actualBaudRate > (static_cast<double>(ttyDeviceBaudRate) * 101.5 / 100.0)))
+    {
+        TRACE_WARNING(SERIAL, "Custom baudrate '%i' has been set to '%i' by the driver (more than ±1.5%% mismatch)", ttyDeviceBaudRate, actualBaudRate);
+    }
+    else
+    {
+        TRACE_INFO(SERIAL, "- Custom baudrate has been set to: '%i' (termios2)", actualBaudRate);
+    }
+
+    status = true;
+#endif // SERIAL_TERMIOS2
+
+    return status;
+}
+
+bool SerialPortLinux::applyRS485()
+{
+    struct serial_rs485 rs485;
+    memset(&rs485, 0, sizeof(rs485));
+
+    if (ttyRS485 == true)
+    {
+        rs485.flags |= SER_RS485_ENABLED;
+
+        if (ttyRS485RtsOnSend == true)
+        {
+            rs485.flags |= SER_RS485_RTS_ON_SEND;
+        }
+        else
+        {
+            rs485.flags |= SER_RS485_RTS_AFTER_SEND;
+        }
+
+        rs485.delay_rts_before_send = ttyRS485DelayBeforeSend;
+        rs485.delay_rts_after_send = ttyRS485DelayAfterSend;
+    }
+
+    if (ioctl(ttyDeviceFileDescriptor, TIOCSRS485, &rs485) < 0)
+    {
+        TRACE_ERROR(SERIAL, "Cannot set RS-485 mode on serial port: '%s': error code '%i'", ttyDevicePath.c_str(), errno);
+        return false;
+    }
+
+    // The driver may adjust (clamp) the delays
+    if (ioctl(ttyDeviceFileDescriptor, TIOCGRS485, &rs485) == 0 && ttyRS485 == true)
+    {
+        ttyRS485DelayBeforeSend = rs485.delay_rts_before_send;
+        ttyRS485DelayAfterSend = rs485.delay_rts_after_send;
+    }
+
+    TRACE_INFO(SERIAL, "- RS-485 mode has been %s (delays before/after send: %i/%i ms)",
+               ttyRS485 ? "enabled" : "disabled", ttyRS485DelayBeforeSend, ttyRS485DelayAfterSend);
+
+    return true;
+}
+
+bool SerialPortLinux::setRS485(const bool enable, const int delayBeforeSend, const int delayAfterSend, const bool rtsOnSend)
+{
+    bool status = true;
+
+    if (delayBeforeSend < 0 || delayAfterSend < 0)
+    {
+        TRACE_ERROR(SERIAL, "Invalid RS-485 delays: '%i' / '%i'", delayBeforeSend, delayAfterSend);
+        return false;
+    }
+
+    ttyRS485 = enable;
+    ttyRS485DelayBeforeSend = delayBeforeSend;
+    ttyRS485DelayAfterSend = delayAfterSend;
+    ttyRS485RtsOnSend = rtsOnSend;
+
+    if (isOpen() == true)
+    {
+        status = applyRS485();
+
+        if (status == false)
+        {
+            ttyRS485 = false;
+        }
+    }
+
+    return status;
+}
+
 bool SerialPortLinux::isOpen()
 {
     bool status = false;
@@ -599,12 +764,55 @@ int SerialPortLinux::rx(unsigned char *packet, int packetLength)
         if (packet != nullptr && packetLength > 0)
         {
             memset(packet, 0, packetLength);
-            readStatus = read(ttyDeviceFileDescriptor, packet, packetLength);
+            readStatus = 0;
 
-            if (readStatus < 0)
-            {
-                TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': read() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+            do {
+                if (rxBlocking == true)
+                {
+                    // Sleep until some data comes in, or until the timeout is reached
+                    double remaining = packetStartTime + packetWaitTime - getTime();
+
+                    if (remaining > 0.0)
+                    {
+                        struct pollfd pfd;
+                        pfd.fd = ttyDeviceFileDescriptor;
+                        pfd.events = POLLIN;
+                        pfd.revents = 0;
+
+                        struct timespec ts;
+                        ts.tv_sec = static_cast<time_t>(remaining / 1000.0);
+                        ts.tv_nsec = static_cast<long>((remaining - static_cast<double>(ts.tv_sec) * 1000.0) * 1000000.0);
+
+                        int pollStatus = ppoll(&pfd, 1, &ts, nullptr);
+
+                        if (pollStatus == 0)
+                        {
+                            break;
+                        }
+                        else if (pollStatus < 0 && errno != EINTR)
+                        {
+                            TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': poll() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+                            break;
+                        }
+                    }
+                }
+
+                int nRead = read(ttyDeviceFileDescriptor, packet + readStatus, packetLength - readStatus);
+
+                if (nRead < 0)
+                {
+                    TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': read() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+                    if (readStatus == 0)
+                    {
+                        readStatus = -1;
+                    }
+                    break;
+                }
+
+                readStatus += nRead;
             }
+            while (rxBlocking == true && readStatus < packetLength &&
+                   getTime() < packetStartTime + packetWaitTime);
         }
         else
         {
@@ -639,40 +847,125 @@ double SerialPortLinux::getTime()
     return (static_cast<double>(tv.tv_sec) * 1000.0 + static_cast<double>(tv.tv_usec) / 1000.0);
 }
 
-bool SerialPortLinux::switchHighSpeed()
+int SerialPortLinux::readLatencyTimer()
 {
-    bool status = false;
+    int latency = -1;
 
-    // TODO // enables "ASYNC_LOW_LATENCY" flag
-    // reduce the "/sys/bus/usb-serial/devices/ttyXXX/latency_timer" value
+    std::ifstream latency_file("/sys/bus/usb-serial/devices/" + ttyDeviceName + "/latency_timer");
+    if (latency_file.good())
+    {
+        latency_file >> latency;
 
-    return status;
+        if (latency_file.fail())
+        {
+            latency = -1;
+        }
+    }
+
+    return latency;
 }
 
-void SerialPortLinux::setLatency(int latency)
+bool SerialPortLinux::writeLatencyTimer(int latency)
 {
-    // "auto-detect" latency value if possible
-    // note: this doesn't really produce expected results yet..
-    if (latency == 0)
+    std::ofstream latency_file("/sys/bus/usb-serial/devices/" + ttyDeviceName + "/latency_timer");
+    if (latency_file.good())
     {
-        size_t lastbackslash = ttyDevicePath.find_last_of('/');
+        latency_file << latency;
+        latency_file.flush();
 
-        if (lastbackslash != std::string::npos)
+        return latency_file.good();
+    }
+
+    return false;
+}
+
+bool SerialPortLinux::switchHighSpeed()
+{
+    bool status = true;
+
+    if (isOpen() == false)
+    {
+        // The ASYNC_LOW_LATENCY flag will be set by the next openLink(), if supported
+        ttyLowLatency = true;
+    }
+    else
+    {
+        struct serial_struct serinfo;
+        memset(&serinfo, 0, sizeof(serinfo));
+
+        if (ioctl(ttyDeviceFileDescriptor, TIOCGSERIAL, &serinfo) < 0)
         {
-            std::string latency_path = "/sys/bus/usb-serial/devices/" + ttyDevicePath.substr(lastbackslash+1) + "/latency_timer";
-            std::ifstream latency_file(latency_path);
+            TRACE_WARNING(SERIAL, "- ASYNC_LOW_LATENCY flag is not supported by '%s'", ttyDevicePath.c_str());
+            status = false;
+        }
+        else if ((serinfo.flags & ASYNC_LOW_LATENCY) == 0)
+        {
+            serinfo.flags |= ASYNC_LOW_LATENCY;
 
-            if (latency_file.good())
+            if (ioctl(ttyDeviceFileDescriptor, TIOCSSERIAL, &serinfo) < 0)
+            {
+                TRACE_WARNING(SERIAL, "- Unable to set ASYNC_LOW_LATENCY flag on '%s': error code '%i'", ttyDevicePath.c_str(), errno);
+                status = false;
+            }
+            else
             {
-                char latency_value[8];
-                latency_file.getline(latency_value, 8);
-                latency = std::stoi(latency_value);
+                TRACE_INFO(SERIAL, "- ASYNC_LOW_LATENCY flag has been set on '%s'", ttyDevicePath.c_str());
+                ttyLowLatency = true;
             }
-            latency_file.close();
         }
         else
         {
-            TRACE_ERROR(SERIAL, "Unable to find latency info for the current device: '%s'", ttyDevicePath.substr(lastbackslash+1).c_str());
+            TRACE_INFO(SERIAL, "- ASYNC_LOW_LATENCY flag was already set on '%s'", ttyDevicePath.c_str());
+            ttyLowLatency = true;
+        }
+    }
+
+    // Reduce the latency timer of FTDI based adapters (need write access to sysfs)
+    int timer = readLatencyTimer();
+    if (timer < 0)
+    {
+        TRACE_INFO(SERIAL, "- No latency timer available for '%s' (not an FTDI adapter?)", ttyDevicePath.c_str());
+    }
+    else
+    {
+        if (timer > 1)
+        {
+            if (writeLatencyTimer(1) == true)
+            {
+                TRACE_INFO(SERIAL, "- Latency timer of '%s' has been changed from '%i' to '1' ms", ttyDevicePath.c_str(), timer);
+            }
+            else
+            {
+                TRACE_WARNING(SERIAL, "- Unable to change latency timer of '%s' from '%i' to '1' ms (permission denied?)", ttyDevicePath.c_str(), timer);
+                status = false;
+            }
+
+            // Measure what has really been applied
+            timer = readLatencyTimer();
+        }
+
+        // Recompute timeouts from the actual latency timer value
+        if (timer > 0)
+        {
+            setLatency(timer);
+        }
+    }
+
+    TRACE_INFO(SERIAL, "- Device latency time has been set to: '%i'", ttyDeviceLatencyTime);
+
+    return status;
+}
+
+void SerialPortLinux::setLatency(int latency)
+{
+    // "auto-detect" latency value if possible
+    if (latency == 0)
+    {
+        latency = readLatencyTimer();
+
+        if (latency < 0)
+        {
+            TRACE_ERROR(SERIAL, "Unable to find latency info for the current device: '%s'", ttyDeviceName.c_str());
         }
     }
 
@@ -690,12 +983,24 @@ void SerialPortLinux::setTimeOut(int packetLength)
 {
     packetStartTime = getTime();
     packetWaitTime  = (byteTransfertTime * static_cast<double>(packetLength) + 2.0 * static_cast<double>(ttyDeviceLatencyTime));
+    packetWaitTime += getRS485TurnaroundTime();
 }
 
 void SerialPortLinux::setTimeOut(double msec)
 {
     packetStartTime = getTime();
-    packetWaitTime  = msec;
+    packetWaitTime  = msec + getRS485TurnaroundTime();
+}
+
+double SerialPortLinux::getRS485TurnaroundTime() const
+{
+    // In RS-485 mode, the kernel holds the line for the turnaround delays before releasing it
+    if (ttyRS485 == true)
+    {
+        return static_cast<double>(ttyRS485DelayBeforeSend + ttyRS485DelayAfterSend);
+    }
+
+    return 0.0;
 }
 
 int SerialPortLinux::checkTimeOut()
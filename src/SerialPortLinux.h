@@ -45,10 +45,16 @@ int serialPortsScanner(std::vector <std::string> &availableSerialPorts);
  */
 class SerialPortLinux: public SerialPort
 {
+    friend class SerialPortReactor;
+
     int ttyDeviceFileDescriptor;   //!< The file descriptor that will be used to write to the serial device.
     int ttyDeviceBaudRateFlag;     //!< Speed of the serial device, from a <termios.h> enum.
     bool ttyCustomSpeed;           //!< Try to set custom speed on the serial port.
     bool ttyLowLatency;            //!< Try to set low latency flag on the serial port (works only on FTDI based adapters).
+    bool ttyRS485;                 //!< Use the kernel RS-485 mode (TIOCSRS485) to drive the transceiver direction.
+    int ttyRS485DelayBeforeSend;   //!< RS-485 delay (in millisecond) between driver enable and the first transmitted bit.
+    int ttyRS485DelayAfterSend;    //!< RS-485 delay (in millisecond) between the last transmitted bit and driver disable.
+    bool ttyRS485RtsOnSend;        //!< RS-485 RTS polarity: true if RTS is high while sending, false if it is low.
 
     /*!
      * \brief Get current time since the Epoch.
@@ -72,10 +78,32 @@ class SerialPortLinux: public SerialPort
      *
      * This function will try to match a baudrate with an existing baudrate flag,
      * or at least one +/- 1.5% close. When this is not possible, the 'ttyCustomSpeed'
-     * flag is set, and the openLink() function will try to set a custom speed.
+     * flag is set, and the openLink() function will set a custom speed using setCustomBaudRate().
      */
     int convertBaudRateFlag(int baudrate);
 
+    /*!
+     * \brief Set the exact 'ttyDeviceBaudRate' on the opened serial port, using termios2 and the BOTHER flag.
+     * \return True if the custom speed has been applied.
+     *
+     * This is used for baudrates without a matching <termios.h> flag (ex: 4.5 Mbps).
+     * If termios2 is not available, openLink() falls back to the deprecated
+     * ASYNC_SPD_CUST divisor, which most USB serial drivers ignore.
+     */
+    bool setCustomBaudRate();
+
+    /*!
+     * \brief Apply the current RS-485 settings to the opened serial port.
+     * \return True if the kernel accepted the RS-485 configuration.
+     */
+    bool applyRS485();
+
+    /*!
+     * \brief Get the time (in millisecond) the kernel holds the RS-485 line around each transmission.
+     * \return The turnaround delays if RS-485 mode is enabled, 0 otherwise.
+     */
+    double getRS485TurnaroundTime() const;
+
     /*!
      * \brief Check if the serial device has been locked by another instance or program.
      * \return True if a lock has been found for this serial device, false otherwise.
@@ -100,6 +128,19 @@ class SerialPortLinux: public SerialPort
      */
     bool removeLock();
 
+    /*!
+     * \brief Read the latency timer of the USB serial adapter from sysfs.
+     * \return The latency timer value in milliseconds, or -1 if not available (ex: not an FTDI adapter).
+     */
+    int readLatencyTimer();
+
+    /*!
+     * \brief Write the latency timer of the USB serial adapter into sysfs.
+     * \param latency: The latency timer value in milliseconds.
+     * \return True if the value has been written (need write access to sysfs, usually root credential).
+     */
+    bool writeLatencyTimer(int latency);
+
 public:
     /*!
      * \brief SerialPortLinux constructor will only init some variables to default values.
@@ -123,13 +164,24 @@ public:
     void flush();
 
     /*!
-     * \brief switchHighSpeed() should enable ASYNC_LOW_LATENCY flag and reduce latency_timer per tty device (need root credential)
-     * \return True in case of success.
-     * \todo This function is not implemented yet.
-     * \todo latency_timer value auto-detection doesn't produce intended result yet.
+     * \brief Enable the ASYNC_LOW_LATENCY flag and reduce the latency_timer of the USB adapter to 1 ms.
+     * \return True if every setting has been applied, false if some of them could not be changed.
+     *
+     * The latency time used to compute timeouts is then updated from the value
+     * actually read back from the adapter. Every change (or failure) is reported
+     * in the logs. Writing the latency_timer usually needs root credential.
      */
     bool switchHighSpeed();
 
+    /*!
+     * \brief Configure kernel RS-485 direction control (TIOCSRS485).
+     * \return True if the configuration has been applied (or will be applied by the next openLink()).
+     *
+     * The kernel then switches the transceiver direction itself, with precise
+     * delays, and the turnaround time is taken into account by the timeouts.
+     */
+    bool setRS485(const bool enable, const int delayBeforeSend = 0, const int delayAfterSend = 0, const bool rtsOnSend = true);
+
     void setLatency(int latency);
     void setTimeOut(int packetLength);
     void setTimeOut(double msec);
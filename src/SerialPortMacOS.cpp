@@ -28,6 +28,7 @@
 // Unix
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <sys/ioctl.h>
 #include <errno.h>
 #include <paths.h>
@@ -47,6 +48,7 @@
 
 // C++ standard libraries
 #include <fstream>
+#include <cmath>
 #include <cstdio>
 #include <cstring>
 #include <string>
@@ -659,12 +661,51 @@ int SerialPortMacOS::rx(unsigned char *packet, int packetLength)
         if (packet != nullptr && packetLength > 0)
         {
             memset(packet, 0, packetLength);
-            readStatus = read(ttyDeviceFileDescriptor, packet, packetLength);
+            readStatus = 0;
 
-            if (readStatus < 0)
-            {
-                TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': read() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+            do {
+                if (rxBlocking == true)
+                {
+                    // Sleep until some data comes in, or until the timeout is reached
+                    double remaining = packetStartTime + packetWaitTime - getTime();
+
+                    if (remaining > 0.0)
+                    {
+                        struct pollfd pfd;
+                        pfd.fd = ttyDeviceFileDescriptor;
+                        pfd.events = POLLIN;
+                        pfd.revents = 0;
+
+                        int pollStatus = poll(&pfd, 1, static_cast<int>(std::ceil(remaining)));
+
+                        if (pollStatus == 0)
+                        {
+                            break;
+                        }
+                        else if (pollStatus < 0 && errno != EINTR)
+                        {
+                            TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': poll() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+                            break;
+                        }
+                    }
+                }
+
+                int nRead = read(ttyDeviceFileDescriptor, packet + readStatus, packetLength - readStatus);
+
+                if (nRead < 0)
+                {
+                    TRACE_ERROR(SERIAL, "Cannot read from serial port '%s': read() failed with error code '%i'!", ttyDevicePath.c_str(), errno);
+                    if (readStatus == 0)
+                    {
+                        readStatus = -1;
+                    }
+                    break;
+                }
+
+                readStatus += nRead;
             }
+            while (rxBlocking == true && readStatus < packetLength &&
+                   getTime() < packetStartTime + packetWaitTime);
         }
         else
         {
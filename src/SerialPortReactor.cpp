@@ -0,0 +1,633 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortReactor.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#if defined(__linux__) || defined(__gnu_linux)
+
+#include "SerialPortReactor.h"
+#include "minitraces.h"
+
+// Linux specifics
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cerrno>
+
+/* ************************************************************************** */
+
+//! The reactor shared by the controllers running in reactor mode, alive while one of them uses it.
+static std::weak_ptr <SerialPortReactor> sharedReactor;
+static std::mutex sharedReactorLock;
+
+std::shared_ptr <SerialPortReactor> SerialPortReactor::getShared()
+{
+    std::lock_guard <std::mutex> lock(sharedReactorLock);
+
+    std::shared_ptr <SerialPortReactor> reactor = sharedReactor.lock();
+    if (reactor == nullptr)
+    {
+        reactor = std::make_shared <SerialPortReactor>();
+        if (reactor->start() == false)
+        {
+            return nullptr;
+        }
+
+        sharedReactor = reactor;
+    }
+
+    return reactor;
+}
+
+/* ************************************************************************** */
+
+SerialPortReactor::SerialPortReactor():
+    running(false)
+{
+    //
+}
+
+SerialPortReactor::~SerialPortReactor()
+{
+    stop();
+}
+
+bool SerialPortReactor::start()
+{
+    if (running == true)
+    {
+        return true;
+    }
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+
+    if (epollFd < 0 || wakeFd < 0 || timerFd < 0)
+    {
+        TRACE_ERROR(SERIAL, "Unable to create the serial reactor: error code '%i'", errno);
+        stop();
+        return false;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = wakeFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+    ev.events = EPOLLIN;
+    ev.data.fd = timerFd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &ev);
+
+    // Register the ports added before start()
+    portsLock.lock();
+    for (auto &p: ports)
+    {
+        ev.events = EPOLLIN;
+        ev.data.fd = p.first;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, p.first, &ev);
+    }
+    portsLock.unlock();
+
+    running = true;
+    reactorThread = std::thread(&SerialPortReactor::run, this);
+    workerThread = std::thread(&SerialPortReactor::worker, this);
+
+    return true;
+}
+
+void SerialPortReactor::stop()
+{
+    if (running == true)
+    {
+        running = false;
+        wake();
+
+        if (reactorThread.joinable())
+        {
+            reactorThread.join();
+        }
+
+        worksLock.lock();
+        worksCondition.notify_all();
+        worksLock.unlock();
+
+        if (workerThread.joinable())
+        {
+            workerThread.join();
+        }
+    }
+
+    works.clear();
+
+    portsLock.lock();
+    for (auto &p: ports)
+    {
+        p.second.queue.clear();
+        p.second.state = port_idle;
+    }
+    while (tasks.empty() == false)
+    {
+        tasks.pop();
+    }
+    portsLock.unlock();
+
+    if (epollFd >= 0)
+    {
+        close(epollFd);
+        epollFd = -1;
+    }
+    if (wakeFd >= 0)
+    {
+        close(wakeFd);
+        wakeFd = -1;
+    }
+    if (timerFd >= 0)
+    {
+        close(timerFd);
+        timerFd = -1;
+    }
+}
+
+void SerialPortReactor::wake()
+{
+    uint64_t one = 1;
+    if (wakeFd >= 0 && write(wakeFd, &one, sizeof(one)) < 0)
+    {
+        TRACE_WARNING(SERIAL, "Unable to wake the serial reactor thread");
+    }
+}
+
+bool SerialPortReactor::addPort(SerialPortLinux *port)
+{
+    if (port == nullptr || port->isOpen() == false)
+    {
+        TRACE_ERROR(SERIAL, "Cannot add a closed serial port to the reactor");
+        return false;
+    }
+
+    int fd = port->ttyDeviceFileDescriptor;
+
+    std::lock_guard <std::mutex> lock(portsLock);
+
+    if (ports.count(fd) > 0)
+    {
+        return true;
+    }
+
+    ports[fd].port = port;
+
+    if (epollFd >= 0)
+    {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            TRACE_ERROR(SERIAL, "Cannot add serial port '%s' to the reactor: error code '%i'", port->getDevicePath().c_str(), errno);
+            ports.erase(fd);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void SerialPortReactor::removePort(SerialPortLinux *port)
+{
+    if (port == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard <std::mutex> lock(portsLock);
+
+    for (auto it = ports.begin(); it != ports.end(); ++it)
+    {
+        if (it->second.port == port)
+        {
+            if (epollFd >= 0 && it->second.state != port_offloaded)
+            {
+                epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+            }
+
+            ports.erase(it);
+            break;
+        }
+    }
+}
+
+bool SerialPortReactor::submit(SerialPortLinux *port, const SerialTransaction &transaction)
+{
+    if (port == nullptr || transaction.request.empty())
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock(portsLock);
+
+        auto it = ports.find(port->ttyDeviceFileDescriptor);
+        if (it == ports.end() || it->second.port != port)
+        {
+            TRACE_ERROR(SERIAL, "Serial port '%s' is not registered to the reactor", port->getDevicePath().c_str());
+            return false;
+        }
+
+        if (it->second.hungUp == true)
+        {
+            TRACE_ERROR(SERIAL, "Serial port '%s' has been disconnected from the reactor", port->getDevicePath().c_str());
+            return false;
+        }
+
+        if (it->second.state == port_offloaded)
+        {
+            TRACE_ERROR(SERIAL, "Serial port '%s' is lent to some blocking work", port->getDevicePath().c_str());
+            return false;
+        }
+
+        it->second.queue.push_back(transaction);
+    }
+
+    // Wake the I/O thread, so it can start the transaction right away
+    wake();
+
+    return true;
+}
+
+void SerialPortReactor::schedule(const std::chrono::steady_clock::time_point &deadline, std::function <void ()> task)
+{
+    {
+        std::lock_guard <std::mutex> lock(portsLock);
+        tasks.push(ScheduledTask{deadline, task});
+    }
+
+    wake();
+}
+
+bool SerialPortReactor::offload(SerialPortLinux *port, std::function <void ()> work, std::function <void ()> done)
+{
+    if (port == nullptr || running == false)
+    {
+        return false;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock(portsLock);
+
+        auto it = ports.find(port->ttyDeviceFileDescriptor);
+        if (it == ports.end() || it->second.port != port)
+        {
+            TRACE_ERROR(SERIAL, "Serial port '%s' is not registered to the reactor", port->getDevicePath().c_str());
+            return false;
+        }
+
+        if (it->second.state != port_idle || it->second.queue.empty() == false)
+        {
+            TRACE_ERROR(SERIAL, "Serial port '%s' is busy, it cannot be lent to some blocking work", port->getDevicePath().c_str());
+            return false;
+        }
+
+        // The work reads the port on its own, the I/O thread must stay away from it
+        if (it->second.hungUp == false)
+        {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+        }
+        it->second.state = port_offloaded;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock(worksLock);
+        works.push_back(OffloadedWork{port, work, done});
+    }
+    worksCondition.notify_one();
+
+    return true;
+}
+
+void SerialPortReactor::worker()
+{
+    while (true)
+    {
+        OffloadedWork w;
+        {
+            std::unique_lock <std::mutex> lock(worksLock);
+            worksCondition.wait(lock, [this] { return works.empty() == false || running == false; });
+
+            if (running == false)
+            {
+                break;
+            }
+
+            w = works.front();
+            works.pop_front();
+        }
+
+        w.work();
+
+        // Give the port back to the I/O thread, then report from there
+        {
+            std::lock_guard <std::mutex> lock(portsLock);
+
+            auto it = ports.find(w.port->ttyDeviceFileDescriptor);
+            if (it != ports.end() && it->second.port == w.port && it->second.state == port_offloaded)
+            {
+                it->second.state = port_idle;
+
+                if (it->second.hungUp == false)
+                {
+                    struct epoll_event ev;
+                    ev.events = EPOLLIN;
+                    ev.data.fd = it->first;
+                    epoll_ctl(epollFd, EPOLL_CTL_ADD, it->first, &ev);
+                }
+            }
+
+            if (w.done)
+            {
+                tasks.push(ScheduledTask{std::chrono::steady_clock::now(), w.done});
+            }
+        }
+
+        wake();
+    }
+}
+
+void SerialPortReactor::step(PortContext &ctx, bool readable, std::vector <CompletedTransaction> &done)
+{
+    int fd = ctx.port->ttyDeviceFileDescriptor;
+
+    if (ctx.state == port_offloaded)
+    {
+        return;
+    }
+
+    if (ctx.hungUp == true)
+    {
+        // Fail the transaction in flight, and every queued one
+        while (ctx.queue.empty() == false)
+        {
+            done.push_back({ctx.queue.front(), COMM_TXFAIL, {}});
+            ctx.queue.pop_front();
+        }
+
+        ctx.response.clear();
+        ctx.state = port_idle;
+        return;
+    }
+
+    // Keep going while transactions complete immediately (no response expected)
+    while (true)
+    {
+        if (ctx.state == port_idle)
+        {
+            if (ctx.queue.empty())
+            {
+                return;
+            }
+
+            SerialTransaction &t = ctx.queue.front();
+
+            // Drop any leftover bytes from a previous transaction
+            ctx.port->flush();
+            ctx.response.clear();
+
+            int sent = write(fd, t.request.data(), t.request.size());
+
+            if (sent != static_cast<int>(t.request.size()))
+            {
+                done.push_back({t, COMM_TXFAIL, {}});
+                ctx.queue.pop_front();
+                continue;
+            }
+
+            if (t.responseLength <= 0)
+            {
+                done.push_back({t, COMM_RXSUCCESS, {}});
+                ctx.queue.pop_front();
+                continue;
+            }
+
+            double timeout = t.timeout;
+            if (timeout <= 0.0)
+            {
+                timeout = ctx.port->getByteTransfertTime() * static_cast<double>(t.responseLength) +
+                          2.0 * static_cast<double>(ctx.port->getLatency());
+            }
+            timeout += ctx.port->getRS485TurnaroundTime();
+
+            ctx.deadline = std::chrono::steady_clock::now() +
+                           std::chrono::microseconds(static_cast<long long>(timeout * 1000.0));
+            ctx.state = port_waiting;
+            readable = false;
+        }
+
+        // port_waiting
+        SerialTransaction &t = ctx.queue.front();
+
+        if (readable)
+        {
+            unsigned char buffer[256];
+            int wanted = t.responseLength - static_cast<int>(ctx.response.size());
+            int nRead = read(fd, buffer, (wanted < 256) ? wanted : 256);
+
+            if (nRead > 0)
+            {
+                ctx.response.insert(ctx.response.end(), buffer, buffer + nRead);
+            }
+        }
+
+        int status = COMM_RXWAITING;
+        int received = static_cast<int>(ctx.response.size());
+
+        if (t.frame)
+        {
+            // The response ends where the framing says so, and must be valid
+            int framed = (received > 0) ? t.frame(ctx.response.data(), received) : 0;
+
+            if (framed > 0)
+            {
+                ctx.response.resize(framed);
+                status = COMM_RXSUCCESS;
+            }
+            else if (framed < 0 || received >= t.responseLength)
+            {
+                status = COMM_RXCORRUPT;
+            }
+        }
+        else if (received >= t.responseLength)
+        {
+            status = COMM_RXSUCCESS;
+        }
+
+        if (status == COMM_RXWAITING && std::chrono::steady_clock::now() >= ctx.deadline)
+        {
+            status = ctx.response.empty() ? COMM_RXTIMEOUT : COMM_RXCORRUPT;
+        }
+
+        if (status == COMM_RXWAITING)
+        {
+            return;
+        }
+
+        done.push_back({t, status, ctx.response});
+        ctx.queue.pop_front();
+        ctx.state = port_idle;
+        readable = false;
+    }
+}
+
+void SerialPortReactor::run()
+{
+    TRACE_INFO(SERIAL, ">> Serial reactor thread started");
+
+    const int maxEvents = 32;
+    struct epoll_event events[maxEvents];
+
+    std::vector <CompletedTransaction> done;
+    std::vector <std::function <void ()> > due;
+
+    while (running)
+    {
+        // Arm the timer on the nearest deadline, then sleep until something happens
+        // (steady_clock is CLOCK_MONOTONIC, so its time points can be used as is)
+        {
+            std::lock_guard <std::mutex> lock(portsLock);
+
+            bool armed = false;
+            std::chrono::steady_clock::time_point next;
+
+            for (auto &p: ports)
+            {
+                if (p.second.state == port_waiting && (armed == false || p.second.deadline < next))
+                {
+                    next = p.second.deadline;
+                    armed = true;
+                }
+            }
+
+            if (tasks.empty() == false && (armed == false || tasks.top().deadline < next))
+            {
+                next = tasks.top().deadline;
+                armed = true;
+            }
+
+            struct itimerspec its = {};
+            if (armed)
+            {
+                long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count();
+
+                // A zero value would disarm the timer
+                if (ns <= 0)
+                {
+                    ns = 1;
+                }
+
+                its.it_value.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+                its.it_value.tv_nsec = static_cast<long>(ns % 1000000000LL);
+            }
+            timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &its, nullptr);
+        }
+
+        int nfds = epoll_wait(epollFd, events, maxEvents, -1);
+
+        if (nfds < 0 && errno != EINTR)
+        {
+            TRACE_ERROR(SERIAL, "epoll_wait() failed with error code '%i'", errno);
+            break;
+        }
+
+        done.clear();
+        due.clear();
+
+        {
+            std::lock_guard <std::mutex> lock(portsLock);
+
+            for (int i = 0; i < nfds; i++)
+            {
+                if (events[i].data.fd == wakeFd || events[i].data.fd == timerFd)
+                {
+                    // Drain the eventfd counter, or the timer expirations
+                    uint64_t value;
+                    ssize_t drained = read(events[i].data.fd, &value, sizeof(value));
+                    (void)drained;
+                    continue;
+                }
+
+                auto it = ports.find(events[i].data.fd);
+                if (it == ports.end())
+                {
+                    continue;
+                }
+
+                if (events[i].events & (EPOLLHUP | EPOLLERR))
+                {
+                    // The device is gone (unplugged adapter...): it would be reported forever
+                    TRACE_ERROR(SERIAL, "Serial port '%s' hung up, its transactions are cancelled", it->second.port->getDevicePath().c_str());
+                    epoll_ctl(epollFd, EPOLL_CTL_DEL, it->first, nullptr);
+                    it->second.hungUp = true;
+                }
+                else if (it->second.state == port_waiting)
+                {
+                    step(it->second, true, done);
+                }
+                else if (it->second.state == port_idle)
+                {
+                    // Unexpected bytes on an idle port, drop them or they would be reported forever
+                    it->second.port->flush();
+                }
+            }
+
+            // Start new transactions, and check deadlines on every port
+            for (auto &p: ports)
+            {
+                step(p.second, false, done);
+            }
+
+            // Then the tasks which deadline has passed
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            while (tasks.empty() == false && tasks.top().deadline <= now)
+            {
+                due.push_back(tasks.top().task);
+                tasks.pop();
+            }
+        }
+
+        // Callbacks and tasks are called without holding the lock, so they can submit new transactions
+        for (const auto &d: done)
+        {
+            if (d.transaction.callback)
+            {
+                d.transaction.callback(d.status, d.response);
+            }
+        }
+
+        for (const auto &task: due)
+        {
+            task();
+        }
+    }
+
+    TRACE_INFO(SERIAL, ">> Serial reactor thread stopped");
+}
+
+#endif // __linux__ || __gnu_linux
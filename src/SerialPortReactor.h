@@ -0,0 +1,243 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortReactor.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef SERIALPORT_REACTOR_H
+#define SERIALPORT_REACTOR_H
+
+#include "SerialPort.h"
+
+#include <functional>
+#include <vector>
+
+/*!
+ * \brief A serial transaction: one packet to send, and optionally one status packet to receive.
+ */
+struct SerialTransaction
+{
+    std::vector <unsigned char> request;    //!< Bytes to send.
+    int responseLength = 0;                 //!< Number of bytes expected in response (maximum size of the response if 'frame' is set). 0 if no response is expected.
+    double timeout = 0.0;                   //!< Time (in millisecond) to wait for the response. If 0, computed like SerialPort::setTimeOut(int).
+
+    /*!
+     * \brief Optional packet framing, called from the reactor thread each time some bytes are received.
+     * \param data: The bytes received so far.
+     * \param size: The number of bytes received so far.
+     * \return The size of the complete and valid response, 0 if more bytes are needed, or -1 if the bytes received cannot be a valid response.
+     *
+     * Without it, the transaction is complete once 'responseLength' bytes are received.
+     */
+    std::function <int (const unsigned char *data, const int size)> frame;
+
+    /*!
+     * \brief Called from the reactor thread once the transaction is over.
+     * \param status: COMM_RXSUCCESS, COMM_TXFAIL, COMM_RXTIMEOUT (nothing received) or COMM_RXCORRUPT (incomplete or invalid response).
+     * \param response: The bytes received.
+     */
+    std::function <void (int status, const std::vector <unsigned char> &response)> callback;
+};
+
+#if defined(__linux__) || defined(__gnu_linux)
+
+#include "SerialPortLinux.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+/*!
+ * \brief The SerialPortReactor class multiplexes several Linux serial ports from one I/O thread.
+ *
+ * Each registered port has a queue of transactions, processed one at a time
+ * (the bus is half duplex) by a small state machine: idle, then waiting for a
+ * response until it is complete or its deadline is reached. Ports are
+ * independent from each other, so every bus can have one transaction in flight
+ * at the same time, using epoll to wait on all of them at once.
+ *
+ * The I/O thread also runs tasks at a given time (see schedule()), which is
+ * how controllers in reactor mode start their synchronization cycles, and a
+ * worker thread runs the occasional blocking work of a port (see offload()).
+ *
+ * Ports used by the reactor must be opened, and must not be used by a
+ * controller or a SimpleAPI instance at the same time (except through offload()).
+ */
+class SerialPortReactor
+{
+    enum PortState_e
+    {
+        port_idle = 0,
+        port_waiting = 1,
+        port_offloaded = 2
+    };
+
+    struct PortContext
+    {
+        SerialPortLinux *port = nullptr;
+        int state = port_idle;
+        std::deque <SerialTransaction> queue;
+        std::vector <unsigned char> response;
+        std::chrono::steady_clock::time_point deadline;
+        bool hungUp = false;        //!< The device is gone (EPOLLHUP or EPOLLERR), every transaction fails until the port is removed.
+    };
+
+    struct CompletedTransaction
+    {
+        SerialTransaction transaction;
+        int status;
+        std::vector <unsigned char> response;
+    };
+
+    struct ScheduledTask
+    {
+        std::chrono::steady_clock::time_point deadline;
+        std::function <void ()> task;
+    };
+
+    //! Orders the task heap, the task with the closest deadline on top.
+    struct ScheduledTaskDeadline
+    {
+        bool operator()(const ScheduledTask &a, const ScheduledTask &b) const
+        {
+            return a.deadline > b.deadline;
+        }
+    };
+
+    struct OffloadedWork
+    {
+        SerialPortLinux *port;
+        std::function <void ()> work;
+        std::function <void ()> done;
+    };
+
+    int epollFd = -1;               //!< The epoll instance watching every port.
+    int wakeFd = -1;                //!< An eventfd used to wake the I/O thread when a transaction is submitted.
+    int timerFd = -1;               //!< A timerfd armed on the nearest deadline (transaction response or scheduled task).
+
+    std::map <int, PortContext> ports; //!< Registered ports, indexed by file descriptor.
+    std::priority_queue <ScheduledTask, std::vector <ScheduledTask>, ScheduledTaskDeadline> tasks; //!< Tasks waiting for their deadline.
+    std::mutex portsLock;           //!< Protects 'ports' (and the transaction queues) and 'tasks'.
+
+    std::deque <OffloadedWork> works; //!< Blocking work waiting for the worker thread.
+    std::mutex worksLock;           //!< Protects 'works'.
+    std::condition_variable worksCondition;
+
+    std::thread reactorThread;
+    std::thread workerThread;
+    std::atomic <bool> running;
+
+    //! I/O loop, running inside its own background thread.
+    void run();
+
+    //! Run the offloaded work, one at a time, inside its own background thread.
+    void worker();
+
+    //! Wake the I/O thread, so it takes new transactions or tasks into account.
+    void wake();
+
+    /*!
+     * \brief Advance the state machine of one port.
+     * \param ctx: The port context.
+     * \param readable: true if the port has some data available.
+     * \param[out] done: Transactions that just completed, with their status and response.
+     */
+    void step(PortContext &ctx, bool readable, std::vector <CompletedTransaction> &done);
+
+public:
+    SerialPortReactor();
+    ~SerialPortReactor();
+
+    /*!
+     * \brief Get the reactor shared by every controller running in reactor mode, create and start it if needed.
+     * \return A shared pointer to the reactor, or nullptr if it cannot be started.
+     *
+     * The reactor is stopped once the last shared pointer is released, which
+     * must not happen from the reactor threads.
+     */
+    static std::shared_ptr <SerialPortReactor> getShared();
+
+    /*!
+     * \brief Start the I/O and worker threads.
+     * \return true if the reactor is running.
+     */
+    bool start();
+
+    /*!
+     * \brief Stop the I/O and worker threads. Pending transactions, tasks and offloaded work are dropped without calling their callbacks.
+     */
+    void stop();
+
+    /*!
+     * \brief Register an opened serial port to the reactor.
+     * \param port: The serial port to multiplex.
+     * \return true if the port has been registered.
+     */
+    bool addPort(SerialPortLinux *port);
+
+    /*!
+     * \brief Unregister a serial port. Its pending transactions are dropped.
+     * \param port: The serial port to remove.
+     *
+     * A port that hung up must be removed, then reopened and added again to be used.
+     */
+    void removePort(SerialPortLinux *port);
+
+    /*!
+     * \brief Queue a transaction on a registered port.
+     * \param port: The serial port to use.
+     * \param transaction: The transaction to execute.
+     * \return true if the transaction has been queued.
+     *
+     * Can be called from any thread, including from a transaction callback.
+     * Fails if the port hung up: its transactions already failed with COMM_TXFAIL.
+     */
+    bool submit(SerialPortLinux *port, const SerialTransaction &transaction);
+
+    /*!
+     * \brief Run a task from the I/O thread.
+     * \param deadline: When to run the task. A deadline in the past runs it right away.
+     * \param task: The task. Keep it short, every port waits for it.
+     *
+     * Can be called from any thread, including from a task or a transaction callback.
+     */
+    void schedule(const std::chrono::steady_clock::time_point &deadline, std::function <void ()> task);
+
+    /*!
+     * \brief Lend a registered port to some blocking work, run by the worker thread.
+     * \param port: The serial port used by the work. Must not have any transaction in progress.
+     * \param work: The work, free to use the port directly (blocking reads and writes).
+     * \param done: Called from the I/O thread once the work is over and the port is back into the reactor.
+     * \return true if the work has been queued.
+     *
+     * Meant for rare and long operations (scan, initial register reads...): the
+     * other ports keep going, but works are run one after the other.
+     */
+    bool offload(SerialPortLinux *port, std::function <void ()> work, std::function <void ()> done);
+};
+
+#endif // __linux__ || __gnu_linux
+
+#endif // SERIALPORT_REACTOR_H
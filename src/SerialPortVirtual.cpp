@@ -0,0 +1,1309 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortVirtual.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#include "SerialPortVirtual.h"
+#include "DynamixelTools.h"
+#include "HerkuleXTools.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+/* ************************************************************************** */
+
+// Instructions and commands understood by the emulated devices
+enum {
+    VDXL_PING           = 1,
+    VDXL_READ           = 2,
+    VDXL_WRITE          = 3,
+    VDXL_REG_WRITE      = 4,
+    VDXL_ACTION         = 5,
+    VDXL_FACTORY_RESET  = 6,
+    VDXL_REBOOT         = 8,
+    VDXL_STATUS         = 0x55,
+    VDXL_SYNC_READ      = 0x82,
+    VDXL_SYNC_WRITE     = 0x83,
+    VDXL_BULK_READ      = 0x92,
+    VDXL_BULK_WRITE     = 0x93,
+
+    VHKX_EEP_WRITE      = 1,
+    VHKX_EEP_READ       = 2,
+    VHKX_RAM_WRITE      = 3,
+    VHKX_RAM_READ       = 4,
+    VHKX_I_JOG          = 5,
+    VHKX_S_JOG          = 6,
+    VHKX_STAT           = 7,
+    VHKX_ROLLBACK       = 8,
+    VHKX_REBOOT         = 9
+};
+
+typedef std::vector <std::pair <int, std::vector <unsigned char> > > ReplyList;
+
+static std::map <std::string, std::shared_ptr <VirtualServoBus> > virtualBuses;
+static std::mutex virtualBusesLock;
+
+static std::string virtualBusName(const std::string &name)
+{
+    std::string prefix = VIRTUAL_PORT_PREFIX;
+
+    if (name.compare(0, prefix.size(), prefix) == 0)
+    {
+        return name.substr(prefix.size());
+    }
+
+    return name;
+}
+
+static void putValue(std::vector <unsigned char> &image, const int addr, const int size, const int value)
+{
+    for (int i = 0; i < size; i++)
+    {
+        if (addr + i >= 0 && addr + i < static_cast<int>(image.size()))
+        {
+            image[addr + i] = static_cast<unsigned char>((value >> (8*i)) & 0xFF);
+        }
+    }
+}
+
+static int getValue(const std::vector <unsigned char> &image, const int addr, const int size)
+{
+    if (addr < 0 || size < 1 || addr + size > static_cast<int>(image.size()))
+    {
+        return -1;
+    }
+
+    return make_value(&image[addr], size);
+}
+
+static unsigned short dxl2_crc(const unsigned char *data, const int size)
+{
+    unsigned short crc = 0;
+
+    for (int i = 0; i < size; i++)
+    {
+        crc ^= static_cast<unsigned short>(data[i]) << 8;
+
+        for (int j = 0; j < 8; j++)
+        {
+            crc = (crc & 0x8000) ? ((crc << 1) ^ 0x8005) : (crc << 1);
+        }
+    }
+
+    return crc;
+}
+
+static unsigned char hkx_checksum1(const unsigned char *packet, const int size)
+{
+    int sum = packet[2] ^ packet[3] ^ packet[4];
+    for (int i = 7; i < size; i++)
+    {
+        sum ^= packet[i];
+    }
+
+    return static_cast<unsigned char>(sum & 0xFE);
+}
+
+/* ************************************************************************** */
+
+VirtualServoBus::VirtualServoBus():
+    rng(42)
+{
+    //
+}
+
+VirtualServoBus::~VirtualServoBus()
+{
+    //
+}
+
+std::shared_ptr <VirtualServoBus> VirtualServoBus::getBus(const std::string &name)
+{
+    std::lock_guard <std::mutex> lock(virtualBusesLock);
+
+    std::shared_ptr <VirtualServoBus> &bus = virtualBuses[virtualBusName(name)];
+    if (bus == nullptr)
+    {
+        bus = std::make_shared <VirtualServoBus>();
+    }
+
+    return bus;
+}
+
+void VirtualServoBus::removeBus(const std::string &name)
+{
+    std::lock_guard <std::mutex> lock(virtualBusesLock);
+    virtualBuses.erase(virtualBusName(name));
+}
+
+bool VirtualServoBus::addDynamixel(const int id, const int model_number, const int protocol)
+{
+    VirtualServo s;
+    s.id = id;
+    s.protocol = (protocol == PROTOCOL_DXLv2) ? PROTOCOL_DXLv2 : PROTOCOL_DXLv1;
+    dxl_get_model_infos(model_number, s.servoSerie, s.servoModel);
+    s.ct = getRegisterTable(s.servoSerie, s.servoModel);
+
+    if (id < 0 || id >= BROADCAST_ID || s.ct == nullptr)
+    {
+        TRACE_ERROR(SERIAL, "Cannot add a virtual Dynamixel device [#%i] with model number '%i'", id, model_number);
+        return false;
+    }
+
+    std::lock_guard <std::mutex> lock(busLock);
+
+    initRegisters(s);
+    writeRegister(s, REG_MODEL_NUMBER, model_number);
+    servos[id] = s;
+
+    return true;
+}
+
+bool VirtualServoBus::addHerkuleX(const int id, const int model_number)
+{
+    VirtualServo s;
+    s.id = id;
+    s.protocol = PROTOCOL_HKX;
+    hkx_get_model_infos(model_number, s.servoSerie, s.servoModel);
+    s.ct = getRegisterTable(s.servoSerie, s.servoModel);
+
+    if (id < 0 || id >= BROADCAST_ID || s.ct == nullptr)
+    {
+        TRACE_ERROR(SERIAL, "Cannot add a virtual HerkuleX device [#%i] with model number '%i'", id, model_number);
+        return false;
+    }
+
+    std::lock_guard <std::mutex> lock(busLock);
+
+    initRegisters(s);
+    writeRegister(s, REG_MODEL_NUMBER, model_number);
+    servos[id] = s;
+
+    return true;
+}
+
+void VirtualServoBus::removeServo(const int id)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    servos.erase(id);
+}
+
+void VirtualServoBus::setReturnDelay(const int usec)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    returnDelay = usec;
+
+    if (returnDelay >= 0)
+    {
+        // Keep the registers consistent with the delay applied (2µs units)
+        int value = std::min(returnDelay / 2, 254);
+
+        for (auto &s: servos)
+        {
+            writeRegister(s.second, REG_RETURN_DELAY_TIME, value);
+        }
+    }
+}
+
+void VirtualServoBus::setPingSlot(const int usec)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    pingSlot = (usec > 0) ? usec : 0;
+}
+
+void VirtualServoBus::setErrorRates(const double drop, const double corrupt)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    dropRate = drop;
+    corruptRate = corrupt;
+}
+
+void VirtualServoBus::setServoError(const int id, const int errorBits)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+
+    auto it = servos.find(id);
+    if (it != servos.end())
+    {
+        it->second.errorBits = errorBits;
+    }
+}
+
+void VirtualServoBus::getTraffic(unsigned long long &host, unsigned long long &devices)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    host = hostBytes;
+    devices = deviceBytes;
+}
+
+void VirtualServoBus::resetTraffic()
+{
+    std::lock_guard <std::mutex> lock(busLock);
+    hostBytes = 0;
+    deviceBytes = 0;
+}
+
+/* ************************************************************************** */
+
+void VirtualServoBus::initRegisters(VirtualServo &s)
+{
+    // Size the register images to fit every register of the control table
+    int romSize = 0, ramSize = 0;
+
+    for (unsigned i = 0; i < getRegisterCount(s.ct); i++)
+    {
+        int size = s.ct[i][1];
+
+        if (s.ct[i][3] >= 0 && s.ct[i][3] + size > romSize)
+        {
+            romSize = s.ct[i][3] + size;
+        }
+        if (s.ct[i][4] >= 0 && s.ct[i][4] + size > ramSize)
+        {
+            ramSize = s.ct[i][4] + size;
+        }
+    }
+
+    if (s.protocol == PROTOCOL_HKX)
+    {
+        s.rom.assign(romSize, 0);
+        s.ram.assign(ramSize, 0);
+    }
+    else
+    {
+        // Dynamixel devices use a single address space
+        s.rom.assign((romSize > ramSize) ? romSize : ramSize, 0);
+        s.ram.clear();
+    }
+
+    s.regWrite.clear();
+
+    // Initial values ('-1' and '-2' are markers, not values), kept within the register bounds
+    for (unsigned i = 0; i < getRegisterCount(s.ct); i++)
+    {
+        int value = s.ct[i][5];
+        int min = s.ct[i][6];
+        int max = s.ct[i][7];
+
+        if (value < 0)
+        {
+            value = 0;
+        }
+        if (min >= 0 && max > min)
+        {
+            value = (value < min) ? min : ((value > max) ? max : value);
+        }
+
+        writeRegister(s, s.ct[i][0], value);
+    }
+
+    writeRegister(s, REG_FIRMWARE_VERSION, 1);
+    writeRegister(s, REG_ID, s.id);
+}
+
+void VirtualServoBus::writeRegister(VirtualServo &s, const int reg_name, const int value)
+{
+    RegisterInfos infos;
+
+    if (getRegisterInfos(s.ct, reg_name, infos) == 1)
+    {
+        if (s.protocol == PROTOCOL_HKX)
+        {
+            putValue(s.rom, infos.reg_addr_rom, infos.reg_size, value);
+            putValue(s.ram, infos.reg_addr_ram, infos.reg_size, value);
+        }
+        else
+        {
+            putValue(s.rom, getRegisterAddr(s.ct, reg_name), infos.reg_size, value);
+        }
+    }
+}
+
+int VirtualServoBus::readRegister(VirtualServo &s, const int reg_name, const int reg_type)
+{
+    RegisterInfos infos;
+    int value = -1;
+
+    if (getRegisterInfos(s.ct, reg_name, infos) == 1)
+    {
+        if (s.protocol == PROTOCOL_HKX)
+        {
+            if (reg_type != REGISTER_ROM && infos.reg_addr_ram >= 0)
+            {
+                value = getValue(s.ram, infos.reg_addr_ram, infos.reg_size);
+            }
+            else
+            {
+                value = getValue(s.rom, infos.reg_addr_rom, infos.reg_size);
+            }
+        }
+        else
+        {
+            value = getValue(s.rom, getRegisterAddr(s.ct, reg_name), infos.reg_size);
+        }
+    }
+
+    return value;
+}
+
+void VirtualServoBus::updateId(const int oldId)
+{
+    auto it = servos.find(oldId);
+    if (it == servos.end())
+    {
+        return;
+    }
+
+    int newId = readRegister(it->second, REG_ID);
+
+    if (newId >= 0 && newId != oldId && newId < BROADCAST_ID && servos.count(newId) == 0)
+    {
+        VirtualServo s = it->second;
+        s.id = newId;
+        servos.erase(it);
+        servos[newId] = s;
+    }
+    else
+    {
+        // Invalid or already used ID, keep the previous one
+        it->second.id = oldId;
+        writeRegister(it->second, REG_ID, oldId);
+    }
+}
+
+bool VirtualServoBus::chance(const double rate)
+{
+    if (rate <= 0.0)
+    {
+        return false;
+    }
+
+    std::uniform_real_distribution <double> dist(0.0, 1.0);
+    return (dist(rng) < rate);
+}
+
+void VirtualServoBus::corruptPacket(std::vector <unsigned char> &packet)
+{
+    // Flipping every bit of the last byte breaks the checksum of all three protocols
+    if (packet.empty() == false)
+    {
+        packet.back() ^= 0xFF;
+    }
+}
+
+int VirtualServoBus::servoReturnDelay(VirtualServo &s)
+{
+    if (returnDelay >= 0)
+    {
+        return returnDelay;
+    }
+
+    // The 'return delay time' register uses 2µs units
+    int delay = readRegister(s, REG_RETURN_DELAY_TIME);
+
+    return (delay > 0) ? delay * 2 : 0;
+}
+
+/* ************************************************************************** */
+
+bool VirtualServoBus::dxlRead(VirtualServo &s, const int addr, const int len, std::vector <unsigned char> &data)
+{
+    if (addr < 0 || len < 1 || addr + len > static_cast<int>(s.rom.size()))
+    {
+        return false;
+    }
+
+    data.assign(s.rom.begin() + addr, s.rom.begin() + addr + len);
+    return true;
+}
+
+bool VirtualServoBus::dxlWrite(VirtualServo &s, const int addr, const unsigned char *data, const int len)
+{
+    if (addr < 0 || len < 1 || addr + len > static_cast<int>(s.rom.size()))
+    {
+        return false;
+    }
+
+    memcpy(&s.rom[addr], data, len);
+
+    // Moves are instantaneous
+    int goalAddr = getRegisterAddr(s.ct, REG_GOAL_POSITION);
+    int goalSize = getRegisterSize(s.ct, REG_GOAL_POSITION);
+
+    if (goalAddr >= 0 && goalAddr < addr + len && goalAddr + goalSize > addr)
+    {
+        writeRegister(s, REG_CURRENT_POSITION, getValue(s.rom, goalAddr, goalSize));
+    }
+
+    return true;
+}
+
+int VirtualServoBus::dxlStatusLevel(VirtualServo &s)
+{
+    int level = readRegister(s, REG_STATUS_RETURN_LEVEL);
+
+    return (level < 0) ? 2 : level;
+}
+
+void VirtualServoBus::dxlStatus(VirtualServo &s, const int error, const std::vector <unsigned char> &params, std::vector <unsigned char> &out)
+{
+    int nparams = static_cast<int>(params.size());
+    out.clear();
+
+    if (s.protocol == PROTOCOL_DXLv2)
+    {
+        int length = nparams + 4;
+
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+        out.push_back(0xFD);
+        out.push_back(0x00);
+        out.push_back(get_lowbyte(s.id));
+        out.push_back(get_lowbyte(length));
+        out.push_back(get_highbyte(length));
+        out.push_back(VDXL_STATUS);
+        out.push_back(get_lowbyte((error != 0) ? error : s.errorBits));
+        out.insert(out.end(), params.begin(), params.end());
+
+        unsigned short crc = dxl2_crc(out.data(), static_cast<int>(out.size()));
+        out.push_back(get_lowbyte(crc));
+        out.push_back(get_highbyte(crc));
+    }
+    else
+    {
+        out.push_back(0xFF);
+        out.push_back(0xFF);
+        out.push_back(get_lowbyte(s.id));
+        out.push_back(get_lowbyte(nparams + 2));
+        out.push_back(get_lowbyte(error | s.errorBits));
+        out.insert(out.end(), params.begin(), params.end());
+
+        unsigned char checksum = 0;
+        for (size_t i = 2; i < out.size(); i++)
+        {
+            checksum += out[i];
+        }
+        out.push_back(~checksum);
+    }
+}
+
+void VirtualServoBus::dxlProcess(const int protocol, const int id, const int inst, const unsigned char *params, const int nparams,
+                                 ReplyList &replies)
+{
+    const bool v2 = (protocol == PROTOCOL_DXLv2);
+    const bool broadcast = (id == BROADCAST_ID);
+    const int errRange = v2 ? static_cast<int>(ERRBIT2_DATA_RANGE) : static_cast<int>(ERRBIT1_RANGE);
+    const int errInst = v2 ? static_cast<int>(ERRBIT2_INSTRUCTION) : static_cast<int>(ERRBIT1_INSTRUCTION);
+
+    // Address and length fields are one byte long with protocol v1, two bytes long with v2
+    const int fieldSize = v2 ? 2 : 1;
+
+    std::vector <unsigned char> data, packet;
+    std::vector <int> touched;
+
+    auto reply = [&](VirtualServo &s, const int error, const std::vector <unsigned char> &p)
+    {
+        dxlStatus(s, error, p, packet);
+        replies.push_back(std::make_pair(servoReturnDelay(s), packet));
+    };
+    auto find = [&](const int servoId) -> VirtualServo *
+    {
+        auto it = servos.find(servoId);
+        if (it != servos.end() && it->second.protocol == protocol)
+        {
+            return &it->second;
+        }
+        return nullptr;
+    };
+    auto field = [&](const int offset) -> int
+    {
+        return v2 ? make_short_word(params[offset], params[offset + 1]) : params[offset];
+    };
+
+    switch (inst)
+    {
+    case VDXL_PING:
+    {
+        // Answers to a broadcast 'Ping' come in ID order, one time slot per ID
+        int slotId = 0;
+
+        for (auto &it: servos)
+        {
+            VirtualServo &s = it.second;
+
+            if (s.protocol == protocol && (s.id == id || (broadcast && v2)))
+            {
+                data.clear();
+                if (v2)
+                {
+                    int model = readRegister(s, REG_MODEL_NUMBER);
+                    data.push_back(get_lowbyte(model));
+                    data.push_back(get_highbyte(model));
+                    data.push_back(get_lowbyte(readRegister(s, REG_FIRMWARE_VERSION)));
+                }
+                reply(s, 0, data);
+
+                if (broadcast)
+                {
+                    replies.back().first += (s.id - slotId) * pingSlot;
+                    slotId = s.id;
+                }
+            }
+        }
+        break;
+    }
+
+    case VDXL_READ:
+        if (VirtualServo *s = find(id))
+        {
+            if (nparams >= 2*fieldSize && dxlStatusLevel(*s) >= 1)
+            {
+                if (dxlRead(*s, field(0), field(fieldSize), data))
+                {
+                    reply(*s, 0, data);
+                }
+                else
+                {
+                    reply(*s, errRange, std::vector <unsigned char>());
+                }
+            }
+        }
+        break;
+
+    case VDXL_WRITE:
+    case VDXL_REG_WRITE:
+        for (auto &it: servos)
+        {
+            VirtualServo &s = it.second;
+
+            if (s.protocol == protocol && (s.id == id || broadcast) && nparams > fieldSize)
+            {
+                bool ok = true;
+
+                if (inst == VDXL_WRITE)
+                {
+                    ok = dxlWrite(s, field(0), params + fieldSize, nparams - fieldSize);
+                    touched.push_back(s.id);
+                }
+                else
+                {
+                    s.regWrite.assign(params, params + nparams);
+                }
+
+                if (broadcast == false && dxlStatusLevel(s) >= 2)
+                {
+                    reply(s, ok ? 0 : errRange, std::vector <unsigned char>());
+                }
+            }
+        }
+        break;
+
+    case VDXL_ACTION:
+        for (auto &it: servos)
+        {
+            VirtualServo &s = it.second;
+
+            if (s.protocol == protocol && (s.id == id || broadcast))
+            {
+                if (s.regWrite.size() > static_cast<size_t>(fieldSize))
+                {
+                    int addr = v2 ? make_short_word(s.regWrite[0], s.regWrite[1]) : s.regWrite[0];
+                    dxlWrite(s, addr, &s.regWrite[fieldSize], static_cast<int>(s.regWrite.size()) - fieldSize);
+                    s.regWrite.clear();
+                    touched.push_back(s.id);
+                }
+
+                if (broadcast == false && dxlStatusLevel(s) >= 2)
+                {
+                    reply(s, 0, std::vector <unsigned char>());
+                }
+            }
+        }
+        break;
+
+    case VDXL_FACTORY_RESET:
+    case VDXL_REBOOT:
+        for (auto &it: servos)
+        {
+            VirtualServo &s = it.second;
+
+            if (s.protocol == protocol && (s.id == id || broadcast))
+            {
+                if (broadcast == false && dxlStatusLevel(s) >= 2)
+                {
+                    reply(s, 0, std::vector <unsigned char>());
+                }
+
+                if (inst == VDXL_FACTORY_RESET)
+                {
+                    // Protocol v2 options: 0xFF resets everything, 0x01 keeps the ID, 0x02 keeps ID and baudrate
+                    int model = readRegister(s, REG_MODEL_NUMBER);
+                    int baud = readRegister(s, REG_BAUD_RATE);
+                    int option = (v2 && nparams > 0) ? params[0] : 0xFF;
+
+                    if (option == 0xFF)
+                    {
+                        s.id = s.ct[getRegisterTableIndex(s.ct, REG_ID)][5];
+                    }
+
+                    initRegisters(s);
+                    writeRegister(s, REG_MODEL_NUMBER, model);
+
+                    if (option == 0x02)
+                    {
+                        writeRegister(s, REG_BAUD_RATE, baud);
+                    }
+
+                    touched.push_back(it.first);
+                }
+            }
+        }
+        break;
+
+    case VDXL_SYNC_WRITE:
+        if (nparams > 2*fieldSize)
+        {
+            int addr = field(0);
+            int len = field(fieldSize);
+
+            for (int i = 2*fieldSize; len > 0 && i + 1 + len <= nparams; i += 1 + len)
+            {
+                if (VirtualServo *s = find(params[i]))
+                {
+                    dxlWrite(*s, addr, params + i + 1, len);
+                    touched.push_back(s->id);
+                }
+            }
+        }
+        break;
+
+    case VDXL_BULK_WRITE:
+        for (int i = 0; v2 && i + 5 <= nparams;)
+        {
+            int addr = make_short_word(params[i+1], params[i+2]);
+            int len = make_short_word(params[i+3], params[i+4]);
+
+            if (len < 1 || i + 5 + len > nparams)
+            {
+                break;
+            }
+
+            if (VirtualServo *s = find(params[i]))
+            {
+                dxlWrite(*s, addr, params + i + 5, len);
+                touched.push_back(s->id);
+            }
+
+            i += 5 + len;
+        }
+        break;
+
+    case VDXL_SYNC_READ:
+        if (v2 && nparams > 4)
+        {
+            int addr = make_short_word(params[0], params[1]);
+            int len = make_short_word(params[2], params[3]);
+
+            for (int i = 4; i < nparams; i++)
+            {
+                if (VirtualServo *s = find(params[i]))
+                {
+                    if (dxlRead(*s, addr, len, data))
+                    {
+                        reply(*s, 0, data);
+                    }
+                    else
+                    {
+                        reply(*s, errRange, std::vector <unsigned char>());
+                    }
+                }
+            }
+        }
+        break;
+
+    case VDXL_BULK_READ:
+        if (v2)
+        {
+            // [id, addr L, addr H, len L, len H] per device
+            for (int i = 0; i + 5 <= nparams; i += 5)
+            {
+                if (VirtualServo *s = find(params[i]))
+                {
+                    if (dxlRead(*s, make_short_word(params[i+1], params[i+2]), make_short_word(params[i+3], params[i+4]), data))
+                    {
+                        reply(*s, 0, data);
+                    }
+                    else
+                    {
+                        reply(*s, errRange, std::vector <unsigned char>());
+                    }
+                }
+            }
+        }
+        else
+        {
+            // [0x00, then len, id, addr per device]
+            for (int i = 1; i + 3 <= nparams; i += 3)
+            {
+                if (VirtualServo *s = find(params[i+1]))
+                {
+                    if (dxlRead(*s, params[i+2], params[i], data))
+                    {
+                        reply(*s, 0, data);
+                    }
+                    else
+                    {
+                        reply(*s, errRange, std::vector <unsigned char>());
+                    }
+                }
+            }
+        }
+        break;
+
+    default:
+        if (VirtualServo *s = find(id))
+        {
+            reply(*s, errInst, std::vector <unsigned char>());
+        }
+        break;
+    }
+
+    for (int touchedId: touched)
+    {
+        updateId(touchedId);
+    }
+}
+
+/* ************************************************************************** */
+
+bool VirtualServoBus::hkxRead(VirtualServo &s, const bool ram, const int addr, const int len, std::vector <unsigned char> &data)
+{
+    std::vector <unsigned char> &image = ram ? s.ram : s.rom;
+
+    if (addr < 0 || len < 1 || addr + len > static_cast<int>(image.size()))
+    {
+        return false;
+    }
+
+    data.assign(image.begin() + addr, image.begin() + addr + len);
+    return true;
+}
+
+bool VirtualServoBus::hkxWrite(VirtualServo &s, const bool ram, const int addr, const unsigned char *data, const int len)
+{
+    std::vector <unsigned char> &image = ram ? s.ram : s.rom;
+
+    if (addr < 0 || len < 1 || addr + len > static_cast<int>(image.size()))
+    {
+        return false;
+    }
+
+    memcpy(&image[addr], data, len);
+    return true;
+}
+
+void VirtualServoBus::hkxJog(VirtualServo &s, const int position)
+{
+    RegisterInfos infos;
+    const int regs[] = { REG_ABSOLUTE_GOAL_POSITION, REG_GOAL_TRAJECTORY, REG_CALIBRATED_POSITION, REG_ABSOLUTE_POSITION };
+
+    // Moves are instantaneous
+    for (int reg: regs)
+    {
+        if (getRegisterInfos(s.ct, reg, infos) == 1)
+        {
+            putValue(s.ram, infos.reg_addr_ram, infos.reg_size, position);
+        }
+    }
+}
+
+void VirtualServoBus::hkxStatus(VirtualServo &s, const int cmd, const int statusDetail, const std::vector <unsigned char> &data, std::vector <unsigned char> &out)
+{
+    int statusError = readRegister(s, REG_STATUS_ERROR, REGISTER_RAM);
+    int detail = readRegister(s, REG_STATUS_DETAIL, REGISTER_RAM);
+
+    statusError = ((statusError < 0) ? 0 : statusError) | s.errorBits;
+    detail = ((detail < 0) ? 0 : detail) | statusDetail | STATBIT_INPOSITION;
+    if (readRegister(s, REG_TORQUE_ENABLE, REGISTER_RAM) > 0)
+    {
+        detail |= STATBIT_TORQUE_ON;
+    }
+
+    out.clear();
+    out.push_back(0xFF);
+    out.push_back(0xFF);
+    out.push_back(get_lowbyte(7 + static_cast<int>(data.size()) + 2));
+    out.push_back(get_lowbyte(s.id));
+    out.push_back(get_lowbyte(cmd | 0x40));
+    out.push_back(0);
+    out.push_back(0);
+    out.insert(out.end(), data.begin(), data.end());
+    out.push_back(get_lowbyte(statusError));
+    out.push_back(get_lowbyte(detail));
+
+    out[5] = hkx_checksum1(out.data(), static_cast<int>(out.size()));
+    out[6] = (~out[5]) & 0xFE;
+}
+
+void VirtualServoBus::hkxProcess(const int id, const int cmd, const unsigned char *data, const int ndata,
+                                 ReplyList &replies)
+{
+    const bool broadcast = (id == BROADCAST_ID);
+
+    std::vector <unsigned char> payload, packet;
+    std::vector <int> touched;
+
+    for (auto &it: servos)
+    {
+        VirtualServo &s = it.second;
+
+        if (s.protocol != PROTOCOL_HKX)
+        {
+            continue;
+        }
+
+        // Jog commands carry their own target IDs
+        if (cmd == VHKX_I_JOG || cmd == VHKX_S_JOG)
+        {
+            int first = (cmd == VHKX_I_JOG) ? 0 : 1;
+            int stride = (cmd == VHKX_I_JOG) ? 5 : 4;
+
+            for (int i = first; i + 4 <= ndata; i += stride)
+            {
+                // Position control only (bit 1 of the SET byte selects speed control)
+                if (data[i+3] == s.id && (data[i+2] & 0x02) == 0)
+                {
+                    hkxJog(s, make_short_word(data[i], data[i+1]) & 0x7FFF);
+                }
+            }
+        }
+
+        if (s.id != id && broadcast == false)
+        {
+            continue;
+        }
+
+        int ackPolicy = readRegister(s, REG_STATUS_RETURN_LEVEL, REGISTER_RAM);
+        int detail = 0;
+        bool isRead = false;
+        payload.clear();
+
+        switch (cmd)
+        {
+        case VHKX_EEP_READ:
+        case VHKX_RAM_READ:
+            isRead = true;
+            if (ndata >= 2 && hkxRead(s, (cmd == VHKX_RAM_READ), data[0], data[1], payload))
+            {
+                payload.insert(payload.begin(), data[1]);
+                payload.insert(payload.begin(), data[0]);
+            }
+            else
+            {
+                detail = STATBIT_RANGE;
+            }
+            break;
+
+        case VHKX_EEP_WRITE:
+        case VHKX_RAM_WRITE:
+            if (ndata < 3 || data[1] != ndata - 2 || hkxWrite(s, (cmd == VHKX_RAM_WRITE), data[0], data + 2, data[1]) == false)
+            {
+                detail = STATBIT_RANGE;
+            }
+            else
+            {
+                touched.push_back(s.id);
+            }
+            break;
+
+        case VHKX_STAT:
+            isRead = true;
+            break;
+
+        case VHKX_I_JOG:
+        case VHKX_S_JOG:
+            break;
+
+        case VHKX_ROLLBACK:
+        {
+            int model = readRegister(s, REG_MODEL_NUMBER, REGISTER_ROM);
+            int baud = readRegister(s, REG_BAUD_RATE, REGISTER_ROM);
+            bool keepId = (ndata > 0 && data[0] == 1);
+
+            if (keepId == false)
+            {
+                s.id = s.ct[getRegisterTableIndex(s.ct, REG_ID)][5];
+            }
+
+            initRegisters(s);
+            writeRegister(s, REG_MODEL_NUMBER, model);
+
+            if (ndata > 1 && data[1] == 1)
+            {
+                writeRegister(s, REG_BAUD_RATE, baud);
+            }
+
+            touched.push_back(it.first);
+        }
+            break;
+
+        case VHKX_REBOOT:
+            // RAM registers are reloaded from their EEPROM counterparts
+            for (unsigned i = 0; i < getRegisterCount(s.ct); i++)
+            {
+                if (s.ct[i][3] >= 0 && s.ct[i][4] >= 0)
+                {
+                    putValue(s.ram, s.ct[i][4], s.ct[i][1], getValue(s.rom, s.ct[i][3], s.ct[i][1]));
+                }
+            }
+            break;
+
+        default:
+            detail = STATBIT_UNKWOWN_CMD;
+            break;
+        }
+
+        // Broadcast commands are never acknowledged
+        if (broadcast == false &&
+            (ackPolicy >= 2 || (ackPolicy == 1 && isRead)))
+        {
+            hkxStatus(s, cmd, detail, payload, packet);
+            replies.push_back(std::make_pair(servoReturnDelay(s), packet));
+        }
+    }
+
+    for (int touchedId: touched)
+    {
+        updateId(touchedId);
+    }
+}
+
+/* ************************************************************************** */
+
+void VirtualServoBus::process(const unsigned char *data, const int size, ReplyList &replies)
+{
+    std::lock_guard <std::mutex> lock(busLock);
+
+    input.insert(input.end(), data, data + size);
+
+    bool hasDxl1 = false, hasHkx = false;
+    for (auto &it: servos)
+    {
+        hasDxl1 |= (it.second.protocol == PROTOCOL_DXLv1);
+        hasHkx |= (it.second.protocol == PROTOCOL_HKX);
+    }
+
+    size_t replyCount = replies.size();
+
+    while (input.size() >= 4)
+    {
+        // Find packet header
+        if (input[0] != 0xFF || input[1] != 0xFF)
+        {
+            input.erase(input.begin());
+            continue;
+        }
+
+        const int available = static_cast<int>(input.size());
+
+        // Dynamixel protocol v2: FF FF FD 00 ID LEN_L LEN_H INST PARAMS CRC_L CRC_H
+        if (input[2] == 0xFD && input[3] == 0x00)
+        {
+            if (available < 7)
+            {
+                break;
+            }
+
+            int length = make_short_word(input[5], input[6]);
+            int total = 7 + length;
+
+            if (length < 3)
+            {
+                input.erase(input.begin());
+                continue;
+            }
+            if (available < total)
+            {
+                break;
+            }
+
+            unsigned short crc = dxl2_crc(input.data(), total - 2);
+            if (input[total-2] == get_lowbyte(crc) && input[total-1] == get_highbyte(crc))
+            {
+                if (chance(dropRate) == false)
+                {
+                    dxlProcess(PROTOCOL_DXLv2, input[4], input[7], &input[8], length - 3, replies);
+                }
+                input.erase(input.begin(), input.begin() + total);
+            }
+            else
+            {
+                input.erase(input.begin());
+            }
+            continue;
+        }
+
+        // Dynamixel protocol v1 (FF FF ID LEN INST PARAMS CHK) and HerkuleX (FF FF SIZE ID CMD CS1 CS2 DATA)
+        // use the same header, so try both packet layouts.
+        int hkxTotal = input[2];
+        int dxlTotal = input[3] + 4;
+        bool hkxComplete = hasHkx && hkxTotal >= 7 && available >= hkxTotal;
+        bool dxlComplete = hasDxl1 && input[3] >= 2 && available >= dxlTotal;
+
+        if (hkxComplete)
+        {
+            unsigned char cs1 = hkx_checksum1(input.data(), hkxTotal);
+
+            if (input[5] == cs1 && input[6] == ((~cs1) & 0xFE))
+            {
+                if (chance(dropRate) == false)
+                {
+                    hkxProcess(input[3], input[4], &input[7], hkxTotal - 7, replies);
+                }
+                input.erase(input.begin(), input.begin() + hkxTotal);
+                continue;
+            }
+        }
+
+        if (dxlComplete)
+        {
+            unsigned char checksum = 0;
+            for (int i = 2; i < dxlTotal - 1; i++)
+            {
+                checksum += input[i];
+            }
+
+            if (input[dxlTotal-1] == static_cast<unsigned char>(~checksum))
+            {
+                if (chance(dropRate) == false)
+                {
+                    dxlProcess(PROTOCOL_DXLv1, input[2], input[4], &input[5], input[3] - 2, replies);
+                }
+                input.erase(input.begin(), input.begin() + dxlTotal);
+                continue;
+            }
+        }
+
+        // Wait for more bytes if one of the layouts is still incomplete
+        if ((hasHkx && hkxTotal >= 7 && hkxComplete == false) ||
+            (hasDxl1 && input[3] >= 2 && dxlComplete == false))
+        {
+            break;
+        }
+
+        // Invalid packet, resynchronize on the next header
+        input.erase(input.begin());
+    }
+
+    hostBytes += size;
+
+    for (size_t i = replyCount; i < replies.size(); i++)
+    {
+        deviceBytes += replies[i].second.size();
+
+        if (chance(corruptRate))
+        {
+            corruptPacket(replies[i].second);
+        }
+    }
+}
+
+/* ************************************************************************** */
+
+SerialPortVirtual::SerialPortVirtual(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices):
+    SerialPort(serialDevice, servoDevices),
+    lineBusyUntil(0.0)
+{
+    ttyDevicePath = devicePath;
+    ttyDeviceName = virtualBusName(devicePath);
+
+    // No USB adapter in the way
+    ttyDeviceLatencyTime = 1;
+
+    setBaudRate(baud);
+
+    TRACE_INFO(SERIAL, "- Device name has been set to: '%s'", ttyDeviceName.c_str());
+    TRACE_INFO(SERIAL, "- Device node has been set to: '%s'", ttyDevicePath.c_str());
+    TRACE_INFO(SERIAL, "- Device baud rate has been set to: '%i'", ttyDeviceBaudRate);
+}
+
+SerialPortVirtual::~SerialPortVirtual()
+{
+    closeLink();
+}
+
+void SerialPortVirtual::setBaudRate(const int baud)
+{
+    // Get valid baud rate
+    ttyDeviceBaudRate = checkBaudRate(baud);
+
+    // Compute the time needed to transfert one byte through the serial interface
+    // (1000 / baudrate(= bit per msec)) * 10(= start bit + 8 data bit + stop bit)
+    byteTransfertTime = (1000.0 / static_cast<double>(ttyDeviceBaudRate)) * 10.0;
+}
+
+int SerialPortVirtual::openLink()
+{
+    if (ttyDeviceName.empty() || ttyDeviceName == ttyDevicePath)
+    {
+        TRACE_ERROR(SERIAL, "Invalid virtual serial port path: '%s'", ttyDevicePath.c_str());
+        return -1;
+    }
+
+    bus = VirtualServoBus::getBus(ttyDeviceName);
+    rxQueue.clear();
+    lineBusyUntil = 0.0;
+
+    return 1;
+}
+
+bool SerialPortVirtual::isOpen()
+{
+    return (bus != nullptr);
+}
+
+void SerialPortVirtual::closeLink()
+{
+    rxQueue.clear();
+    bus.reset();
+}
+
+std::shared_ptr <VirtualServoBus> SerialPortVirtual::getBus()
+{
+    return bus;
+}
+
+int SerialPortVirtual::tx(unsigned char *packet, int packetLength)
+{
+    if (bus == nullptr || packet == nullptr || packetLength < 1)
+    {
+        return 0;
+    }
+
+    // The link is half duplex: a packet cannot start before the previous transfers are over
+    double now = getTime();
+    double start = (lineBusyUntil > now) ? lineBusyUntil : now;
+    double txEnd = start + byteTransfertTime * static_cast<double>(packetLength);
+
+    std::vector <std::pair <int, std::vector <unsigned char> > > replies;
+    bus->process(packet, packetLength, replies);
+
+    double t = txEnd;
+    for (const auto &r: replies)
+    {
+        t += static_cast<double>(r.first) / 1000.0;
+
+        for (unsigned char b: r.second)
+        {
+            t += byteTransfertTime;
+            rxQueue.push_back({b, t});
+        }
+    }
+
+    lineBusyUntil = t;
+
+    return packetLength;
+}
+
+int SerialPortVirtual::rx(unsigned char *packet, int packetLength)
+{
+    if (bus == nullptr || packet == nullptr || packetLength < 1)
+    {
+        return 0;
+    }
+
+    if (rxBlocking)
+    {
+        // Sleep until the requested bytes are available, or until the timeout
+        double deadline = packetStartTime + packetWaitTime;
+        double wakeup = deadline;
+
+        if (static_cast<int>(rxQueue.size()) >= packetLength && rxQueue[packetLength - 1].availableTime < deadline)
+        {
+            wakeup = rxQueue[packetLength - 1].availableTime;
+        }
+
+        double now = getTime();
+        if (wakeup > now)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(static_cast<long long>((wakeup - now) * 1000.0)));
+        }
+    }
+
+    double now = getTime();
+    int nRead = 0;
+
+    while (nRead < packetLength && rxQueue.empty() == false && rxQueue.front().availableTime <= now)
+    {
+        packet[nRead++] = rxQueue.front().value;
+        rxQueue.pop_front();
+    }
+
+    return nRead;
+}
+
+void SerialPortVirtual::flush()
+{
+    // Bytes still in flight are not received yet, so they are not flushed
+    double now = getTime();
+
+    while (rxQueue.empty() == false && rxQueue.front().availableTime <= now)
+    {
+        rxQueue.pop_front();
+    }
+}
+
+double SerialPortVirtual::getTime()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SerialPortVirtual::setTimeOut(int packetLength)
+{
+    packetStartTime = getTime();
+    packetWaitTime  = (byteTransfertTime * static_cast<double>(packetLength) + 2.0 * static_cast<double>(ttyDeviceLatencyTime));
+}
+
+void SerialPortVirtual::setTimeOut(double msec)
+{
+    packetStartTime = getTime();
+    packetWaitTime  = msec;
+}
+
+int SerialPortVirtual::checkTimeOut()
+{
+    int status = 0;
+    double time_elapsed = getTime() - packetStartTime;
+
+    if (time_elapsed > packetWaitTime)
+    {
+        status = 1;
+    }
+    else if (time_elapsed < 0)
+    {
+        packetStartTime = getTime();
+    }
+
+    return status;
+}
@@ -0,0 +1,260 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file SerialPortVirtual.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef SERIALPORT_VIRTUAL_H
+#define SERIALPORT_VIRTUAL_H
+
+#include "SerialPort.h"
+#include "ControlTables.h"
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+/*!
+ * \brief Device path prefix used to select a virtual serial port instead of a real one (ex: "virtual:bus0").
+ */
+#define VIRTUAL_PORT_PREFIX "virtual:"
+
+/*!
+ * \brief The VirtualServoBus class emulates a bus of Dynamixel and HerkuleX servos.
+ *
+ * Each emulated servo owns a register image, initialized from the framework's
+ * control tables, and answers to instruction packets like a real device would
+ * (ping, read, write, sync/bulk instructions, reset...), following its own
+ * 'status return level' / 'ack policy' register.
+ * Moves are instantaneous: writing a goal position also updates the current position.
+ *
+ * Buses are shared by name, so a test or benchmark can populate a bus before
+ * a controller connects to it with the "virtual:<name>" device path.
+ */
+class VirtualServoBus
+{
+    struct VirtualServo
+    {
+        int id = 0;
+        int protocol = PROTOCOL_DXLv1;          //!< PROTOCOL_DXLv1, PROTOCOL_DXLv2 or PROTOCOL_HKX.
+        int servoSerie = SERVO_UNKNOWN;
+        int servoModel = SERVO_UNKNOWN;
+        const int (*ct)[8] = nullptr;           //!< The control table of this device.
+        std::vector <unsigned char> rom;        //!< Register image. Dynamixel devices only use this one.
+        std::vector <unsigned char> ram;        //!< RAM register image (HerkuleX only).
+        std::vector <unsigned char> regWrite;   //!< Pending REG_WRITE instruction ([addr L, addr H, data...]).
+        int errorBits = 0;                      //!< Injected error bits, reported in every status packet.
+    };
+
+    std::map <int, VirtualServo> servos;        //!< Emulated servos, indexed by ID.
+    std::vector <unsigned char> input;          //!< Received bytes, not parsed yet.
+
+    int returnDelay = -1;                       //!< Return delay (in microseconds), or -1 to use each servo 'return delay' register.
+    int pingSlot = 3000;                        //!< Time slot (in microseconds) of each ID answering a protocol v2 broadcast 'Ping'.
+    double dropRate = 0.0;                      //!< Probability of an instruction packet to be lost.
+    double corruptRate = 0.0;                   //!< Probability of a status packet to be corrupted.
+    std::mt19937 rng;
+
+    unsigned long long hostBytes = 0;           //!< Number of bytes sent by the host.
+    unsigned long long deviceBytes = 0;         //!< Number of bytes sent by the emulated devices.
+
+    std::mutex busLock;                         //!< Protects every member of this bus.
+
+    void initRegisters(VirtualServo &s);
+    void writeRegister(VirtualServo &s, const int reg_name, const int value);
+    int readRegister(VirtualServo &s, const int reg_name, const int reg_type = REGISTER_AUTO);
+
+    //! Move a servo to its new key in 'servos', if its ID register has been modified.
+    void updateId(const int oldId);
+
+    bool chance(const double rate);
+    void corruptPacket(std::vector <unsigned char> &packet);
+
+    int servoReturnDelay(VirtualServo &s);
+
+    // Dynamixel
+    bool dxlRead(VirtualServo &s, const int addr, const int len, std::vector <unsigned char> &data);
+    bool dxlWrite(VirtualServo &s, const int addr, const unsigned char *data, const int len);
+    void dxlStatus(VirtualServo &s, const int error, const std::vector <unsigned char> &params, std::vector <unsigned char> &out);
+    int dxlStatusLevel(VirtualServo &s);
+    void dxlProcess(const int protocol, const int id, const int inst, const unsigned char *params, const int nparams,
+                    std::vector <std::pair <int, std::vector <unsigned char> > > &replies);
+
+    // HerkuleX
+    bool hkxRead(VirtualServo &s, const bool ram, const int addr, const int len, std::vector <unsigned char> &data);
+    bool hkxWrite(VirtualServo &s, const bool ram, const int addr, const unsigned char *data, const int len);
+    void hkxStatus(VirtualServo &s, const int cmd, const int statusDetail, const std::vector <unsigned char> &data, std::vector <unsigned char> &out);
+    void hkxJog(VirtualServo &s, const int position);
+    void hkxProcess(const int id, const int cmd, const unsigned char *data, const int ndata,
+                    std::vector <std::pair <int, std::vector <unsigned char> > > &replies);
+
+public:
+    VirtualServoBus();
+    ~VirtualServoBus();
+
+    /*!
+     * \brief Get a virtual bus by name, create it if needed.
+     * \param name: The bus name, with or without the "virtual:" prefix.
+     * \return A shared pointer to the bus.
+     */
+    static std::shared_ptr <VirtualServoBus> getBus(const std::string &name);
+
+    /*!
+     * \brief Forget a virtual bus. Ports still connected to it keep it alive until they are closed.
+     * \param name: The bus name, with or without the "virtual:" prefix.
+     */
+    static void removeBus(const std::string &name);
+
+    /*!
+     * \brief Add a Dynamixel servo to the bus.
+     * \param id: The servo ID.
+     * \param model_number: A model number, as reported by a real device (ex: 12 for an AX-12A).
+     * \param protocol: The Dynamixel communication protocol used by this servo (PROTOCOL_DXLv1 or PROTOCOL_DXLv2).
+     * \return true if the servo has been added.
+     */
+    bool addDynamixel(const int id, const int model_number, const int protocol = PROTOCOL_DXLv1);
+
+    /*!
+     * \brief Add a HerkuleX servo to the bus.
+     * \param id: The servo ID.
+     * \param model_number: A model number, as reported by a real device (ex: 0x0101 for a DRS-0101).
+     * \return true if the servo has been added.
+     */
+    bool addHerkuleX(const int id, const int model_number);
+
+    /*!
+     * \brief Remove a servo from the bus.
+     * \param id: The servo ID.
+     */
+    void removeServo(const int id);
+
+    /*!
+     * \brief Set the delay between the end of an instruction packet and the beginning of its status packet.
+     * \param usec: Delay in microseconds, or -1 to use the 'return delay time' register of each servo.
+     *
+     * A forced delay is also written into the 'return delay time' register of
+     * the servos already on the bus, so controllers read a matching value.
+     */
+    void setReturnDelay(const int usec);
+
+    /*!
+     * \brief Set the time slot of each ID answering a protocol v2 broadcast 'Ping'.
+     * \param usec: Slot duration in microseconds (default 3000). Devices answer in ID order, waiting for the slots of every lower ID, used or not.
+     */
+    void setPingSlot(const int usec);
+
+    /*!
+     * \brief Inject communication errors.
+     * \param drop: Probability [0;1] of an instruction packet to be ignored by the servos.
+     * \param corrupt: Probability [0;1] of a status packet to be corrupted.
+     */
+    void setErrorRates(const double drop, const double corrupt);
+
+    /*!
+     * \brief Inject servo errors.
+     * \param id: The servo ID.
+     * \param errorBits: Error bits to report in status packets. Use ERRBIT1_* or ERRBIT2_* codes for Dynamixel, ERRBIT_* for HerkuleX.
+     */
+    void setServoError(const int id, const int errorBits);
+
+    /*!
+     * \brief Get the amount of traffic on the bus since its creation, or since the last resetTraffic().
+     * \param[out] host: Number of bytes sent by the host.
+     * \param[out] devices: Number of bytes sent by the emulated devices.
+     */
+    void getTraffic(unsigned long long &host, unsigned long long &devices);
+
+    /*!
+     * \brief Reset the traffic counters.
+     */
+    void resetTraffic();
+
+    /*!
+     * \brief Feed the bus with bytes sent by the host.
+     * \param data: Bytes sent.
+     * \param size: Number of bytes sent.
+     * \param[out] replies: Status packets generated, each with the return delay (in microseconds) applied before it.
+     *
+     * Bytes are parsed as a stream, so several instruction packets can be sent at once.
+     */
+    void process(const unsigned char *data, const int size,
+                 std::vector <std::pair <int, std::vector <unsigned char> > > &replies);
+};
+
+/*!
+ * \brief The SerialPortVirtual class connects the framework to a VirtualServoBus.
+ *
+ * Open it with a "virtual:<name>" device path: the Dynamixel and HerkuleX
+ * classes (and so the controllers and SimpleAPIs) will pick this backend
+ * automatically. Status bytes are made available following the time needed
+ * to transfer them at the configured baudrate, plus the servo return delay,
+ * so timings measured against a virtual bus are close to the real ones.
+ */
+class SerialPortVirtual: public SerialPort
+{
+    struct PendingByte
+    {
+        unsigned char value;
+        double availableTime;   //!< Time (in millisecond) when this byte is completely received.
+    };
+
+    std::shared_ptr <VirtualServoBus> bus;
+    std::deque <PendingByte> rxQueue;   //!< Status bytes "in flight" on the virtual link.
+    double lineBusyUntil;               //!< Time (in millisecond) when the half duplex link becomes idle.
+
+    /*!
+     * \brief Get current time from a monotonic clock.
+     * \return Current time in milliseconds.
+     */
+    double getTime();
+
+    /*!
+     * \brief Set baudrate for this interface.
+     * \param baud: Can be a 'baudrate' (in bps) or a Dynamixel / HerkuleX 'baudnum'.
+     */
+    void setBaudRate(const int baud);
+
+public:
+    SerialPortVirtual(std::string &devicePath, const int baud, const int serialDevice, const int servoDevices);
+    ~SerialPortVirtual();
+
+    int openLink();
+    bool isOpen();
+    void closeLink();
+
+    int tx(unsigned char *packet, int packetLength);
+    int rx(unsigned char *packet, int packetLength);
+    void flush();
+
+    void setTimeOut(int packetLength);
+    void setTimeOut(double msec);
+    int checkTimeOut();
+
+    /*!
+     * \brief Get the virtual bus this port is connected to.
+     * \return A shared pointer to the bus, or nullptr if the port is closed.
+     */
+    std::shared_ptr <VirtualServoBus> getBus();
+};
+
+#endif // SERIALPORT_VIRTUAL_H
@@ -79,6 +79,22 @@ int Servo::gaddr(const int reg, const int reg_mode)
     return getRegisterAddr(ct, reg, reg_mode);
 }
 
+void Servo::setDirty(const int reg_index, const bool dirty)
+{
+    if (reg_index >= 0 && reg_index < MAX_REGISTER_COUNT)
+    {
+        if (dirty)
+            dirtyRegisters.fetch_or(1ULL << reg_index);
+        else
+            dirtyRegisters.fetch_and(~(1ULL << reg_index));
+    }
+}
+
+uint64_t Servo::getDirtyRegisters()
+{
+    return dirtyRegisters.load();
+}
+
 /* ************************************************************************** */
 
 int Servo::getStatus()
@@ -174,6 +190,13 @@ void Servo::getActions(int &action, int &reboot, int &refresh, int &reset)
     refreshProgrammed = 0;
 }
 
+bool Servo::hasActions()
+{
+    std::lock_guard <std::mutex> lock(access);
+
+    return (actionProgrammed != 0 || rebootProgrammed != 0 || resetProgrammed != 0 || refreshProgrammed != 0);
+}
+
 int Servo::changeInternalId(int newId)
 {
     int retcode = 0;
@@ -350,6 +373,7 @@ void Servo::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        setDirty(gid(REG_ID), true);
     }
 }
 
@@ -363,6 +387,7 @@ void Servo::setCWLimit(int limit)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        setDirty(gid(REG_MIN_POSITION), true);
     }
 }
 
@@ -376,6 +401,7 @@ void Servo::setCCWLimit(int limit)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        setDirty(gid(REG_MAX_POSITION), true);
     }
 }
 
@@ -387,7 +413,7 @@ int Servo::getValue(int reg_name, int reg_type)
 
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -417,7 +443,7 @@ int Servo::getValueCommit(int reg_name, int reg_type)
 
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -447,7 +473,7 @@ void Servo::setValue(int reg_name, int reg_value, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -462,6 +488,7 @@ void Servo::setValue(int reg_name, int reg_value, int reg_type)
                     // Set value
                     registerTableValues[infos.reg_index] = reg_value;
                     registerTableCommits[infos.reg_index] = 1;
+                    setDirty(infos.reg_index, true);
                 }
                 else
                 {
@@ -493,7 +520,7 @@ void Servo::updateValue(int reg_name, int reg_value, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -535,7 +562,7 @@ void Servo::commitValue(int reg_name, int commit, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -551,6 +578,7 @@ void Servo::commitValue(int reg_name, int commit, int reg_type)
 
                 // Set value
                 registerTableCommits[infos.reg_index] = commit;
+                setDirty(infos.reg_index, commit != 0);
             }
             else
             {
@@ -572,3 +600,91 @@ void Servo::commitValue(int reg_name, int commit, int reg_type)
 }
 
 /* ************************************************************************** */
+
+RegisterHandle Servo::handle(const int reg_name, const int reg_type)
+{
+    RegisterHandle h;
+
+    // Find register's informations (addr, size...)
+    RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1 && infos.reg_index >= 0)
+    {
+        h.owner = this;
+        h.reg_name = reg_name;
+        h.reg_index = infos.reg_index;
+        h.reg_access_mode = infos.reg_access_mode;
+        h.reg_value_min = infos.reg_value_min;
+        h.reg_value_max = infos.reg_value_max;
+        h.values[0] = &registerTableValues[infos.reg_index];
+        h.commits[0] = &registerTableCommits[infos.reg_index];
+    }
+    else
+    {
+        TRACE_ERROR(SERVO, "[#%i] handle(reg %i / %s) [REGISTER NAME ERROR]",
+                    servoId, reg_name, getRegisterNameTxt(reg_name).c_str());
+    }
+
+    return h;
+}
+
+int Servo::get(const RegisterHandle &h)
+{
+    int value = -1;
+
+    if (h.isValid() && h.owner == this)
+    {
+        std::lock_guard <std::mutex> lock(access);
+
+        // Get value
+        value = *h.values[0];
+    }
+    else
+    {
+        TRACE_ERROR(SERVO, "[#%i] get(reg %i / %s) [REGISTER HANDLE ERROR]",
+                    servoId, h.reg_name, getRegisterNameTxt(h.reg_name).c_str());
+    }
+
+    return value;
+}
+
+void Servo::set(const RegisterHandle &h, const int value)
+{
+    if (h.isValid() && h.owner == this)
+    {
+        // Check if we have permission to write into this register
+        if (h.reg_access_mode == READ_WRITE)
+        {
+            // Check value
+            if (value >= h.reg_value_min && value <= h.reg_value_max)
+            {
+                std::lock_guard <std::mutex> lock(access);
+
+                // Set value(s)
+                for (int i = 0; i < 2 && h.values[i] != nullptr; i++)
+                {
+                    *h.values[i] = value;
+                    *h.commits[i] = 1;
+                }
+                setDirty(h.reg_index, true);
+            }
+            else
+            {
+                TRACE_ERROR(SERVO, "[#%i] set(reg %i / %s to %i) [REGISTER VALUE ERROR] (min: %i / max: %i)",
+                            servoId, h.reg_name, getRegisterNameTxt(h.reg_name).c_str(),
+                            value, h.reg_value_min, h.reg_value_max);
+            }
+        }
+        else
+        {
+            TRACE_ERROR(SERVO, "[#%i] set(reg %i / %s) [REGISTER ACCESS ERROR]",
+                        servoId, h.reg_name, getRegisterNameTxt(h.reg_name).c_str());
+        }
+    }
+    else
+    {
+        TRACE_ERROR(SERVO, "[#%i] set(reg %i / %s) [REGISTER HANDLE ERROR]",
+                    servoId, h.reg_name, getRegisterNameTxt(h.reg_name).c_str());
+    }
+}
+
+/* ************************************************************************** */
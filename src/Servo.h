@@ -25,6 +25,8 @@
 
 #include "ControlTables.h"
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <map>
 #include <mutex>
@@ -44,6 +46,30 @@ enum SpeedMode_e {
     SPEED_AUTO   = 1
 };
 
+class Servo;
+
+/*!
+ * \brief A register handle, resolved once with Servo::handle().
+ *
+ * The handle caches the register location into the servo tables and its
+ * validation data, so Servo::get() and Servo::set() don't need any register
+ * lookup. A handle is only valid with the servo that created it, during the
+ * lifetime of this servo.
+ */
+struct RegisterHandle
+{
+    const Servo *owner = nullptr;   //!< The servo that created this handle
+    int reg_name = -1;              //!< Register name, using '::RegisterNames_e' enum
+    int reg_index = -1;             //!< Register index in the servo control table
+    int reg_access_mode = READ_ONLY;
+    int reg_value_min = 0;
+    int reg_value_max = 0;
+    int *values[2] = {nullptr, nullptr};    //!< Register value(s). Dual value (ROM/RAM) registers use both slots, 'get' reads the first one.
+    int *commits[2] = {nullptr, nullptr};   //!< Register commit flag(s), matching 'values'
+
+    bool isValid() const { return (owner != nullptr && values[0] != nullptr); }
+};
+
 /*!
  * \brief The "Servo" device base class.
  */
@@ -53,10 +79,19 @@ protected:
     std::mutex access;              //!< Lock servo to avoid concurrent use by controller and user
 
     const int (*ct)[8] = nullptr;   //!< Pointer to the control table for a given servo class (selected by the constructor)
+    const ControlTableIndex *ctIndex = nullptr; //!< Register index of the control table, for constant time register lookups
 
     int registerTableSize = 0;      //!< Number of register in the servo control table
     int *registerTableValues = nullptr;
     int *registerTableCommits = nullptr;
+    std::atomic <uint64_t> dirtyRegisters{0}; //!< One bit per register index with a pending commit, so controllers don't have to scan every commit flag
+
+    /*!
+     * \brief Set or clear the dirty bit of a register. Must be called every time a commit flag is modified.
+     * \param reg_index: The register index in the control table.
+     * \param dirty: true if the register has a pending commit.
+     */
+    void setDirty(const int reg_index, const bool dirty);
 
     int servoId = 0;
     int servoModel = 0;
@@ -86,6 +121,12 @@ public:
     int gid(const int reg);
     int gaddr(const int reg, const int reg_mode = REGISTER_AUTO);
 
+    /*!
+     * \brief Get the registers with a pending commit.
+     * \return A bitmask of register indexes (bit 'n' set if the register at index 'n' of the control table has to be written).
+     */
+    uint64_t getDirtyRegisters();
+
     // Device
     virtual void status();
     virtual std::string getModelString() = 0;
@@ -108,6 +149,7 @@ public:
     void reset(int setting);
     void refresh();
     void getActions(int &action, int &reboot, int &refresh, int &reset);
+    bool hasActions();              //!< Check for programmed actions, without consuming them like getActions() does
 
     // Helpers
     int changeInternalId(int newId);
@@ -162,6 +204,11 @@ public:
     virtual void setValue(const int reg_reg, int reg_value, int reg_type = REGISTER_AUTO);
     virtual void updateValue(const int reg_reg, int reg_value, int reg_type = REGISTER_AUTO);
     virtual void commitValue(const int reg_reg, int commit, int reg_type = REGISTER_AUTO);
+
+    // Register handles (resolve a register once, then access it without lookup)
+    virtual RegisterHandle handle(const int reg_name, const int reg_type = REGISTER_AUTO);
+    int get(const RegisterHandle &h);
+    void set(const RegisterHandle &h, const int value);
 };
 
 /** @}*/
@@ -47,14 +47,9 @@ ServoDynamixel::ServoDynamixel(const int control_table[][8], int dynamixel_id, i
         ct = MX_control_table;
     }
 
-    // Register count // FIXME // Horrible hack!
-    for (registerTableSize = 0; registerTableSize < 64; registerTableSize++)
-    {
-        if (ct[registerTableSize][0] == 999) // end of table
-        {
-            break;
-        }
-    }
+    // Index the control table
+    ctIndex = getControlTableIndex(ct);
+    registerTableSize = ctIndex->reg_count;
 
     // Init register tables (value and commit info) with value-initialization
     registerTableValues = new int [registerTableSize]();
@@ -326,6 +321,7 @@ void ServoDynamixel::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        setDirty(gid(REG_ID), true);
     }
 }
 
@@ -339,6 +335,7 @@ void ServoDynamixel::setCWLimit(int limit)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        setDirty(gid(REG_MIN_POSITION), true);
     }
 }
 
@@ -352,6 +349,7 @@ void ServoDynamixel::setCCWLimit(int limit)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        setDirty(gid(REG_MAX_POSITION), true);
     }
 }
 
@@ -376,6 +374,7 @@ void ServoDynamixel::setGoalPosition(int pos)
         // Set position
         registerTableValues[gid(REG_GOAL_POSITION)] = pos;
         registerTableCommits[gid(REG_GOAL_POSITION)] = 1;
+        setDirty(gid(REG_GOAL_POSITION), true);
     }
     else
     {
@@ -419,9 +418,11 @@ void ServoDynamixel::setGoalPosition(int pos, int time_budget_ms)
             // Set position and speed
             registerTableValues[gid(REG_GOAL_POSITION)] = pos;
             registerTableCommits[gid(REG_GOAL_POSITION)] = 1;
+            setDirty(gid(REG_GOAL_POSITION), true);
 
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            setDirty(gid(REG_GOAL_SPEED), true);
         }
         else
         {
@@ -468,6 +469,7 @@ void ServoDynamixel::setMovingSpeed(int speed)
         {
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            setDirty(gid(REG_GOAL_SPEED), true);
         }
     }
     else
@@ -476,6 +478,7 @@ void ServoDynamixel::setMovingSpeed(int speed)
         {
             registerTableValues[gid(REG_GOAL_SPEED)] = speed;
             registerTableCommits[gid(REG_GOAL_SPEED)] = 1;
+            setDirty(gid(REG_GOAL_SPEED), true);
         }
     }
 }
@@ -490,6 +493,7 @@ void ServoDynamixel::setMaxTorque(int torque)
 
         registerTableValues[gid(REG_MAX_TORQUE)] = torque;
         registerTableCommits[gid(REG_MAX_TORQUE)] = 1;
+        setDirty(gid(REG_MAX_TORQUE), true);
     }
 }
 
@@ -511,6 +515,7 @@ void ServoDynamixel::setLed(int led)
 
     registerTableValues[gid(REG_LED)] = led;
     registerTableCommits[gid(REG_LED)] = 1;
+    setDirty(gid(REG_LED), true);
 }
 
 void ServoDynamixel::setTorqueEnabled(int torque)
@@ -524,4 +529,5 @@ void ServoDynamixel::setTorqueEnabled(int torque)
 
     registerTableValues[gid(REG_TORQUE_ENABLE)] = torque;
     registerTableCommits[gid(REG_TORQUE_ENABLE)] = 1;
+    setDirty(gid(REG_TORQUE_ENABLE), true);
 }
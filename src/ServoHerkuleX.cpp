@@ -46,14 +46,9 @@ ServoHerkuleX::ServoHerkuleX(const int control_table[][8], int herkulex_id, int
         ct = DRS0101_control_table;
     }
 
-    // Register count // FIXME // Horrible hack!
-    for (registerTableSize = 0; registerTableSize < 64; registerTableSize++)
-    {
-        if (ct[registerTableSize][0] == 999) // end of table
-        {
-            break;
-        }
-    }
+    // Index the control table
+    ctIndex = getControlTableIndex(ct);
+    registerTableSize = ctIndex->reg_count;
 
     // Init register tables (value and commit info) with value-initialization
     registerTableValues = new int [registerTableSize]();
@@ -426,6 +421,7 @@ void ServoHerkuleX::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        setDirty(gid(REG_ID), true);
     }
 }
 
@@ -439,6 +435,7 @@ void ServoHerkuleX::setCWLimit(int limit, const int reg_type)
 
         registerTableValues[gid(REG_MIN_POSITION)] = limit;
         registerTableCommits[gid(REG_MIN_POSITION)] = 1;
+        setDirty(gid(REG_MIN_POSITION), true);
     }
 }
 
@@ -452,6 +449,7 @@ void ServoHerkuleX::setCCWLimit(int limit, const int reg_type)
 
         registerTableValues[gid(REG_MAX_POSITION)] = limit;
         registerTableCommits[gid(REG_MAX_POSITION)] = 1;
+        setDirty(gid(REG_MAX_POSITION), true);
     }
 }
 
@@ -501,6 +499,7 @@ void ServoHerkuleX::setLed(int led)
 
     registerTableValuesRAM[gid(REG_LED)] = color;
     registerTableCommitsRAM[gid(REG_LED)] = 1;
+    setDirty(gid(REG_LED), true);
 }
 
 void ServoHerkuleX::setTorqueEnabled(int torque)
@@ -520,6 +519,7 @@ void ServoHerkuleX::setTorqueEnabled(int torque)
 
         registerTableValuesRAM[gid(REG_TORQUE_ENABLE)] = torque;
         registerTableCommitsRAM[gid(REG_TORQUE_ENABLE)] = 1;
+        setDirty(gid(REG_TORQUE_ENABLE), true);
     }
     else
     {
@@ -606,7 +606,7 @@ int ServoHerkuleX::getValue(int reg_name, int reg_type)
 
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -647,7 +647,7 @@ int ServoHerkuleX::getValueCommit(int reg_name, int reg_type)
 
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -692,7 +692,7 @@ void ServoHerkuleX::setValue(int reg_name, int reg_value, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -719,12 +719,14 @@ void ServoHerkuleX::setValue(int reg_name, int reg_value, int reg_type)
                     {
                         registerTableValues[infos.reg_index] = reg_value;
                         registerTableCommits[infos.reg_index] = 1;
+                        setDirty(infos.reg_index, true);
                     }
 
                     if (reg_type == REGISTER_RAM || reg_type == REGISTER_BOTH)
                     {
                         registerTableValuesRAM[infos.reg_index] = reg_value;
                         registerTableCommitsRAM[infos.reg_index] = 1;
+                        setDirty(infos.reg_index, true);
                     }
                 }
                 else
@@ -753,7 +755,7 @@ void ServoHerkuleX::updateValue(int reg_name, int reg_value, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -811,7 +813,7 @@ void ServoHerkuleX::commitValue(int reg_name, int commit, int reg_type)
 {
     // Find register's informations (addr, size...)
     RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
-    if (getRegisterInfos(ct, reg_name, infos) == 1)
+    if (getRegisterInfos(ctIndex, reg_name, infos) == 1)
     {
         if (infos.reg_index >= 0)
         {
@@ -845,6 +847,9 @@ void ServoHerkuleX::commitValue(int reg_name, int commit, int reg_type)
                 {
                     registerTableCommits[infos.reg_index] = commit;
                 }
+
+                setDirty(infos.reg_index, (registerTableCommits[infos.reg_index] != 0 ||
+                                           registerTableCommitsRAM[infos.reg_index] != 0));
             }
             else
             {
@@ -861,3 +866,38 @@ void ServoHerkuleX::commitValue(int reg_name, int commit, int reg_type)
         TRACE_ERROR(HKX, "[#%i] commitValue(reg %i / %s) [REGISTER NAME ERROR]", servoId, reg_name, getRegisterNameTxt(reg_name).c_str());
     }
 }
+
+RegisterHandle ServoHerkuleX::handle(const int reg_name, const int reg_type)
+{
+    RegisterHandle h = Servo::handle(reg_name, reg_type);
+
+    RegisterInfos infos = {-1, -1, -1, -1, -1, -1, -1, -1, -1};
+    if (h.isValid() && getRegisterInfos(ctIndex, reg_name, infos) == 1)
+    {
+        int type = reg_type;
+
+        if (type == REGISTER_AUTO)
+        {
+            if (infos.reg_addr_rom >= 0 && infos.reg_addr_ram >= 0)
+                type = REGISTER_BOTH;
+            else if (infos.reg_addr_rom >= 0)
+                type = REGISTER_ROM;
+            else if (infos.reg_addr_ram >= 0)
+                type = REGISTER_RAM;
+        }
+
+        // RAM value first, so 'get' reads the RAM value of dual value registers (like getValue() does)
+        if (type == REGISTER_RAM || type == REGISTER_BOTH)
+        {
+            h.values[0] = &registerTableValuesRAM[infos.reg_index];
+            h.commits[0] = &registerTableCommitsRAM[infos.reg_index];
+        }
+        if (type == REGISTER_BOTH)
+        {
+            h.values[1] = &registerTableValues[infos.reg_index];
+            h.commits[1] = &registerTableCommits[infos.reg_index];
+        }
+    }
+
+    return h;
+}
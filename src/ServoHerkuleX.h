@@ -124,6 +124,8 @@ public:
     void setValue(const int reg, int value, int reg_type = REGISTER_AUTO);
     void updateValue(const int reg, int value, int reg_type = REGISTER_AUTO);
     void commitValue(const int reg, int commit, int reg_type = REGISTER_AUTO);
+
+    RegisterHandle handle(const int reg_name, const int reg_type = REGISTER_AUTO);
 };
 
 /** @}*/
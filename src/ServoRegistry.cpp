@@ -0,0 +1,213 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file ServoRegistry.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+
+#include "ServoRegistry.h"
+#include "Servo.h"
+#include "minitraces.h"
+
+// C++ standard libraries
+#include <algorithm>
+
+/* ************************************************************************** */
+
+ServoRegistry::ServoRegistry()
+{
+    for (int i = 0; i < SERVO_REGISTRY_SLOTS; i++)
+    {
+        slots[i] = nullptr;
+        flags[i] = 0;
+    }
+}
+
+void ServoRegistry::removeFrom(std::vector <Servo *> &list, Servo *servo)
+{
+    list.erase(std::remove(list.begin(), list.end(), servo), list.end());
+}
+
+/* ************************************************************************** */
+
+bool ServoRegistry::add(Servo *servo)
+{
+    if (servo == nullptr)
+    {
+        return false;
+    }
+
+    int id = servo->getId();
+
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS || slots[id] != nullptr)
+    {
+        return false;
+    }
+
+    slots[id] = servo;
+    servos.push_back(servo);
+
+    flags[id] = 0;
+    setSync(id, true);
+    setUpdate(id, true);
+
+    return true;
+}
+
+Servo *ServoRegistry::remove(const int id)
+{
+    Servo *servo = get(id);
+
+    if (servo != nullptr)
+    {
+        removeFrom(servos, servo);
+        removeFrom(syncServos, servo);
+        removeFrom(updateServos, servo);
+
+        slots[id] = nullptr;
+        flags[id] = 0;
+        revision++;
+    }
+
+    return servo;
+}
+
+void ServoRegistry::clear()
+{
+    for (int i = 0; i < SERVO_REGISTRY_SLOTS; i++)
+    {
+        slots[i] = nullptr;
+        flags[i] = 0;
+    }
+
+    servos.clear();
+    syncServos.clear();
+    updateServos.clear();
+    revision++;
+}
+
+/* ************************************************************************** */
+
+Servo *ServoRegistry::get(const int id) const
+{
+    if (id < 0 || id >= SERVO_REGISTRY_SLOTS)
+    {
+        return nullptr;
+    }
+
+    return slots[id];
+}
+
+bool ServoRegistry::empty() const
+{
+    return servos.empty();
+}
+
+const std::vector <Servo *> &ServoRegistry::getServos() const
+{
+    return servos;
+}
+
+const std::vector <Servo *> &ServoRegistry::getSyncServos() const
+{
+    return syncServos;
+}
+
+const std::vector <Servo *> &ServoRegistry::getUpdateServos() const
+{
+    return updateServos;
+}
+
+unsigned ServoRegistry::getRevision() const
+{
+    return revision;
+}
+
+/* ************************************************************************** */
+
+void ServoRegistry::setSync(const int id, const bool sync)
+{
+    Servo *servo = get(id);
+
+    if (servo != nullptr && sync != ((flags[id] & FLAG_SYNC) != 0))
+    {
+        if (sync)
+        {
+            flags[id] |= FLAG_SYNC;
+            syncServos.push_back(servo);
+        }
+        else
+        {
+            flags[id] &= ~FLAG_SYNC;
+            removeFrom(syncServos, servo);
+        }
+
+        revision++;
+    }
+}
+
+void ServoRegistry::setUpdate(const int id, const bool update)
+{
+    Servo *servo = get(id);
+
+    if (servo != nullptr && update != ((flags[id] & FLAG_UPDATE) != 0))
+    {
+        if (update)
+        {
+            flags[id] |= FLAG_UPDATE;
+            updateServos.push_back(servo);
+        }
+        else
+        {
+            flags[id] &= ~FLAG_UPDATE;
+            removeFrom(updateServos, servo);
+        }
+    }
+}
+
+bool ServoRegistry::changeId(const int old_id)
+{
+    Servo *servo = get(old_id);
+
+    if (servo != nullptr)
+    {
+        int new_id = servo->getId();
+
+        if (new_id == old_id)
+        {
+            return true;
+        }
+
+        if (new_id < 0 || new_id >= SERVO_REGISTRY_SLOTS || slots[new_id] != nullptr)
+        {
+            TRACE_ERROR(CAPI, "Unable to move servo #%i to slot #%i: slot already in use!", old_id, new_id);
+            return false;
+        }
+
+        slots[new_id] = servo;
+        flags[new_id] = flags[old_id];
+        slots[old_id] = nullptr;
+        flags[old_id] = 0;
+        revision++;
+
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,132 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file ServoRegistry.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+
+#ifndef SERVO_REGISTRY_H
+#define SERVO_REGISTRY_H
+
+#include <vector>
+
+class Servo;
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+//! Number of slots of a servo registry, one per possible device ID.
+#define SERVO_REGISTRY_SLOTS    256
+
+/*!
+ * \brief The ServoRegistry class.
+ *
+ * The devices managed by a controller, indexed by ID so lookups are done in
+ * constant time. Compact lists keep the devices to synchronize and the devices
+ * waiting for a full register update, so a controller cycle over N devices
+ * costs O(N).
+ *
+ * The registry is not thread safe: controllers protect it with their own lock.
+ */
+class ServoRegistry
+{
+    enum RegistryFlags_e
+    {
+        FLAG_SYNC   = 1 << 0,
+        FLAG_UPDATE = 1 << 1,
+    };
+
+    Servo *slots[SERVO_REGISTRY_SLOTS];         //!< Registered devices, indexed by ID.
+    int flags[SERVO_REGISTRY_SLOTS];            //!< 'RegistryFlags_e' of every slot.
+
+    std::vector <Servo *> servos;               //!< Registered devices, in registration order.
+    std::vector <Servo *> syncServos;           //!< Devices to keep in sync, in registration order.
+    std::vector <Servo *> updateServos;         //!< Devices marked for a "full" register update.
+
+    unsigned revision = 0;                      //!< Incremented every time the synchronization list (or an ID inside it) changes.
+
+    static void removeFrom(std::vector <Servo *> &list, Servo *servo);
+
+public:
+    ServoRegistry();
+
+    /*!
+     * \brief Register a device, and mark it for an initial read and synchronization.
+     * \param servo: The device to register.
+     * \return false if the ID is invalid or already registered.
+     */
+    bool add(Servo *servo);
+
+    /*!
+     * \brief Unregister the device using a given ID. The device object is not deleted.
+     * \param id: The device ID.
+     * \return The device unregistered, or nullptr if the ID wasn't registered.
+     */
+    Servo *remove(const int id);
+
+    /*!
+     * \brief Unregister every device. The device objects are not deleted.
+     */
+    void clear();
+
+    /*!
+     * \brief Get the device using a given ID.
+     * \param id: The device ID.
+     * \return The device, or nullptr if the ID isn't registered.
+     */
+    Servo *get(const int id) const;
+
+    bool empty() const;
+
+    const std::vector <Servo *> &getServos() const;
+    const std::vector <Servo *> &getSyncServos() const;
+    const std::vector <Servo *> &getUpdateServos() const;
+
+    /*!
+     * \brief Get the revision of the synchronization list.
+     * \return A counter incremented every time a device is added to or removed from the synchronization list, or changes its ID.
+     */
+    unsigned getRevision() const;
+
+    /*!
+     * \brief Add or remove a registered device from the synchronization list.
+     * \param id: The device ID.
+     * \param sync: true to keep this device in sync.
+     */
+    void setSync(const int id, const bool sync);
+
+    /*!
+     * \brief Add or remove a registered device from the "full" register update list.
+     * \param id: The device ID.
+     * \param update: true to read every register of this device during the next cycle.
+     */
+    void setUpdate(const int id, const bool update);
+
+    /*!
+     * \brief Move a device to its new slot, after its ID has been modified.
+     * \param old_id: The previous device ID.
+     * \return false if the new ID is invalid or already in use (the device is then left in its previous slot).
+     */
+    bool changeId(const int old_id);
+};
+
+/** @}*/
+
+#endif // SERVO_REGISTRY_H
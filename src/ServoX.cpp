@@ -109,6 +109,7 @@ void ServoX::setId(int id)
         // Maybe check if new ID is not already in use ?
         registerTableValues[gid(REG_ID)] = id;
         registerTableCommits[gid(REG_ID)] = 1;
+        setDirty(gid(REG_ID), true);
     }
 }
 
@@ -0,0 +1,173 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file TimingHistogram.cpp
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#include "TimingHistogram.h"
+
+// C standard library
+#include <cmath>
+
+/* ************************************************************************** */
+
+TimingHistogram::TimingHistogram()
+{
+    clear();
+}
+
+void TimingHistogram::add(const double usec)
+{
+    int index = 0;
+
+    if (usec >= 1.0)
+    {
+        index = 1 + static_cast<int>(std::log2(usec) * TIMING_HISTOGRAM_RESOLUTION);
+        if (index > TIMING_HISTOGRAM_BUCKETS - 1)
+        {
+            index = TIMING_HISTOGRAM_BUCKETS - 1;
+        }
+    }
+
+    buckets[index]++;
+
+    if (count == 0 || usec < min)
+    {
+        min = usec;
+    }
+    if (count == 0 || usec > max)
+    {
+        max = usec;
+    }
+
+    count++;
+    sum += usec;
+}
+
+void TimingHistogram::merge(const TimingHistogram &other)
+{
+    if (other.count == 0)
+    {
+        return;
+    }
+
+    for (int i = 0; i < TIMING_HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] += other.buckets[i];
+    }
+
+    if (count == 0 || other.min < min)
+    {
+        min = other.min;
+    }
+    if (count == 0 || other.max > max)
+    {
+        max = other.max;
+    }
+
+    count += other.count;
+    sum += other.sum;
+}
+
+void TimingHistogram::clear()
+{
+    for (int i = 0; i < TIMING_HISTOGRAM_BUCKETS; i++)
+    {
+        buckets[i] = 0;
+    }
+
+    count = 0;
+    sum = 0.0;
+    min = 0.0;
+    max = 0.0;
+}
+
+/* ************************************************************************** */
+
+uint64_t TimingHistogram::getCount() const
+{
+    return count;
+}
+
+double TimingHistogram::getMean() const
+{
+    return (count > 0) ? (sum / static_cast<double>(count)) : 0.0;
+}
+
+double TimingHistogram::getMin() const
+{
+    return min;
+}
+
+double TimingHistogram::getMax() const
+{
+    return max;
+}
+
+double TimingHistogram::getPercentile(const double percent) const
+{
+    if (count == 0)
+    {
+        return 0.0;
+    }
+
+    // Rank of the duration we are looking for
+    uint64_t rank = static_cast<uint64_t>(std::ceil((percent / 100.0) * static_cast<double>(count)));
+    if (rank < 1)
+    {
+        rank = 1;
+    }
+
+    uint64_t cumul = 0;
+    for (int i = 0; i < TIMING_HISTOGRAM_BUCKETS - 1; i++)
+    {
+        cumul += buckets[i];
+        if (cumul >= rank)
+        {
+            double limit = getBucketLimit(i);
+            return (limit < max) ? limit : max;
+        }
+    }
+
+    return max;
+}
+
+uint32_t TimingHistogram::getBucket(const int index) const
+{
+    if (index < 0 || index >= TIMING_HISTOGRAM_BUCKETS)
+    {
+        return 0;
+    }
+
+    return buckets[index];
+}
+
+double TimingHistogram::getBucketLimit(const int index)
+{
+    if (index <= 0)
+    {
+        return 1.0;
+    }
+    if (index >= TIMING_HISTOGRAM_BUCKETS - 1)
+    {
+        return std::pow(2.0, static_cast<double>(TIMING_HISTOGRAM_BUCKETS - 2) / TIMING_HISTOGRAM_RESOLUTION);
+    }
+
+    return std::pow(2.0, static_cast<double>(index) / TIMING_HISTOGRAM_RESOLUTION);
+}
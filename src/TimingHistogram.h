@@ -0,0 +1,103 @@
+/*!
+ * This file is part of SmartServoFramework.
+ * Copyright (c) 2014, INRIA, All rights reserved.
+ *
+ * SmartServoFramework is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software. If not, see <http://www.gnu.org/licenses/lgpl-3.0.txt>.
+ *
+ * \file TimingHistogram.h
+ * \date 16/10/2026
+ * \author Emeric Grange <emeric.grange@gmail.com>
+ */
+
+#ifndef TIMING_HISTOGRAM_H
+#define TIMING_HISTOGRAM_H
+
+#include <cstdint>
+
+/** \addtogroup ManagedAPIs
+ *  @{
+ */
+
+//! Number of buckets of a timing histogram.
+#define TIMING_HISTOGRAM_BUCKETS    72
+
+//! Number of buckets per octave (each bucket upper bound is ~19% above the previous one).
+#define TIMING_HISTOGRAM_RESOLUTION 4
+
+/*!
+ * \brief The TimingHistogram class, a fixed size histogram of durations.
+ *
+ * Durations are in microseconds. The first bucket holds durations below 1 µs,
+ * then buckets grow geometrically, up to ~185 ms. The last bucket holds
+ * everything above. Adding a duration never allocates, so histograms can be
+ * filled from the synchronization loops, and copied around as snapshots.
+ *
+ * A histogram is not thread safe.
+ */
+class TimingHistogram
+{
+    uint32_t buckets[TIMING_HISTOGRAM_BUCKETS];
+    uint64_t count;
+    double sum;
+    double min;
+    double max;
+
+public:
+    TimingHistogram();
+
+    /*!
+     * \brief Add a duration to the histogram.
+     * \param usec: Duration in microseconds.
+     */
+    void add(const double usec);
+
+    /*!
+     * \brief Add every duration of another histogram to this one.
+     */
+    void merge(const TimingHistogram &other);
+
+    /*!
+     * \brief Remove every duration from the histogram.
+     */
+    void clear();
+
+    uint64_t getCount() const;
+    double getMean() const;
+    double getMin() const;
+    double getMax() const;
+
+    /*!
+     * \brief Get an estimation of a percentile.
+     * \param percent: The percentile to compute, in range [0;100] (ex: 99 for p99).
+     * \return The upper bound of the bucket containing the percentile (limited by the maximum duration), in microseconds. 0 if the histogram is empty.
+     */
+    double getPercentile(const double percent) const;
+
+    /*!
+     * \brief Get the number of durations inside a bucket.
+     * \param index: Bucket index, in range [0;TIMING_HISTOGRAM_BUCKETS-1].
+     */
+    uint32_t getBucket(const int index) const;
+
+    /*!
+     * \brief Get the upper bound of a bucket.
+     * \param index: Bucket index, in range [0;TIMING_HISTOGRAM_BUCKETS-1].
+     * \return The upper bound in microseconds (the last bucket has no upper bound, the value returned is its lower bound).
+     */
+    static double getBucketLimit(const int index);
+};
+
+/** @}*/
+
+#endif // TIMING_HISTOGRAM_H
@@ -395,7 +395,9 @@ enum RegisterNames_e
     REG_REMOCON_TX_DATA_0,
     REG_REMOCON_TX_DATA_1,
     REG_IR_DETECT_COMPARE,
-    REG_LIGHT_DETECT_COMPARE
+    REG_LIGHT_DETECT_COMPARE,
+
+    REGISTER_NAME_COUNT         //!< Number of register names (not a register)
 };
 
 /* ************************************************************************** */
@@ -434,6 +436,22 @@ inline int make_word(const int short_low, const int short_high)
     return ( ((short_high & 0x0000FFFF) << 16) + (short_low & 0x0000FFFF) );
 }
 
+/*!
+ * \brief Assemble 1, 2 or 4 consecutive bytes (little endian) to make a value.
+ * \param bytes: Pointer to the first (or 'low') byte.
+ * \param size: Number of bytes to assemble.
+ * \return Value made from the concatenation of 'size' bytes.
+ */
+inline int make_value(const unsigned char *bytes, const int size)
+{
+    if (size == 4)
+        return make_word(bytes[0], bytes[1], bytes[2], bytes[3]);
+    else if (size == 2)
+        return make_short_word(bytes[0], bytes[1]);
+
+    return static_cast<int>(bytes[0]);
+}
+
 /*!
  * \brief Get the first (or 'low') byte from a regular 32b word.
  * \param word: The word from which to extract the low byte.